@@ -45,6 +45,9 @@ static void *nvtop_reallocarray__(void *ptr, size_t nmemb, size_t size) {
 // 16 has been experimentally selected for being small while avoiding multipe allocations in most common cases
 #define COMMON_PROCESS_LINEAR_REALLOC_INC 16
 
+// Process arrays start at COMMON_PROCESS_LINEAR_REALLOC_INC and double from there
+#define COMMON_PROCESS_GROWN_SIZE(size) ((size) ? 2 * (size) : COMMON_PROCESS_LINEAR_REALLOC_INC)
+
 #define MAX_LINES_PER_PLOT 4
 
 // Helper macro to stringify an integer
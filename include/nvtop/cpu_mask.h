@@ -0,0 +1,48 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CPU_MASK_H__
+#define CPU_MASK_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Set of CPU or NUMA node ids, as listed by the kernel in cpulist format
+#define CPU_MASK_MAX_ID 1024
+
+struct cpu_mask {
+  uint64_t bits[CPU_MASK_MAX_ID / 64];
+};
+
+// Parses a list such as "0-7,16-23"; ids above CPU_MASK_MAX_ID are dropped
+bool cpu_mask_parse_list(const char *list, struct cpu_mask *mask);
+
+inline bool cpu_mask_is_set(const struct cpu_mask *mask, unsigned id) {
+  return id < CPU_MASK_MAX_ID && (mask->bits[id / 64] >> (id % 64)) & 1;
+}
+
+bool cpu_mask_is_empty(const struct cpu_mask *mask);
+
+bool cpu_mask_intersects(const struct cpu_mask *mask1, const struct cpu_mask *mask2);
+
+bool cpu_mask_is_subset(const struct cpu_mask *subset, const struct cpu_mask *set);
+
+#endif // CPU_MASK_H__
@@ -0,0 +1,39 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DEVICE_TOPOLOGY_CACHE_H__
+#define DEVICE_TOPOLOGY_CACHE_H__
+
+#include "nvtop/extract_gpuinfo_common.h"
+
+#include <stdbool.h>
+
+// The devices enumerated by the last run are kept in the user cache directory
+// to lay out the interface before the drivers answer. The key identifies the
+// device selection the topology was enumerated with.
+
+bool device_topology_cache_load(const char *key, unsigned *devices_count, char ***device_names);
+
+void device_topology_cache_save(const char *key, struct list_head *devices);
+
+void device_topology_cache_free_names(unsigned devices_count, char **device_names);
+
+#endif // DEVICE_TOPOLOGY_CACHE_H__
@@ -0,0 +1,67 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef DEVICE_TUNING_H__
+#define DEVICE_TUNING_H__
+
+#include "nvtop/extract_gpuinfo_common.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// The changes made to the tuning knobs of the devices are journaled to be
+// undone in reverse order and logged to $XDG_STATE_HOME/nvtop/tuning.log,
+// defaulting to $HOME/.local/state/nvtop/tuning.log.
+
+bool tuning_supported(const struct gpu_info *device);
+
+void tuning_read(struct gpu_info *device, struct gpuinfo_tuning *tuning);
+
+// Sets the knob, remembering the value it replaces. The knob it requires is
+// set first and restored by the same undo. On failure, *error describes the
+// problem.
+bool tuning_apply(struct gpu_info *device, unsigned device_index, enum gpuinfo_tuning_knob_id knob, int value,
+                  const char **error);
+
+unsigned tuning_changes_count(void);
+
+// Restores the value replaced by the most recent change
+bool tuning_undo(const char **error);
+
+// Forgets the changes, to be called before the devices are released
+void tuning_clear(void);
+
+const char *tuning_knob_name(enum gpuinfo_tuning_knob_id knob);
+
+// Next value of the knob in the given direction, the value itself at the ends
+int tuning_knob_step(const struct gpuinfo_tuning_knob *knob, int value, bool increase);
+
+void tuning_format_value(const struct gpuinfo_tuning_knob *knob, enum gpuinfo_tuning_knob_id id, int value,
+                         char *buffer, size_t size);
+
+// Power profile and performance level of an AMDGPU from its sysfs directory
+void tuning_read_amdgpu_sysfs(int sysfs_dirfd, struct gpuinfo_tuning *tuning);
+
+// Sets errno on failure
+bool tuning_write_amdgpu_sysfs(int sysfs_dirfd, enum gpuinfo_tuning_knob_id knob, int value);
+
+#endif // DEVICE_TUNING_H__
@@ -0,0 +1,55 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DUTY_CYCLE_H__
+#define DUTY_CYCLE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Busy and idle periods of a GPU or of a process, built from utilization
+// samples. The length of each idle period goes to a histogram of power of two
+// milliseconds buckets, which are halved once full for the recent activity
+// to prevail.
+
+#define DUTY_CYCLE_BUCKETS 20
+
+struct duty_cycle_histogram {
+  unsigned count;
+  unsigned buckets[DUTY_CYCLE_BUCKETS]; // [2^k, 2^(k+1)) ms, [0, 2) ms for the first one
+};
+
+struct duty_cycle {
+  bool sampling;
+  bool busy;            // State of the current period
+  bool period_known;    // The current period started after the first sample
+  uint64_t last_sample; // Nanoseconds
+  uint64_t period;      // Nanoseconds spent in the current period
+  struct duty_cycle_histogram gaps;
+};
+
+// The sample covers the time elapsed since the previous one
+void duty_cycle_add_sample(struct duty_cycle *cycle, uint64_t timestamp, bool busy);
+
+// Median and 95th percentile in seconds, false until a period ended
+bool duty_cycle_percentiles(const struct duty_cycle_histogram *histogram, double *median, double *p95);
+
+#endif // DUTY_CYCLE_H__
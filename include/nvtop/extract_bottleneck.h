@@ -0,0 +1,58 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef EXTRACT_BOTTLENECK_H__
+#define EXTRACT_BOTTLENECK_H__
+
+#include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/process_table.h"
+
+// Sliding window of the metrics telling what holds a process back: its GPU
+// usage, its busiest thread, the I/O pressure of its cgroup and the memory
+// bandwidth it uses (or the device one when unknown).
+
+#define BOTTLENECK_WINDOW 10
+
+struct bottleneck_metric {
+  bool valid[BOTTLENECK_WINDOW];
+  double values[BOTTLENECK_WINDOW];
+  double sum;
+  unsigned valid_count;
+};
+
+struct bottleneck_window {
+  unsigned count;
+  unsigned next;
+  struct bottleneck_metric gpu_usage;
+  struct bottleneck_metric hot_thread;
+  struct bottleneck_metric io_pressure;
+  struct bottleneck_metric memory_bandwidth;
+};
+
+// Adds the metrics of the table row of the process, once its derived columns are set
+void bottleneck_window_add(struct bottleneck_window *window, const struct gpu_info *device,
+                           const struct gpuinfo_process_table *table, unsigned row);
+
+// False until the window holds enough refreshes with a GPU usage
+bool bottleneck_window_classify(const struct bottleneck_window *window, enum gpuinfo_bottleneck *bottleneck);
+
+#endif // EXTRACT_BOTTLENECK_H__
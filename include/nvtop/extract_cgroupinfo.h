@@ -0,0 +1,73 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef EXTRACT_CGROUPINFO_H__
+#define EXTRACT_CGROUPINFO_H__
+
+#include "nvtop/extract_gpuinfo_common.h"
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#define SET_CGROUPINFO(structPtr, field, value) SET_VALUE(structPtr, field, value, cgroupinfo_)
+#define CGROUPINFO_FIELD_VALID(structPtr, field) VALUE_IS_VALID(structPtr, field, cgroupinfo_)
+enum cgroupinfo_valid {
+  cgroupinfo_cpu_pressure_valid,
+  cgroupinfo_memory_pressure_valid,
+  cgroupinfo_io_pressure_valid,
+  cgroupinfo_cpu_throttled_valid,
+  cgroupinfo_info_count
+};
+
+// Resource pressure of a cgroup v2
+struct cgroup_info {
+  char *path;             // Relative to the cgroup2 mount point
+  double cpu_pressure;    // Share of the last 10s some tasks stalled on CPU (%)
+  double memory_pressure; // Share of the last 10s some tasks stalled on memory (%)
+  double io_pressure;     // Share of the last 10s some tasks stalled on I/O (%)
+  double cpu_throttled;   // Share of the last refresh spent throttled by cpu.max (%)
+  unsigned char valid[(cgroupinfo_info_count + CHAR_BIT - 1) / CHAR_BIT];
+};
+
+// Where the cgroup v2 hierarchy is mounted, NULL if it is not
+const char *cgroupinfo_mount_point(void);
+
+// The cgroup files are read at most once between these two calls, however many
+// processes share the cgroup. Processes and cgroups left unused in between are
+// forgotten by cgroupinfo_end_refresh.
+void cgroupinfo_begin_refresh(void);
+
+void cgroupinfo_end_refresh(void);
+
+// The cgroup of a process is resolved once per (pid, start_time). Returns NULL
+// if the process is not in a cgroup v2 hierarchy. Valid until the next
+// cgroupinfo_end_refresh.
+const struct cgroup_info *cgroupinfo_of_process(pid_t pid, unsigned long long start_time);
+
+// Writes the cpu.max of the cgroup of the process, limiting it to the time
+// of that many CPUs (0 for no limit). Returns 0 or an errno value, EPERM when
+// the cgroup is a login session, a systemd slice or has child cgroups.
+int cgroupinfo_set_cpu_quota(pid_t pid, unsigned cpus);
+
+void cgroupinfo_clear(void);
+
+#endif // EXTRACT_CGROUPINFO_H__
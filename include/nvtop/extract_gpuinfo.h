@@ -23,10 +23,27 @@
 #define EXTRACT_GPUINFO_H_
 
 #include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/process_table.h"
 
 #include <stdbool.h>
 
-bool gpuinfo_init_info_extraction(ssize_t mask, unsigned *devices_count, struct list_head *devices);
+bool gpuinfo_init_info_extraction(struct gpuinfo_device_mask *mask, unsigned *devices_count,
+                                  struct list_head *devices);
+
+// Starts the vendor initialization on background threads. The mask must stay
+// valid until gpuinfo_init_info_extraction_collect reports completion.
+bool gpuinfo_init_info_extraction_start(struct gpuinfo_device_mask *mask);
+
+// Waits up to timeout_ms (0: no wait, negative: no limit) for the vendors
+// still initializing, then appends the devices of those ready, in vendor order,
+// with their static information populated. Each new device replaces one
+// placeholder. Returns true once every vendor is done.
+bool gpuinfo_init_info_extraction_collect(int timeout_ms, unsigned *devices_count, struct list_head *devices);
+
+// Placeholder devices only have a name and are ignored by the vendors
+void gpuinfo_add_placeholder_devices(unsigned count, char *const names[], struct list_head *devices);
+
+bool gpuinfo_is_placeholder_device(const struct gpu_info *device);
 
 bool gpuinfo_shutdown_info_extraction(struct list_head *devices);
 
@@ -34,10 +51,51 @@ bool gpuinfo_populate_static_infos(struct list_head *devices);
 
 bool gpuinfo_refresh_dynamic_info(struct list_head *devices);
 
+// Reads the device metrics again between two refreshes, leaving the
+// statistics accumulated at each refresh untouched
+bool gpuinfo_sample_dynamic_info(struct list_head *devices);
+
 bool gpuinfo_fix_dynamic_info_from_process_info(struct list_head *devices);
 
+// Time left before the device memory is full at the pace at which it has been
+// filling up over the last minutes. False when it is not filling up.
+bool gpuinfo_time_to_full_memory(const struct gpu_info *device, double *seconds);
+
 bool gpuinfo_refresh_processes(struct list_head *devices);
 
+// Threads are only measured for the process pid, or for every process
+void gpuinfo_set_thread_breakdown(pid_t pid, bool all_processes);
+
+// Process information that costs extra reads, only gathered when requested
+enum gpuinfo_optional_process_info {
+  gpuinfo_optional_io = 1 << 0,
+  gpuinfo_optional_cgroup = 1 << 1,
+  gpuinfo_optional_numa = 1 << 2,
+  gpuinfo_optional_descendants = 1 << 3, // Roll up the descendants of each process
+  gpuinfo_optional_stragglers = 1 << 4,  // Compare the ranks of distributed jobs
+  gpuinfo_optional_bottleneck = 1 << 5,  // Classify the processes, measures the threads of all of them
+};
+
+void gpuinfo_set_optional_process_info(unsigned info_mask);
+
+// Length in seconds of the window over which the GPU time of the processes
+// is summed, at most GPU_TIME_SHARE_MAX_WINDOW
+void gpuinfo_set_time_share_window(unsigned seconds);
+
+// GPU usage (%) under which the memory held on a device or by a process is
+// idle, 0 disables the detection
+void gpuinfo_set_stranded_threshold(unsigned percent);
+
+bool gpuinfo_process_exits_watched(void);
+
+// Waits up to timeout_ms for input_fd to be readable or for GPU processes to
+// exit. The exited processes are removed from the devices and the process
+// table, in which case true is returned.
+bool gpuinfo_wait_process_exits(struct list_head *devices, int input_fd, int timeout_ms);
+
+// Processes of all the devices as of the last gpuinfo_refresh_processes
+const struct gpuinfo_process_table *gpuinfo_get_process_table(void);
+
 void gpuinfo_clean(struct list_head *devices);
 
 void gpuinfo_clear_cache(void);
@@ -29,6 +29,10 @@
 #include <sys/types.h>
 
 #include "list.h"
+#include "nvtop/cpu_mask.h"
+#include "nvtop/duty_cycle.h"
+#include "nvtop/memory_trend.h"
+#include "nvtop/stranded.h"
 
 #define IS_VALID(x, y) ((y)[(x) / CHAR_BIT] & (1 << ((x) % CHAR_BIT)))
 #define SET_VALID(x, y) ((y)[(x) / CHAR_BIT] |= (1 << ((x) % CHAR_BIT)))
@@ -55,10 +59,14 @@ enum gpuinfo_static_info_valid {
   gpuinfo_max_pcie_link_width_valid,
   gpuinfo_temperature_shutdown_threshold_valid,
   gpuinfo_temperature_slowdown_threshold_valid,
+  gpuinfo_numa_node_valid,
+  gpuinfo_local_cpus_valid,
+  gpuinfo_pdev_valid,
   gpuinfo_static_info_count,
 };
 
 #define MAX_DEVICE_NAME 128
+#define MAX_PDEV_NAME 20
 
 struct gpuinfo_static_info {
   char device_name[MAX_DEVICE_NAME];
@@ -66,6 +74,9 @@ struct gpuinfo_static_info {
   unsigned max_pcie_link_width;
   unsigned temperature_shutdown_threshold;
   unsigned temperature_slowdown_threshold;
+  unsigned numa_node;           // NUMA node the device is attached to
+  struct cpu_mask local_cpus;   // CPUs of the socket the device is attached to
+  char pdev[MAX_PDEV_NAME];     // PCI address (domain:bus:device.function)
   unsigned char valid[(gpuinfo_static_info_count + CHAR_BIT - 1) / CHAR_BIT];
 };
 
@@ -92,6 +103,7 @@ enum gpuinfo_dynamic_info_valid {
   gpuinfo_gpu_temp_valid,
   gpuinfo_power_draw_valid,
   gpuinfo_power_draw_max_valid,
+  gpuinfo_mem_bandwidth_rate_valid,
   gpuinfo_dynamic_info_count,
 };
 
@@ -115,9 +127,29 @@ struct gpuinfo_dynamic_info {
   unsigned int gpu_temp;             // GPU temperature °celsius
   unsigned int power_draw;           // Power usage in milliwatts
   unsigned int power_draw_max;       // Max power usage in milliwatts
+  unsigned int mem_bandwidth_rate;   // Time the memory was read or written in %
   unsigned char valid[(gpuinfo_dynamic_info_count + CHAR_BIT - 1) / CHAR_BIT];
 };
 
+#define GPUINFO_TOP_THREADS 3
+#define GPUINFO_THREAD_NAME_SIZE 16
+
+// Busiest threads of a process, by decreasing CPU usage
+struct gpuinfo_top_threads {
+  unsigned count;
+  struct {
+    char name[GPUINFO_THREAD_NAME_SIZE];
+    unsigned cpu_usage; // Percentage of one CPU
+  } threads[GPUINFO_TOP_THREADS];
+};
+
+// Where the process may run and allocate relative to the device NUMA node
+enum gpuinfo_numa_placement {
+  gpuinfo_numa_local,  // Confined to the node of the device
+  gpuinfo_numa_spread, // Allowed on the node of the device and on others
+  gpuinfo_numa_remote, // Confined away from the node of the device
+};
+
 enum gpu_process_type {
   gpu_process_graphical,
   gpu_process_compute,
@@ -142,9 +174,46 @@ enum gpuinfo_process_info_valid {
   gpuinfo_process_cpu_usage_valid,
   gpuinfo_process_cpu_memory_virt_valid,
   gpuinfo_process_cpu_memory_res_valid,
+  gpuinfo_process_memory_bandwidth_usage_valid,
+  // Derived by the collection, only stored in the process table
+  gpuinfo_process_energy_consumed_valid,
+  gpuinfo_process_power_draw_valid,
+  gpuinfo_process_top_threads_valid,
+  gpuinfo_process_io_read_rate_valid,
+  gpuinfo_process_io_write_rate_valid,
+  gpuinfo_process_cgroup_valid,
+  gpuinfo_process_cpu_pressure_valid,
+  gpuinfo_process_memory_pressure_valid,
+  gpuinfo_process_io_pressure_valid,
+  gpuinfo_process_cpu_throttled_valid,
+  gpuinfo_process_numa_placement_valid,
+  gpuinfo_process_descendants_valid,
+  gpuinfo_process_straggler_valid,
+  gpuinfo_process_gpu_time_share_valid,
+  gpuinfo_process_idle_gaps_valid,
+  gpuinfo_process_gpu_memory_growth_valid,
+  gpuinfo_process_bottleneck_valid,
+  gpuinfo_process_stranded_time_valid,
+  gpuinfo_process_idle_energy_valid,
   gpuinfo_process_info_count
 };
 
+// What holds a process back, judged over its last refreshes
+enum gpuinfo_bottleneck {
+  gpuinfo_bottleneck_gpu,     // The GPU is kept busy
+  gpuinfo_bottleneck_memory,  // Memory bandwidth saturated while the SMs are not
+  gpuinfo_bottleneck_cpu,     // GPU starved by a single saturated CPU thread
+  gpuinfo_bottleneck_io,      // GPU starved while the cgroup stalls on I/O
+  gpuinfo_bottleneck_unclear, // None of the above
+  gpuinfo_bottleneck_count,
+};
+
+// Length in seconds of the periods during which a process left the GPU idle
+struct gpuinfo_idle_gaps {
+  double median;
+  double p95;
+};
+
 struct gpu_process {
   enum gpu_process_type type;
   pid_t pid;                           // Process ID
@@ -163,11 +232,95 @@ struct gpu_process {
   unsigned cpu_usage;
   unsigned long cpu_memory_virt;
   unsigned long cpu_memory_res;
+  unsigned memory_bandwidth_usage;     // Percentage of the device memory bandwidth used by the process
   unsigned char valid[(gpuinfo_process_info_count + CHAR_BIT - 1) / CHAR_BIT];
 };
 
+// Set of the devices to monitor, indexed in the order in which the vendors
+// enumerate them. The devices past the stored words follow select_by_default.
+struct gpuinfo_device_mask {
+  bool select_by_default;
+  unsigned words_count;
+  uint64_t *words;
+  unsigned next_device; // Enumeration index of the next device handed out
+};
+
+void gpuinfo_device_mask_init(struct gpuinfo_device_mask *mask,
+                              bool select_by_default);
+
+void gpuinfo_device_mask_free(struct gpuinfo_device_mask *mask);
+
+void gpuinfo_device_mask_set(struct gpuinfo_device_mask *mask,
+                             unsigned device_id, bool selected);
+
+bool gpuinfo_device_mask_isset(const struct gpuinfo_device_mask *mask,
+                               unsigned device_id);
+
+// Tells whether the next device enumerated by a vendor should be monitored
+bool gpuinfo_device_mask_select_next(struct gpuinfo_device_mask *mask);
+
+// Device energy integrated over the power_draw samples
+struct gpuinfo_energy_counter {
+  bool sampling;              // last_power_draw holds the previous sample
+  unsigned last_power_draw;   // Power usage in milliwatts
+  uint64_t last_sample;       // Time of the previous sample in nanoseconds
+  double consumed;            // Joules since monitoring started
+  double attributed;          // Value of consumed at the last process refresh
+};
+
+#define GPU_TIME_SHARE_MAX_WINDOW 60
+
+// Seconds accumulated during each of the last seconds, indexed by the
+// monotonic clock second modulo the window
+struct gpu_time_window {
+  uint64_t last_second;
+  double busy_time[GPU_TIME_SHARE_MAX_WINDOW];
+};
+
+// Time during which the processes of a device were time-sliced over the time
+// share window. The engine is considered time-sliced over a refresh interval
+// when it was saturated while more than one process got GPU time: the
+// overlap is only known at the refresh granularity.
+struct gpuinfo_time_share {
+  bool valid;
+  uint64_t since;                 // Start of the accounting of the device in nanoseconds
+  double window;                  // Seconds covered
+  double sliced;                  // Seconds time-sliced within the window
+  struct gpu_time_window history; // Seconds time-sliced during each second
+};
+
 struct gpu_info;
 
+enum gpuinfo_tuning_knob_id {
+  gpuinfo_tuning_power_limit,        // Milliwatts
+  gpuinfo_tuning_locked_gpu_clock,   // MHz, 0 when not locked
+  gpuinfo_tuning_applications_clock, // Graphics MHz, 0 for the default
+  gpuinfo_tuning_power_profile,      // Profile number
+  gpuinfo_tuning_performance_level,  // One of the choice values
+  gpuinfo_tuning_knob_count,
+};
+
+#define GPUINFO_TUNING_MAX_CHOICES 32
+#define GPUINFO_TUNING_CHOICE_NAME_SIZE 24
+
+// A knob takes any value of [minimum, maximum] by steps, or one of its choices.
+// Some only take effect once another knob is set to a given value.
+struct gpuinfo_tuning_knob {
+  bool available;
+  int value;
+  int minimum, maximum, step;
+  unsigned choices_count;
+  int choice_values[GPUINFO_TUNING_MAX_CHOICES];
+  char choice_names[GPUINFO_TUNING_MAX_CHOICES][GPUINFO_TUNING_CHOICE_NAME_SIZE];
+  bool has_requirement;
+  enum gpuinfo_tuning_knob_id required_knob;
+  int required_value;
+};
+
+struct gpuinfo_tuning {
+  struct gpuinfo_tuning_knob knobs[gpuinfo_tuning_knob_count];
+};
+
 struct gpu_vendor {
   struct list_head list;
 
@@ -177,12 +330,19 @@ struct gpu_vendor {
   const char *(*last_error_string)(void);
 
   bool (*get_device_handles)(struct list_head *devices, unsigned *count,
-                             ssize_t *mask);
+                             struct gpuinfo_device_mask *mask);
 
   void (*populate_static_info)(struct gpu_info *gpu_info);
   void (*refresh_dynamic_info)(struct gpu_info *gpu_info);
 
   void (*refresh_running_processes)(struct gpu_info *gpu_info);
+
+  // Optional, NULL when the vendor has no tuning knobs
+  void (*get_tuning)(struct gpu_info *gpu_info, struct gpuinfo_tuning *tuning);
+  bool (*set_tuning)(struct gpu_info *gpu_info, enum gpuinfo_tuning_knob_id knob, int value);
+
+  // Set while init runs on a background thread, which can outlive a shutdown
+  bool init_in_flight;
 };
 
 struct gpu_info {
@@ -190,6 +350,12 @@ struct gpu_info {
   struct gpu_vendor *vendor;
   struct gpuinfo_static_info static_info;
   struct gpuinfo_dynamic_info dynamic_info;
+  struct gpuinfo_energy_counter energy;
+  struct gpuinfo_time_share time_share;
+  struct duty_cycle duty_cycle;
+  bool duty_cycle_sampled;             // Fed by the vendor from samples finer than the refresh rate
+  struct memory_trend free_memory_trend;
+  struct gpuinfo_stranded stranded;
   unsigned processes_count;
   struct gpu_process *processes;
   unsigned processes_array_size;
@@ -197,4 +363,7 @@ struct gpu_info {
 
 void register_gpu_vendor(struct gpu_vendor *vendor);
 
+// Reads numa_node and local_cpulist from the sysfs directory of a PCI device
+void gpuinfo_read_pci_numa_info(int pci_device_dirfd, struct gpuinfo_static_info *static_info);
+
 #endif // EXTRACT_GPUINFO_COMMON_H__
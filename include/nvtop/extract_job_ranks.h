@@ -0,0 +1,44 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef EXTRACT_JOB_RANKS_H__
+#define EXTRACT_JOB_RANKS_H__
+
+#include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/process_table.h"
+
+// The ranks of a distributed job run the same command, modulo their rank
+// arguments, from the same cgroup (or the same parent when the cgroups are
+// unknown) on different devices. The job goes at the pace of its slowest rank,
+// which shows as a utilization or a power draw persistently below the others.
+
+// The ranks are the rows of the table, which must not change until the end of
+// the refresh
+void jobranks_begin_refresh(struct gpuinfo_process_table *table);
+
+void jobranks_add_process(const struct gpu_info *device, unsigned row, pid_t parent_pid);
+
+// Updates the sliding window of every rank and flags the stragglers in the table
+void jobranks_end_refresh(void);
+
+void jobranks_clear(void);
+
+#endif // EXTRACT_JOB_RANKS_H__
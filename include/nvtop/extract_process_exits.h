@@ -0,0 +1,47 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef EXTRACT_PROCESS_EXITS_H__
+#define EXTRACT_PROCESS_EXITS_H__
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+// A pidfd is held for each GPU process so that its exit is noticed as soon as
+// it happens instead of at the next sweep. Without pidfd support (Linux < 5.3)
+// nothing is watched and the exits are left to the sweeps.
+
+void process_exits_track(pid_t pid);
+
+// Releases the pidfds of the processes not tracked since the previous call
+void process_exits_end_refresh(void);
+
+bool process_exits_watched(void);
+
+// Waits up to timeout_ms for input_fd to be readable or for tracked processes
+// to exit. Returns the number of processes that exited, whose pids are stored
+// in *exited until the next call. They are not tracked any more.
+unsigned process_exits_wait(int input_fd, int timeout_ms, const pid_t **exited);
+
+void process_exits_clear(void);
+
+#endif // EXTRACT_PROCESS_EXITS_H__
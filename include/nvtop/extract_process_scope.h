@@ -0,0 +1,50 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef EXTRACT_PROCESS_SCOPE_H__
+#define EXTRACT_PROCESS_SCOPE_H__
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+// Restricts the process collection to one job: the members of a cgroup v2
+// subtree or a process with its descendants. Every process is collected
+// while no scope is set.
+
+// The path is either absolute or relative to the cgroup2 mount point. Returns
+// false if it is not a cgroup v2 directory.
+bool process_scope_set_cgroup(const char *path);
+
+void process_scope_set_pid_tree(pid_t root);
+
+bool process_scope_active(void);
+
+// Gathers the pids of the scope, once per process refresh
+void process_scope_refresh(void);
+
+// Pids of the scope as of the last refresh, in increasing order
+const pid_t *process_scope_pids(unsigned *count);
+
+bool process_scope_contains(pid_t pid);
+
+void process_scope_clear(void);
+
+#endif // EXTRACT_PROCESS_SCOPE_H__
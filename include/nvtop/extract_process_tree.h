@@ -0,0 +1,52 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef EXTRACT_PROCESS_TREE_H__
+#define EXTRACT_PROCESS_TREE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+// Usage of the descendants of a GPU process, e.g., the data loader workers of
+// a training job, which do not use the GPU themselves
+struct process_tree_usage {
+  unsigned descendants_count;
+  double cpu_usage;       // Percent of one core, summed over the descendants
+  size_t resident_memory; // Bytes
+  bool io_rates_valid;
+  unsigned long long io_read_rate, io_write_rate; // Bytes per second
+};
+
+// The descendants are tracked from one refresh to the next. New ones are found
+// through the children of the tracked processes and the ones not met again
+// before process_tree_end_refresh are forgotten.
+void process_tree_begin_refresh(bool with_io);
+
+// Descendants for which has_own_row returns true are left out along with
+// their subtree, they are accounted for on their own row
+bool process_tree_descendants_usage(pid_t root, bool (*has_own_row)(pid_t pid), struct process_tree_usage *usage);
+
+void process_tree_end_refresh(void);
+
+void process_tree_clear(void);
+
+#endif // EXTRACT_PROCESS_TREE_H__
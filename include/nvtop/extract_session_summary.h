@@ -0,0 +1,61 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef EXTRACT_SESSION_SUMMARY_H__
+#define EXTRACT_SESSION_SUMMARY_H__
+
+#include "nvtop/extract_gpuinfo_common.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Aggregates of the whole monitoring session, updated at each refresh so that
+// the final report needs no history. Nothing is recorded until enabled.
+
+void session_summary_enable(void);
+
+bool session_summary_enabled(void);
+
+// Called after each refresh of the devices, processes included
+void session_summary_record_devices(struct list_head *devices);
+
+void session_summary_begin_process_refresh(void);
+
+// Called once per process and device, with the GPU seconds used since the
+// previous refresh. The processes are told apart by their pid and start time
+// (zero when unknown) so that a reused pid starts a new summary.
+void session_summary_record_process(const struct gpu_process *process, unsigned long long start_time,
+                                    double busy_time);
+
+// Idle period of a process on one device, with the Joules it was charged
+// since the previous refresh when the device power draw is known
+void session_summary_record_stranded(pid_t pid, unsigned long long start_time,
+                                     const struct gpuinfo_stranded *stranded, bool energy_valid, double energy);
+
+// The lifetime of the process ends now rather than at its last refresh
+void session_summary_process_exited(pid_t pid, unsigned long long start_time);
+
+void session_summary_report(FILE *output);
+
+void session_summary_clear(void);
+
+#endif // EXTRACT_SESSION_SUMMARY_H__
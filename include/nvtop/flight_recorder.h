@@ -0,0 +1,58 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef FLIGHT_RECORDER_H__
+#define FLIGHT_RECORDER_H__
+
+#include "list.h"
+
+#include <stdbool.h>
+
+// Keeps the last seconds of device snapshots in a ring sized for the devices
+// monitored. When a trigger fires, the devices are sampled every
+// FLIGHT_RECORDER_BURST_INTERVAL for as many seconds again, then both windows
+// are appended to the trace file.
+//
+// The triggers are a comma separated list of [device:]field op value, e.g.,
+// "gpu_util<10, temperature>=85, 1:power>300", with op one of <, <=, >, >=.
+// A trigger fires when its condition starts to hold on a device.
+
+#define FLIGHT_RECORDER_BURST_INTERVAL 100 // Milliseconds
+
+// Returns false with a description of the problem in *error when the triggers
+// do not parse. A NULL or empty trigger list disables the recorder.
+bool flight_recorder_configure(const char *triggers, const char *trace_file, unsigned seconds,
+                               const char **error);
+
+// Sizes the ring for the devices, keeping the snapshots already recorded
+void flight_recorder_set_devices_count(unsigned devices_count);
+
+// While capturing, the devices are to be sampled every
+// FLIGHT_RECORDER_BURST_INTERVAL rather than at each refresh
+bool flight_recorder_capturing(void);
+
+void flight_recorder_tick(struct list_head *devices);
+
+// Writes the incident being captured, if any, and releases the recorder
+void flight_recorder_clear(void);
+
+#endif // FLIGHT_RECORDER_H__
@@ -26,6 +26,7 @@
 #include <stdbool.h>
 #include <sys/types.h>
 
+#include "nvtop/cpu_mask.h"
 #include "nvtop/time.h"
 
 struct process_cpu_usage {
@@ -33,6 +34,28 @@ struct process_cpu_usage {
   double total_kernel_time; // Seconds
   size_t virtual_memory;    // Bytes
   size_t resident_memory;   // Bytes
+  unsigned num_threads;
+  pid_t parent_pid;
+  unsigned long long start_time; // Clock ticks after boot, tells reused pids apart
+  nvtop_time timestamp;
+};
+
+struct process_io_usage {
+  unsigned long long read_bytes;  // Bytes read through system calls
+  unsigned long long write_bytes; // Bytes written through system calls
+  nvtop_time timestamp;
+};
+
+struct process_affinity {
+  struct cpu_mask cpus_allowed; // CPUs the process may be scheduled on
+  struct cpu_mask mems_allowed; // NUMA nodes the process may allocate from
+};
+
+#define THREAD_NAME_SIZE 16 // TASK_COMM_LEN
+
+struct thread_cpu_usage {
+  char name[THREAD_NAME_SIZE];
+  double total_time; // User and kernel time in seconds
   nvtop_time timestamp;
 };
 
@@ -42,4 +65,17 @@ void get_command_from_pid(pid_t pid, char **buffer);
 
 bool get_process_info(pid_t pid, struct process_cpu_usage *usage);
 
+bool get_process_io(pid_t pid, struct process_io_usage *usage);
+
+bool get_process_affinity(pid_t pid, struct process_affinity *affinity);
+
+// Lists the thread ids of the process into the growable array *tids
+bool get_process_thread_ids(pid_t pid, unsigned *count, unsigned *capacity, pid_t **tids);
+
+// Appends the children forked by every thread of the process to the growable
+// array *children
+bool get_process_children(pid_t pid, unsigned *count, unsigned *capacity, pid_t **children);
+
+bool get_thread_info(pid_t pid, pid_t tid, struct thread_cpu_usage *usage);
+
 #endif // GET_PROCESS_INFO_H_
@@ -34,6 +34,11 @@ struct nvtop_interface *initialize_curses(unsigned num_devices,
 
 void clean_ncurses(struct nvtop_interface *interface);
 
+// Same as clean_ncurses but hands the options over to the caller, to build the
+// interface again without reloading the configuration file
+void clean_ncurses_keep_options(struct nvtop_interface *interface,
+                                nvtop_interface_option *options);
+
 void draw_gpu_info_ncurses(unsigned devices_count, struct list_head *devices,
                            struct nvtop_interface *interface);
 
@@ -50,4 +55,8 @@ bool interface_freeze_processes(struct nvtop_interface *interface);
 
 int interface_update_interval(const struct nvtop_interface *interface);
 
+// Reports a problem to the user on the shortcut line, until a key is pressed
+void interface_show_message(struct nvtop_interface *interface,
+                            const char *message);
+
 #endif // INTERFACE_H_
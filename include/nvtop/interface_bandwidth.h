@@ -0,0 +1,77 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef INTERFACE_BANDWIDTH_H__
+#define INTERFACE_BANDWIDTH_H__
+
+#include "nvtop/time.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Rendering steps given up, in that order, while the terminal output stays
+// above the byte budget. The device header and the selected process rows are
+// always kept up to date.
+enum bandwidth_degradation {
+  bandwidth_full_rendering,  // Everything is redrawn every frame
+  bandwidth_sparse_plots,    // Plots are redrawn every few frames
+  bandwidth_frozen_plots,    // Plots are frozen, process list redrawn every few frames
+  bandwidth_monochrome,      // Colors are dropped on top of that
+  bandwidth_degradation_count,
+};
+
+struct interface_bandwidth {
+  uint64_t budget;                   // Bytes per second allowed (0 = unlimited)
+  int self_io;                       // /proc/thread-self/io to account for the bytes written
+  uint64_t frame_start_bytes;        // Write counter when the current frame started
+  double credit;                     // Token bucket (in bytes) refilled at budget rate
+  nvtop_time last_frame;             // Time at which the credit was last refilled
+  nvtop_time throughput_window;      // Start of the throughput measurement window
+  uint64_t throughput_window_bytes;  // Bytes written since throughput_window
+  double throughput;                 // Bytes per second measured over the last window
+  double round_trip_ms;              // Terminal round-trip time, negative if unknown
+  enum bandwidth_degradation level;  // Current degradation step
+  unsigned frames_under_budget;      // Consecutive frames that left credit available
+  unsigned frame_count;              // Frames drawn since the start
+  bool redraw_plots;                 // Plots must be redrawn regardless of the budget
+  bool redraw_processes;             // Process list must be redrawn regardless of the budget
+  bool monochrome_applied;           // Color pairs currently mapped to the default colors
+};
+
+void bandwidth_init(struct interface_bandwidth *bw, unsigned budget_kib);
+
+void bandwidth_set_budget(struct interface_bandwidth *bw, unsigned budget_kib);
+
+void bandwidth_free(struct interface_bandwidth *bw);
+
+inline bool bandwidth_limited(const struct interface_bandwidth *bw) { return bw->budget > 0 && bw->self_io >= 0; }
+
+double bandwidth_measure_round_trip(struct interface_bandwidth *bw, int input_fd, int output_fd, int timeout_ms);
+
+bool bandwidth_frame_begin(struct interface_bandwidth *bw);
+
+bool bandwidth_plots_due(const struct interface_bandwidth *bw);
+
+bool bandwidth_processes_due(const struct interface_bandwidth *bw);
+
+void bandwidth_frame_end(struct interface_bandwidth *bw);
+
+#endif // INTERFACE_BANDWIDTH_H__
@@ -48,6 +48,20 @@ enum process_field {
   process_memory,
   process_cpu_usage,
   process_cpu_mem_usage,
+  process_energy,
+  process_perf_per_watt,
+  process_top_threads,
+  process_io_read,
+  process_io_write,
+  process_cgroup,
+  process_pressure,
+  process_cpu_throttled,
+  process_numa,
+  process_time_share,
+  process_idle_gaps,
+  process_memory_growth,
+  process_bottleneck,
+  process_stranded,
   process_command,
   process_field_count,
 };
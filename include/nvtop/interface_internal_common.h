@@ -23,8 +23,11 @@
 #define INTERFACE_INTERNAL_COMMON_H__
 
 #include "nvtop/common.h"
+#include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/interface_bandwidth.h"
 #include "nvtop/interface_layout_selection.h"
 #include "nvtop/interface_options.h"
+#include "nvtop/interface_process_groups.h"
 #include "nvtop/interface_ring_buffer.h"
 #include "nvtop/time.h"
 
@@ -38,6 +41,8 @@ enum nvtop_option_window_state {
   nvtop_option_state_hidden,
   nvtop_option_state_kill,
   nvtop_option_state_sort_by,
+  nvtop_option_state_tune,
+  nvtop_option_state_actions,
 };
 
 enum interface_color {
@@ -65,6 +70,7 @@ struct device_window {
   WINDOW *gpu_clock_info;
   WINDOW *mem_clock_info;
   WINDOW *pcie_info;
+  WINDOW *grid_line; // Grid view summary, NULL when off screen
   bool enc_was_visible;
   bool dec_was_visible;
   nvtop_time last_decode_seen;
@@ -80,6 +86,11 @@ struct option_window {
   WINDOW *option_win;
 };
 
+struct process_action_target {
+  pid_t pid;
+  unsigned gpu_id;
+};
+
 struct process_window {
   unsigned offset;
   unsigned offset_column;
@@ -88,6 +99,17 @@ struct process_window {
   unsigned selected_row;
   pid_t selected_pid;
   struct option_window option_window;
+  unsigned *sorted_rows; // Process table rows in display order; when grouped,
+                         // table count + g stands for the header of group g
+  unsigned sorted_rows_capacity;
+  struct process_groups groups;
+  int selected_group; // Group of the selected header, -1 on a process
+  unsigned pending_action; // Applied at the next draw, 0 for none
+  unsigned confirm_action; // Group action waiting for a second Enter, 0 for none
+  struct process_action_target *action_targets;
+  unsigned action_targets_count;
+  unsigned action_targets_capacity;
+  char action_message[32];  // Outcome of the last action
 };
 
 struct plot_window {
@@ -119,16 +141,34 @@ struct setup_window {
 };
 
 // Keep gpu information every 1 second for 10 minutes
+struct tuning_window {
+  unsigned device_index;       // Device being tuned
+  struct gpu_info *device;     // Resolved from device_index at each draw
+  struct gpuinfo_tuning tuning;
+  bool stale;                  // The knobs are read again at the next draw
+  unsigned selected_row;       // Knobs available, then the undo row
+  int pending[gpuinfo_tuning_knob_count]; // Values picked with +/-
+  bool pending_set[gpuinfo_tuning_knob_count];
+  bool confirming;             // Enter pressed once on the selected row
+  char message[128];           // Outcome of the last action
+};
+
 struct nvtop_interface {
   nvtop_interface_option options;
   unsigned devices_count;
+  bool grid_view; // One line per device instead of the full header
   struct device_window *devices_win;
   struct process_window process;
   WINDOW *shortcut_window;
   unsigned num_plots;
   struct plot_window *plots;
   interface_ring_buffer saved_data_ring;
+  interface_ring_buffer grid_history; // GPU utilization for the grid sparklines
   struct setup_window setup_win;
+  struct tuning_window tuning_win;
+  struct interface_bandwidth bandwidth;
+  char message[128]; // Shown over the shortcuts until the next key
+  bool shortcuts_stale; // The message was cleared from the shortcut line
 };
 
 enum device_field {
@@ -20,4 +20,7 @@ void compute_sizes_from_layout(unsigned devices_count, unsigned device_header_ro
                                struct window_position plot_positions[MAX_CHARTS], unsigned *map_device_to_plot,
                                struct window_position *process_position, struct window_position *setup_position);
 
+// The solutions of compute_sizes_from_layout are memoized, this releases them
+void layout_selection_clear_cache(void);
+
 #endif // INTERFACE_LAYOUT_SELECTION_H__
@@ -33,6 +33,10 @@ typedef struct nvtop_interface_option_struct {
                                   // hiding it
   bool temperature_in_fahrenheit; // Switch from celsius to fahrenheit
   // temperature scale
+  bool device_grid_view;          // One line per device instead of the full
+                                  // device header
+  unsigned memory_full_horizon;   // Minutes under which a device memory
+                                  // filling up is flagged
   bool use_color;                    // Name self explanatory
   double encode_decode_hiding_timer; // Negative to always display, positive
   plot_info_to_draw
@@ -46,6 +50,23 @@ typedef struct nvtop_interface_option_struct {
   process_field_displayed
       process_fields_displayed; // Which columns of the
                                 // process list are displayed
+  unsigned bandwidth_budget;    // Terminal output budget in KiB/s (0 = unlimited)
+  bool thread_breakdown_all;    // Measure the threads of every process, not
+                                // only the selected one
+  bool highlight_cross_socket;  // Highlight the processes running away
+                                // from the NUMA node of their GPU
+  bool roll_up_descendants;     // Add the CPU, memory and I/O of the children
+                                // (e.g., data loader workers) to their parent
+  bool detect_stragglers;       // Highlight the ranks of distributed jobs
+                                // lagging behind the others
+  bool group_by_cgroup;         // Aggregate the process list by cgroup
+  unsigned cgroup_group_depth;  // Path components the groups share (0 = all)
+  unsigned time_share_window;   // Seconds over which the GPU time is shared
+  unsigned stranded_threshold;  // GPU usage (%) under which held memory is
+                                // stranded (0 = off)
+  char *flight_recorder_triggers;   // Conditions starting a capture (NULL = off)
+  char *flight_recorder_trace_file; // File the captures are appended to
+  unsigned flight_recorder_seconds; // Seconds recorded before and after
 } nvtop_interface_option;
 
 inline bool plot_isset_draw_info(enum plot_information check_info,
@@ -113,6 +134,20 @@ inline process_field_displayed process_default_displayed_field(void) {
   }
   to_display = process_remove_field_to_display(process_enc_rate, to_display);
   to_display = process_remove_field_to_display(process_dec_rate, to_display);
+  to_display = process_remove_field_to_display(process_energy, to_display);
+  to_display = process_remove_field_to_display(process_perf_per_watt, to_display);
+  to_display = process_remove_field_to_display(process_top_threads, to_display);
+  to_display = process_remove_field_to_display(process_io_read, to_display);
+  to_display = process_remove_field_to_display(process_io_write, to_display);
+  to_display = process_remove_field_to_display(process_cgroup, to_display);
+  to_display = process_remove_field_to_display(process_pressure, to_display);
+  to_display = process_remove_field_to_display(process_cpu_throttled, to_display);
+  to_display = process_remove_field_to_display(process_numa, to_display);
+  to_display = process_remove_field_to_display(process_time_share, to_display);
+  to_display = process_remove_field_to_display(process_idle_gaps, to_display);
+  to_display = process_remove_field_to_display(process_memory_growth, to_display);
+  to_display = process_remove_field_to_display(process_bottleneck, to_display);
+  to_display = process_remove_field_to_display(process_stranded, to_display);
   return to_display;
 }
 
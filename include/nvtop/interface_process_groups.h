@@ -0,0 +1,77 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef INTERFACE_PROCESS_GROUPS_H__
+#define INTERFACE_PROCESS_GROUPS_H__
+
+#include "nvtop/process_table.h"
+#include "uthash.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Processes sharing the leading components of their cgroup path
+struct process_group {
+  const char *path;       // Into the process table strings, valid for a frame
+  unsigned path_length;   // Length of the prefix shared by the members
+  unsigned members_count;
+  unsigned first_member;  // Index of the first member in members
+  unsigned gpu_usage;
+  unsigned long long gpu_memory_usage;
+  unsigned cpu_usage;
+  unsigned long long cpu_memory_res;
+  double energy_consumed;
+  uint64_t engine_used;   // gfx + compute engine time in nanoseconds
+  bool expanded;
+  UT_hash_handle hh;
+};
+
+struct process_groups {
+  unsigned count;
+  unsigned capacity;
+  struct process_group *groups;
+  struct process_group *lookup;   // Keyed by the path prefix
+  unsigned *group_of_string;      // Group of each interned cgroup path
+  unsigned group_of_string_capacity;
+  unsigned *order;                // Groups in display order
+  unsigned *group_of_row;
+  unsigned *members;              // Table rows, gathered group after group
+  unsigned members_capacity;
+  char **expanded;                // Expanded paths, kept across rebuilds
+  unsigned expanded_count;
+};
+
+void process_groups_init(struct process_groups *groups);
+
+void process_groups_free(struct process_groups *groups);
+
+// Gathers the table rows by the first depth components of their cgroup path
+// (0 for the whole path) in one pass. Rows without a known cgroup share the
+// group with an empty path. The members of a group are left in table order,
+// for only the expanded groups need sorting.
+void process_groups_build(struct process_groups *groups,
+                          const struct gpuinfo_process_table *table,
+                          unsigned depth);
+
+void process_groups_toggle_expanded(struct process_groups *groups,
+                                    unsigned group);
+
+#endif // INTERFACE_PROCESS_GROUPS_H__
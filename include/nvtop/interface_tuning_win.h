@@ -0,0 +1,38 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef INTERFACE_TUNING_WIN_H__
+#define INTERFACE_TUNING_WIN_H__
+
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/interface_internal_common.h"
+
+// Shown in place of the process list to change the power limit, clocks and
+// power profiles of a device. Every change is confirmed by a second Enter.
+
+void show_tuning_window(struct nvtop_interface *interface);
+
+void draw_tuning_window(struct list_head *devices, struct nvtop_interface *interface);
+
+void handle_tuning_win_keypress(int keyId, struct nvtop_interface *interface);
+
+#endif // INTERFACE_TUNING_WIN_H__
@@ -0,0 +1,148 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef LIBNVTOP_H__
+#define LIBNVTOP_H__
+
+// Stable C interface to the nvtop collection layer. This header does not
+// depend on the internal headers, and the layouts below only change along
+// with LIBNVTOP_API_VERSION.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIBNVTOP_API_VERSION 1
+
+// The library is built with hidden visibility, only these functions are
+// exported
+#if defined(__GNUC__)
+#define LIBNVTOP_EXPORT __attribute__((visibility("default")))
+#else
+#define LIBNVTOP_EXPORT
+#endif
+
+#define LIBNVTOP_DEVICE_NAME_SIZE 128
+
+#define LIBNVTOP_IS_VALID(field, valid) (((valid) >> (field)) & 1u)
+
+enum libnvtop_device_field {
+  libnvtop_device_gpu_util,
+  libnvtop_device_mem_util,
+  libnvtop_device_mem_bandwidth_util,
+  libnvtop_device_total_memory,
+  libnvtop_device_used_memory,
+  libnvtop_device_temperature,
+  libnvtop_device_power_draw,
+  libnvtop_device_power_limit,
+  libnvtop_device_gpu_clock,
+  libnvtop_device_mem_clock,
+  libnvtop_device_fan_speed,
+  libnvtop_device_encoder_util,
+  libnvtop_device_decoder_util,
+  libnvtop_device_pcie_rx,
+  libnvtop_device_pcie_tx,
+};
+
+struct libnvtop_device {
+  unsigned index;                          // Position in the enumeration order
+  char name[LIBNVTOP_DEVICE_NAME_SIZE];
+  unsigned valid;                          // Bitset of enum libnvtop_device_field
+  unsigned gpu_util;                       // %
+  unsigned mem_util;                       // %
+  unsigned mem_bandwidth_util;             // %
+  unsigned long long total_memory;         // Bytes
+  unsigned long long used_memory;          // Bytes
+  unsigned temperature;                    // °C
+  unsigned power_draw;                     // Milliwatts
+  unsigned power_limit;                    // Milliwatts
+  unsigned gpu_clock;                      // MHz
+  unsigned mem_clock;                      // MHz
+  unsigned fan_speed;                      // %
+  unsigned encoder_util;                   // %
+  unsigned decoder_util;                   // %
+  unsigned pcie_rx;                        // KiB/s
+  unsigned pcie_tx;                        // KiB/s
+  unsigned processes_count;                // Processes in the last snapshot
+};
+
+enum libnvtop_process_field {
+  libnvtop_process_gpu_util,
+  libnvtop_process_encoder_util,
+  libnvtop_process_decoder_util,
+  libnvtop_process_gpu_memory,
+  libnvtop_process_cpu_util,
+  libnvtop_process_cpu_memory,
+};
+
+enum libnvtop_process_type {
+  libnvtop_process_graphical,
+  libnvtop_process_compute,
+};
+
+struct libnvtop_process {
+  pid_t pid;
+  unsigned device_index;
+  enum libnvtop_process_type type;
+  unsigned valid;                          // Bitset of enum libnvtop_process_field
+  unsigned gpu_util;                       // %
+  unsigned encoder_util;                   // %
+  unsigned decoder_util;                   // %
+  unsigned long long gpu_memory;           // Bytes
+  unsigned cpu_util;                       // % of one CPU
+  unsigned long cpu_memory;                // Resident bytes
+};
+
+// Pass LIBNVTOP_API_VERSION. Fails when the library was built for another
+// version, when already initialized, or when no device was found.
+LIBNVTOP_EXPORT bool libnvtop_init(unsigned api_version);
+
+LIBNVTOP_EXPORT unsigned libnvtop_device_count(void);
+
+// Refreshes every device and copies up to the given capacities into the
+// caller buffers. The copy itself does not allocate, but refreshing the
+// process lists may (re)allocate the library's internal buffers. The counts
+// receive the number of entries available, which may exceed the capacities.
+// Either buffer may be NULL with a capacity of 0.
+LIBNVTOP_EXPORT bool libnvtop_snapshot(struct libnvtop_device *devices, size_t devices_capacity,
+                                       size_t *devices_count, struct libnvtop_process *processes,
+                                       size_t processes_capacity, size_t *processes_count);
+
+// Visit the entries of the last snapshot until the visitor returns false
+typedef bool (*libnvtop_device_visitor)(const struct libnvtop_device *device, void *data);
+typedef bool (*libnvtop_process_visitor)(const struct libnvtop_process *process, void *data);
+
+LIBNVTOP_EXPORT void libnvtop_foreach_device(libnvtop_device_visitor visitor, void *data);
+
+LIBNVTOP_EXPORT void libnvtop_foreach_process(libnvtop_process_visitor visitor, void *data);
+
+LIBNVTOP_EXPORT void libnvtop_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBNVTOP_H__
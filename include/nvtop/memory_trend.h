@@ -0,0 +1,53 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef MEMORY_TREND_H__
+#define MEMORY_TREND_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Least squares slope of a memory usage over a sliding window of samples,
+// updated in constant time per sample from running sums. The samples are
+// spaced by at least MEMORY_TREND_SAMPLE_PERIOD seconds, so that the window
+// covers the last ten minutes whatever the refresh interval.
+
+#define MEMORY_TREND_SAMPLES 120
+#define MEMORY_TREND_SAMPLE_PERIOD 5.
+
+struct memory_trend {
+  bool started;
+  uint64_t origin;      // Nanoseconds, time zero of the stored samples
+  uint64_t last_sample; // Nanoseconds
+  unsigned count;
+  unsigned next;
+  double times[MEMORY_TREND_SAMPLES]; // Seconds since origin
+  double values[MEMORY_TREND_SAMPLES];
+  double sum_t, sum_v, sum_tt, sum_tv;
+};
+
+void memory_trend_add_sample(struct memory_trend *trend, uint64_t timestamp, double value);
+
+// Value change per second, false until the window spans a minute
+bool memory_trend_slope(const struct memory_trend *trend, double *slope);
+
+#endif // MEMORY_TREND_H__
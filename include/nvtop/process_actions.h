@@ -0,0 +1,45 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef PROCESS_ACTIONS_H__
+#define PROCESS_ACTIONS_H__
+
+#include "nvtop/cpu_mask.h"
+
+#include <sys/types.h>
+
+// The scheduling settings are per thread, these change every thread of the
+// process. They return 0 or the first errno value met.
+
+enum process_io_class {
+  process_io_best_effort,
+  process_io_idle,
+};
+
+int process_renice(pid_t pid, int increment);
+
+int process_set_io_class(pid_t pid, enum process_io_class io_class);
+
+// NULL for every CPU
+int process_set_affinity(pid_t pid, const struct cpu_mask *cpus);
+
+#endif // PROCESS_ACTIONS_H__
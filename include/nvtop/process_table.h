@@ -0,0 +1,121 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PROCESS_TABLE_H__
+#define PROCESS_TABLE_H__
+
+#include "nvtop/extract_gpuinfo_common.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+
+// Strings shared by the processes (user names, command lines) are stored once
+// and referred to by index
+struct gpuinfo_interned_string;
+
+struct gpuinfo_string_pool {
+  struct gpuinfo_interned_string *lookup;   // Hash table keyed by the string
+  struct gpuinfo_interned_string **entries; // Indexed by string id, NULL if free
+  unsigned entries_count, entries_capacity;
+  unsigned *free_ids, free_count;
+  unsigned generation; // Incremented at each table fill
+  unsigned live_count; // Strings referenced by the current fill
+};
+
+// Columns of the process table, as X(type, name). The vendors fill the
+// columns of the per-device process lists, which are copied over, and the
+// collection derives the others straight into the table.
+#define GPUINFO_PROCESS_TABLE_COLUMNS(X)                                                                               \
+  X(pid_t, pid)                                                                                                        \
+  X(unsigned, gpu_id)                                                                                                  \
+  X(enum gpu_process_type, type)                                                                                       \
+  X(unsigned, cmdline)                 /* Interned string id */                                                        \
+  X(unsigned, user_name)               /* Interned string id */                                                        \
+  X(uint64_t, gfx_engine_used)                                                                                         \
+  X(uint64_t, compute_engine_used)                                                                                     \
+  X(unsigned, gpu_usage)                                                                                               \
+  X(unsigned, encode_usage)                                                                                            \
+  X(unsigned, decode_usage)                                                                                            \
+  X(unsigned long long, gpu_memory_usage)                                                                              \
+  X(unsigned, gpu_memory_percentage)                                                                                   \
+  X(unsigned, cpu_usage)                                                                                               \
+  X(unsigned long, cpu_memory_virt)                                                                                    \
+  X(unsigned long, cpu_memory_res)                                                                                     \
+  X(unsigned, memory_bandwidth_usage)                                                                                  \
+  X(double, energy_consumed)           /* Joules of the device energy attributed to the process */                     \
+  X(unsigned, power_draw)              /* Share of the device power draw in milliwatts */                              \
+  X(struct gpuinfo_top_threads, top_threads)                                                                           \
+  X(unsigned long long, io_read_rate)  /* Bytes per second */                                                          \
+  X(unsigned long long, io_write_rate) /* Bytes per second */                                                          \
+  X(unsigned, cgroup)                  /* Interned string id of the cgroup v2 path */                                  \
+  X(double, cpu_pressure)              /* cgroup share of time stalled on CPU (%) */                                   \
+  X(double, memory_pressure)           /* cgroup share of time stalled on memory (%) */                                \
+  X(double, io_pressure)               /* cgroup share of time stalled on I/O (%) */                                   \
+  X(double, cpu_throttled)             /* cgroup share of time throttled by cpu.max (%) */                             \
+  X(enum gpuinfo_numa_placement, numa_placement)                                                                       \
+  X(unsigned, descendants)             /* Descendants whose CPU, RSS and I/O are rolled up */                          \
+  X(bool, straggler)                   /* Rank persistently behind the others of its job */                            \
+  X(unsigned, gpu_time_share)          /* Share of the device GPU time over the time share window (%) */               \
+  X(struct gpuinfo_idle_gaps, idle_gaps)                                                                               \
+  X(double, gpu_memory_growth)         /* Trend of gpu_memory_usage in bytes per second */                             \
+  X(enum gpuinfo_bottleneck, bottleneck)                                                                               \
+  X(double, stranded_time)             /* Seconds holding memory without using the GPU */                              \
+  X(double, idle_energy)               /* Joules of the device spent stranded, shared by the memory held */            \
+  X(uint64_t, valid)                   /* Bitset of enum gpuinfo_process_info_valid */
+
+// Host-wide process table in struct-of-arrays layout, with one row per
+// (device, process) pair. The columns only grow and are reused across
+// refreshes.
+struct gpuinfo_process_table {
+  unsigned count;
+  unsigned capacity;
+#define GPUINFO_PROCESS_TABLE_COLUMN(type, name) type *name;
+  GPUINFO_PROCESS_TABLE_COLUMNS(GPUINFO_PROCESS_TABLE_COLUMN)
+#undef GPUINFO_PROCESS_TABLE_COLUMN
+  struct gpuinfo_string_pool strings;
+};
+
+#define GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, field)                                                         \
+  (((table)->valid[row] >> gpuinfo_process_##field##_valid) & 1)
+
+#define SET_GPUINFO_PROCESS_TABLE(table, row, field, value)                                                            \
+  do {                                                                                                                 \
+    (table)->field[row] = (value);                                                                                     \
+    (table)->valid[row] |= UINT64_C(1) << gpuinfo_process_##field##_valid;                                             \
+  } while (0)
+
+void gpuinfo_process_table_init(struct gpuinfo_process_table *table);
+
+void gpuinfo_process_table_free(struct gpuinfo_process_table *table);
+
+// Rebuilds the table from the per-device process lists, the derived columns
+// being invalid until set
+void gpuinfo_process_table_fill(struct gpuinfo_process_table *table, struct list_head *devices);
+
+// Drops the rows of the process, keeping the order of the others
+void gpuinfo_process_table_remove_pid(struct gpuinfo_process_table *table, pid_t pid);
+
+// The strings interned since the last fill stay until the next one
+unsigned gpuinfo_process_table_intern(struct gpuinfo_process_table *table, const char *value);
+
+const char *gpuinfo_process_table_string(const struct gpuinfo_process_table *table, unsigned string_id);
+
+#endif // PROCESS_TABLE_H__
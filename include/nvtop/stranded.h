@@ -0,0 +1,52 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#ifndef STRANDED_H__
+#define STRANDED_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Memory held while the GPU usage stays under the stranded threshold. An idle
+// period counts as stranded once it lasted GPUINFO_STRANDED_GRACE_PERIOD
+// seconds, the pauses of a running workload do not.
+#define GPUINFO_STRANDED_GRACE_PERIOD 60
+
+struct gpuinfo_stranded {
+  bool idle;            // Memory held and GPU usage under the threshold
+  uint64_t since;       // Start of the idle period in nanoseconds
+  uint64_t last_update; // Nanoseconds
+  double period_energy; // Joules spent since the start of the idle period
+  double time;          // Seconds spent stranded since monitoring started
+  double energy;        // Joules spent stranded since monitoring started
+};
+
+// The energy spent since the previous update belongs to the idle period when
+// both updates are idle. The whole period is accounted for once it has lasted
+// the grace period.
+void gpuinfo_stranded_update(struct gpuinfo_stranded *stranded, bool idle, uint64_t now, double energy);
+
+// Seconds since the start of the idle period, false unless it lasted long
+// enough to count as stranded
+bool gpuinfo_stranded_duration(const struct gpuinfo_stranded *stranded, double *seconds);
+
+#endif // STRANDED_H__
@@ -0,0 +1,79 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/cpu_mask.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CPU_MASK_WORDS (sizeof(((struct cpu_mask *)0)->bits) / sizeof(uint64_t))
+
+bool cpu_mask_parse_list(const char *list, struct cpu_mask *mask) {
+  memset(mask, 0, sizeof(*mask));
+  const char *pos = list;
+  while (isspace((unsigned char)*pos))
+    pos++;
+  while (*pos && *pos != '\n') {
+    char *end;
+    unsigned long first = strtoul(pos, &end, 10);
+    if (end == pos)
+      return false;
+    unsigned long last = first;
+    pos = end;
+    if (*pos == '-') {
+      last = strtoul(pos + 1, &end, 10);
+      if (end == pos + 1 || last < first)
+        return false;
+      pos = end;
+    }
+    for (unsigned long id = first; id <= last && id < CPU_MASK_MAX_ID; ++id)
+      mask->bits[id / 64] |= UINT64_C(1) << (id % 64);
+    if (*pos == ',')
+      pos++;
+    else if (*pos && *pos != '\n')
+      return false;
+  }
+  return true;
+}
+
+bool cpu_mask_is_empty(const struct cpu_mask *mask) {
+  for (unsigned i = 0; i < CPU_MASK_WORDS; ++i)
+    if (mask->bits[i])
+      return false;
+  return true;
+}
+
+bool cpu_mask_intersects(const struct cpu_mask *mask1, const struct cpu_mask *mask2) {
+  for (unsigned i = 0; i < CPU_MASK_WORDS; ++i)
+    if (mask1->bits[i] & mask2->bits[i])
+      return true;
+  return false;
+}
+
+bool cpu_mask_is_subset(const struct cpu_mask *subset, const struct cpu_mask *set) {
+  for (unsigned i = 0; i < CPU_MASK_WORDS; ++i)
+    if (subset->bits[i] & ~set->bits[i])
+      return false;
+  return true;
+}
+
+extern inline bool cpu_mask_is_set(const struct cpu_mask *mask, unsigned id);
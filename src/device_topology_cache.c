@@ -0,0 +1,163 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/device_topology_cache.h"
+#include "nvtop/extract_gpuinfo.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char cache_file_location[] = "nvtop/topology";
+static const char cache_default_path[] = ".cache";
+static const char cache_header[] = "nvtop device topology v1";
+
+// $XDG_CACHE_HOME/nvtop/topology, defaulting to $HOME/.cache/nvtop/topology
+static bool cache_file_path(char path[PATH_MAX]) {
+  const char *xdg_cache_dir = getenv("XDG_CACHE_HOME");
+  int written;
+  if (xdg_cache_dir && xdg_cache_dir[0] != '\0') {
+    written = snprintf(path, PATH_MAX, "%s/%s", xdg_cache_dir, cache_file_location);
+  } else {
+    const char *home = getenv("HOME");
+    if (!home)
+      return false;
+    written = snprintf(path, PATH_MAX, "%s/%s/%s", home, cache_default_path, cache_file_location);
+  }
+  return written > 0 && written < PATH_MAX;
+}
+
+static void remove_trailing_newline(char *line) {
+  size_t length = strlen(line);
+  if (length && line[length - 1] == '\n')
+    line[length - 1] = '\0';
+}
+
+bool device_topology_cache_load(const char *key, unsigned *devices_count, char ***device_names) {
+  char path[PATH_MAX];
+  if (!cache_file_path(path))
+    return false;
+  FILE *cache_file = fopen(path, "r");
+  if (!cache_file)
+    return false;
+
+  bool valid = false;
+  char *line = NULL;
+  size_t line_size = 0;
+  unsigned count = 0;
+  char **names = NULL;
+  // Header, key and device count
+  if (getline(&line, &line_size, cache_file) < 0)
+    goto close_file;
+  remove_trailing_newline(line);
+  if (strcmp(line, cache_header))
+    goto close_file;
+  if (getline(&line, &line_size, cache_file) < 0)
+    goto close_file;
+  remove_trailing_newline(line);
+  if (strcmp(line, key))
+    goto close_file;
+  if (fscanf(cache_file, "%u\n", &count) != 1 || count == 0 || count > 1u << 16)
+    goto close_file;
+
+  names = calloc(count, sizeof(*names));
+  if (!names) {
+    perror("Could not allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  unsigned names_read = 0;
+  for (; names_read < count; ++names_read) {
+    if (getline(&line, &line_size, cache_file) < 0)
+      break;
+    remove_trailing_newline(line);
+    names[names_read] = strdup(line);
+    if (!names[names_read]) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+  valid = names_read == count;
+  if (!valid)
+    device_topology_cache_free_names(count, names);
+
+close_file:
+  free(line);
+  fclose(cache_file);
+  if (valid) {
+    *devices_count = count;
+    *device_names = names;
+  }
+  return valid;
+}
+
+static bool create_cache_directory(char *path) {
+  // Create every parent directory of the cache file
+  for (char *index = path + 1; *index != '\0'; ++index) {
+    if (*index == '/') {
+      *index = '\0';
+      int retval = mkdir(path, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH);
+      *index = '/';
+      if (retval && errno != EEXIST)
+        return false;
+    }
+  }
+  return true;
+}
+
+// Best effort: the cache is only a startup hint, failures are silent
+void device_topology_cache_save(const char *key, struct list_head *devices) {
+  char path[PATH_MAX], temporary_path[PATH_MAX];
+  if (!cache_file_path(path) || !create_cache_directory(path))
+    return;
+  int written = snprintf(temporary_path, PATH_MAX, "%s.%ld", path, (long)getpid());
+  if (written <= 0 || written >= PATH_MAX)
+    return;
+  FILE *cache_file = fopen(temporary_path, "w");
+  if (!cache_file)
+    return;
+
+  unsigned count = 0;
+  struct gpu_info *device;
+  list_for_each_entry(device, devices, list) { count++; }
+  fprintf(cache_file, "%s\n%s\n%u\n", cache_header, key, count);
+  list_for_each_entry(device, devices, list) {
+    if (IS_VALID(gpuinfo_device_name_valid, device->static_info.valid))
+      fprintf(cache_file, "%s\n", device->static_info.device_name);
+    else
+      fprintf(cache_file, "\n");
+  }
+  bool success = !ferror(cache_file);
+  success = fclose(cache_file) == 0 && success;
+  if (!success || rename(temporary_path, path))
+    remove(temporary_path);
+}
+
+void device_topology_cache_free_names(unsigned devices_count, char **device_names) {
+  if (!device_names)
+    return;
+  for (unsigned i = 0; i < devices_count; ++i)
+    free(device_names[i]);
+  free(device_names);
+}
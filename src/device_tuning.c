@@ -0,0 +1,372 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/device_tuning.h"
+#include "nvtop/common.h"
+#include "nvtop/sysfs.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+static const char log_file_location[] = "nvtop/tuning.log";
+static const char log_default_path[] = ".local/state";
+
+static const char *knob_names[gpuinfo_tuning_knob_count] = {
+    [gpuinfo_tuning_power_limit] = "Power limit",
+    [gpuinfo_tuning_locked_gpu_clock] = "Locked GPU clock",
+    [gpuinfo_tuning_applications_clock] = "Applications clock",
+    [gpuinfo_tuning_power_profile] = "Power profile",
+    [gpuinfo_tuning_performance_level] = "Performance level",
+};
+
+static const char *amdgpu_performance_levels[] = {
+    "auto",         "low", "high", "manual", "profile_standard", "profile_min_sclk", "profile_min_mclk",
+    "profile_peak",
+};
+// The power profile is only applied in the manual performance level
+static const int amdgpu_manual_performance_level = 3;
+
+// A change also records the knob it had to set beforehand, undone along
+struct tuning_change {
+  struct gpu_info *device;
+  unsigned device_index;
+  enum gpuinfo_tuning_knob_id knob;
+  int previous;
+  int value;
+  bool required_changed;
+  enum gpuinfo_tuning_knob_id required_knob;
+  int required_previous;
+  int required_value;
+};
+
+static struct tuning_change *changes;
+static unsigned changes_count;
+static unsigned changes_size;
+
+bool tuning_supported(const struct gpu_info *device) {
+  return device->vendor && device->vendor->get_tuning && device->vendor->set_tuning;
+}
+
+void tuning_read(struct gpu_info *device, struct gpuinfo_tuning *tuning) {
+  memset(tuning, 0, sizeof(*tuning));
+  if (tuning_supported(device))
+    device->vendor->get_tuning(device, tuning);
+}
+
+const char *tuning_knob_name(enum gpuinfo_tuning_knob_id knob) { return knob_names[knob]; }
+
+int tuning_knob_step(const struct gpuinfo_tuning_knob *knob, int value, bool increase) {
+  if (knob->choices_count) {
+    unsigned index = 0;
+    while (index + 1 < knob->choices_count && knob->choice_values[index] != value)
+      index++;
+    if (knob->choice_values[index] != value)
+      return knob->choice_values[0];
+    if (increase && index + 1 < knob->choices_count)
+      index++;
+    if (!increase && index > 0)
+      index--;
+    return knob->choice_values[index];
+  }
+  // A value off the steps goes to the nearest step in that direction
+  int step = knob->step > 0 ? knob->step : 1;
+  int below = value - value % step;
+  if (increase)
+    return below > knob->maximum - step ? knob->maximum : below + step;
+  int next = below == value ? value - step : below;
+  return next < knob->minimum ? knob->minimum : next;
+}
+
+void tuning_format_value(const struct gpuinfo_tuning_knob *knob, enum gpuinfo_tuning_knob_id id, int value,
+                         char *buffer, size_t size) {
+  for (unsigned i = 0; i < knob->choices_count; ++i) {
+    if (knob->choice_values[i] == value) {
+      snprintf(buffer, size, "%s", knob->choice_names[i]);
+      return;
+    }
+  }
+  switch (id) {
+  case gpuinfo_tuning_power_limit:
+    if (value % 1000)
+      snprintf(buffer, size, "%.1f W", value / 1000.);
+    else
+      snprintf(buffer, size, "%d W", value / 1000);
+    break;
+  case gpuinfo_tuning_locked_gpu_clock:
+  case gpuinfo_tuning_applications_clock:
+    if (value)
+      snprintf(buffer, size, "%d MHz", value);
+    else
+      snprintf(buffer, size, "%s", id == gpuinfo_tuning_locked_gpu_clock ? "off" : "default");
+    break;
+  default:
+    snprintf(buffer, size, "%d", value);
+    break;
+  }
+}
+
+// $XDG_STATE_HOME/nvtop/tuning.log, defaulting to $HOME/.local/state/nvtop/tuning.log
+static FILE *open_log_file(void) {
+  char path[PATH_MAX];
+  const char *xdg_state_dir = getenv("XDG_STATE_HOME");
+  int written;
+  if (xdg_state_dir && xdg_state_dir[0] != '\0') {
+    written = snprintf(path, PATH_MAX, "%s/%s", xdg_state_dir, log_file_location);
+  } else {
+    const char *home = getenv("HOME");
+    if (!home)
+      return NULL;
+    written = snprintf(path, PATH_MAX, "%s/%s/%s", home, log_default_path, log_file_location);
+  }
+  if (written <= 0 || written >= PATH_MAX)
+    return NULL;
+  for (char *index = path + 1; *index != '\0'; ++index) {
+    if (*index == '/') {
+      *index = '\0';
+      int retval = mkdir(path, S_IRWXU);
+      *index = '/';
+      if (retval && errno != EEXIST)
+        return NULL;
+    }
+  }
+  return fopen(path, "a");
+}
+
+// Best effort: a change is not rolled back because it could not be logged
+static void log_change(const struct tuning_change *change, enum gpuinfo_tuning_knob_id id,
+                       const struct gpuinfo_tuning_knob *knob, int from, int to, bool undo) {
+  FILE *log = open_log_file();
+  if (!log)
+    return;
+  char previous[GPUINFO_TUNING_CHOICE_NAME_SIZE], value[GPUINFO_TUNING_CHOICE_NAME_SIZE];
+  tuning_format_value(knob, id, from, previous, sizeof(previous));
+  tuning_format_value(knob, id, to, value, sizeof(value));
+  char date[32];
+  time_t now = time(NULL);
+  struct tm local;
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime_r(&now, &local));
+  bool named = IS_VALID(gpuinfo_device_name_valid, change->device->static_info.valid);
+  fprintf(log, "%s GPU%u%s%s: %s %s -> %s%s\n", date, change->device_index, named ? " " : "",
+          named ? change->device->static_info.device_name : "", knob_names[id], previous, value,
+          undo ? " (undone)" : "");
+  fclose(log);
+}
+
+static bool set_knob(struct gpu_info *device, enum gpuinfo_tuning_knob_id knob, int value, const char **error) {
+  if (device->vendor->set_tuning(device, knob, value))
+    return true;
+  *error = device->vendor->last_error_string();
+  return false;
+}
+
+bool tuning_apply(struct gpu_info *device, unsigned device_index, enum gpuinfo_tuning_knob_id knob, int value,
+                  const char **error) {
+  struct gpuinfo_tuning tuning;
+  tuning_read(device, &tuning);
+  const struct gpuinfo_tuning_knob *target = &tuning.knobs[knob];
+  if (!target->available) {
+    *error = "Not supported by this device";
+    return false;
+  }
+  struct tuning_change change = {
+      .device = device,
+      .device_index = device_index,
+      .knob = knob,
+      .previous = target->value,
+      .value = value,
+  };
+  if (target->has_requirement) {
+    const struct gpuinfo_tuning_knob *required = &tuning.knobs[target->required_knob];
+    if (!required->available) {
+      *error = "Not supported by this device";
+      return false;
+    }
+    change.required_knob = target->required_knob;
+    change.required_previous = required->value;
+    change.required_value = target->required_value;
+    if (required->value != target->required_value) {
+      if (!set_knob(device, target->required_knob, target->required_value, error))
+        return false;
+      change.required_changed = true;
+    }
+  }
+  if (!set_knob(device, knob, value, error)) {
+    const char *restore_error;
+    if (change.required_changed)
+      set_knob(device, change.required_knob, change.required_previous, &restore_error);
+    return false;
+  }
+  if (changes_count == changes_size) {
+    changes_size = changes_size ? 2 * changes_size : 16;
+    changes = reallocarray(changes, changes_size, sizeof(*changes));
+    if (!changes) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+  changes[changes_count++] = change;
+  if (change.required_changed)
+    log_change(&change, change.required_knob, &tuning.knobs[change.required_knob], change.required_previous,
+               change.required_value, false);
+  log_change(&change, knob, target, change.previous, value, false);
+  return true;
+}
+
+unsigned tuning_changes_count(void) { return changes_count; }
+
+bool tuning_undo(const char **error) {
+  if (!changes_count) {
+    *error = "Nothing to undo";
+    return false;
+  }
+  struct tuning_change *change = &changes[changes_count - 1];
+  struct gpuinfo_tuning tuning;
+  tuning_read(change->device, &tuning);
+  if (!set_knob(change->device, change->knob, change->previous, error))
+    return false;
+  log_change(change, change->knob, &tuning.knobs[change->knob], change->value, change->previous, true);
+  if (change->required_changed) {
+    if (!set_knob(change->device, change->required_knob, change->required_previous, error)) {
+      // Only the requirement is left to undo
+      change->knob = change->required_knob;
+      change->previous = change->required_previous;
+      change->value = change->required_value;
+      change->required_changed = false;
+      return false;
+    }
+    log_change(change, change->required_knob, &tuning.knobs[change->required_knob], change->required_value,
+               change->required_previous, true);
+  }
+  changes_count--;
+  return true;
+}
+
+void tuning_clear(void) {
+  free(changes);
+  changes = NULL;
+  changes_count = 0;
+  changes_size = 0;
+}
+
+static void read_amdgpu_performance_level(int sysfs_dirfd, struct gpuinfo_tuning_knob *knob) {
+  char line[64];
+  if (!sysfs_read_line(sysfs_dirfd, "power_dpm_force_performance_level", line, sizeof(line)))
+    return;
+  for (unsigned i = 0; i < ARRAY_SIZE(amdgpu_performance_levels); ++i) {
+    knob->choice_values[i] = (int)i;
+    snprintf(knob->choice_names[i], GPUINFO_TUNING_CHOICE_NAME_SIZE, "%s", amdgpu_performance_levels[i]);
+    if (!strcmp(line, amdgpu_performance_levels[i])) {
+      knob->value = (int)i;
+      knob->available = true;
+    }
+  }
+  knob->choices_count = ARRAY_SIZE(amdgpu_performance_levels);
+}
+
+// The profiles are listed as "<number> <NAME>" followed by their settings,
+// the active one marked by a '*' before the ':' ending the name. The custom
+// profile needs its settings to be written along and is left out.
+static void read_amdgpu_power_profiles(int sysfs_dirfd, struct gpuinfo_tuning_knob *knob) {
+  int fd = openat(sysfs_dirfd, "pp_power_profile_mode", O_RDONLY);
+  if (fd < 0)
+    return;
+  FILE *file = fdopen(fd, "r");
+  if (!file) {
+    close(fd);
+    return;
+  }
+  char *line = NULL;
+  size_t line_size = 0;
+  bool active_found = false;
+  while (getline(&line, &line_size, file) >= 0 && knob->choices_count < GPUINFO_TUNING_MAX_CHOICES) {
+    int number;
+    char name[GPUINFO_TUNING_CHOICE_NAME_SIZE];
+    if (sscanf(line, "%d %23[A-Za-z0-9_]", &number, name) != 2 || !strcmp(name, "CUSTOM"))
+      continue;
+    char *colon = strchr(line, ':');
+    char *star = strchr(line, '*');
+    if (star && (!colon || star < colon)) {
+      knob->value = number;
+      active_found = true;
+    }
+    knob->choice_values[knob->choices_count] = number;
+    memcpy(knob->choice_names[knob->choices_count], name, sizeof(name));
+    knob->choices_count++;
+  }
+  free(line);
+  fclose(file);
+  knob->available = active_found;
+}
+
+void tuning_read_amdgpu_sysfs(int sysfs_dirfd, struct gpuinfo_tuning *tuning) {
+  if (sysfs_dirfd < 0)
+    return;
+  struct gpuinfo_tuning_knob *profile = &tuning->knobs[gpuinfo_tuning_power_profile];
+  read_amdgpu_power_profiles(sysfs_dirfd, profile);
+  read_amdgpu_performance_level(sysfs_dirfd, &tuning->knobs[gpuinfo_tuning_performance_level]);
+  profile->has_requirement = true;
+  profile->required_knob = gpuinfo_tuning_performance_level;
+  profile->required_value = amdgpu_manual_performance_level;
+}
+
+bool tuning_write_amdgpu_sysfs(int sysfs_dirfd, enum gpuinfo_tuning_knob_id knob, int value) {
+  const char *file_name;
+  char content[32];
+  switch (knob) {
+  case gpuinfo_tuning_power_profile:
+    file_name = "pp_power_profile_mode";
+    snprintf(content, sizeof(content), "%d\n", value);
+    break;
+  case gpuinfo_tuning_performance_level:
+    if (value < 0 || (unsigned)value >= ARRAY_SIZE(amdgpu_performance_levels)) {
+      errno = EINVAL;
+      return false;
+    }
+    file_name = "power_dpm_force_performance_level";
+    snprintf(content, sizeof(content), "%s\n", amdgpu_performance_levels[value]);
+    break;
+  default:
+    errno = ENOTSUP;
+    return false;
+  }
+  int fd = openat(sysfs_dirfd, file_name, O_WRONLY | O_TRUNC);
+  if (fd < 0)
+    return false;
+  size_t length = strlen(content);
+  ssize_t written = write(fd, content, length);
+  int write_errno = errno;
+  close(fd);
+  if (written != (ssize_t)length) {
+    errno = written < 0 ? write_errno : EIO;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,88 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/duty_cycle.h"
+
+// The histograms are halved past that many periods
+static const unsigned histogram_capacity = 1024;
+
+static void histogram_add(struct duty_cycle_histogram *histogram, uint64_t length) {
+  uint64_t milliseconds = length / 1000000;
+  unsigned bucket = 0;
+  while (milliseconds >= 2 && bucket < DUTY_CYCLE_BUCKETS - 1) {
+    milliseconds >>= 1;
+    bucket++;
+  }
+  histogram->buckets[bucket]++;
+  if (++histogram->count < histogram_capacity)
+    return;
+  histogram->count = 0;
+  for (unsigned i = 0; i < DUTY_CYCLE_BUCKETS; ++i) {
+    histogram->buckets[i] /= 2;
+    histogram->count += histogram->buckets[i];
+  }
+}
+
+void duty_cycle_add_sample(struct duty_cycle *cycle, uint64_t timestamp, bool busy) {
+  if (!cycle->sampling || timestamp <= cycle->last_sample) {
+    cycle->sampling = true;
+    cycle->busy = busy;
+    cycle->period_known = false;
+    cycle->period = 0;
+    cycle->last_sample = timestamp;
+    return;
+  }
+  uint64_t elapsed = timestamp - cycle->last_sample;
+  cycle->last_sample = timestamp;
+  if (busy == cycle->busy) {
+    cycle->period += elapsed;
+    return;
+  }
+  // The first period started before the first sample, its length is unknown
+  if (cycle->period_known && !cycle->busy)
+    histogram_add(&cycle->gaps, cycle->period);
+  cycle->busy = busy;
+  cycle->period_known = true;
+  cycle->period = elapsed;
+}
+
+// Middle of the bucket holding the given fraction of the periods
+static double histogram_quantile(const struct duty_cycle_histogram *histogram, double fraction) {
+  unsigned target = (unsigned)(fraction * histogram->count);
+  unsigned cumulated = 0;
+  unsigned bucket;
+  for (bucket = 0; bucket < DUTY_CYCLE_BUCKETS - 1; ++bucket) {
+    cumulated += histogram->buckets[bucket];
+    if (cumulated > target)
+      break;
+  }
+  if (bucket == 0)
+    return 1e-3;
+  return 1.5e-3 * (double)(UINT64_C(1) << bucket);
+}
+
+bool duty_cycle_percentiles(const struct duty_cycle_histogram *histogram, double *median, double *p95) {
+  if (!histogram->count)
+    return false;
+  *median = histogram_quantile(histogram, 0.5);
+  *p95 = histogram_quantile(histogram, 0.95);
+  return true;
+}
@@ -0,0 +1,96 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/extract_bottleneck.h"
+
+// Refreshes with a GPU usage needed before judging
+static const unsigned min_samples = 3;
+// Averages over the window, in %
+static const double gpu_busy_usage = 80.;
+static const double gpu_starved_usage = 50.;
+static const double thread_saturated_usage = 90.;
+static const double io_stalled_pressure = 20.;
+static const double memory_saturated_bandwidth = 60.;
+
+static void metric_add(struct bottleneck_metric *metric, unsigned slot, bool replace, bool valid, double value) {
+  if (replace && metric->valid[slot]) {
+    metric->sum -= metric->values[slot];
+    metric->valid_count--;
+  }
+  metric->valid[slot] = valid;
+  metric->values[slot] = valid ? value : 0.;
+  if (valid) {
+    metric->sum += value;
+    metric->valid_count++;
+  }
+}
+
+static bool metric_average(const struct bottleneck_metric *metric, double *average) {
+  if (!metric->valid_count)
+    return false;
+  *average = metric->sum / metric->valid_count;
+  return true;
+}
+
+void bottleneck_window_add(struct bottleneck_window *window, const struct gpu_info *device,
+                           const struct gpuinfo_process_table *table, unsigned row) {
+  unsigned slot = window->next;
+  bool replace = window->count == BOTTLENECK_WINDOW;
+  if (!replace)
+    window->count++;
+  window->next = (window->next + 1) % BOTTLENECK_WINDOW;
+
+  metric_add(&window->gpu_usage, slot, replace, GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, gpu_usage),
+             table->gpu_usage[row]);
+  bool hot_thread_valid =
+      GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, top_threads) && table->top_threads[row].count > 0;
+  metric_add(&window->hot_thread, slot, replace, hot_thread_valid,
+             hot_thread_valid ? table->top_threads[row].threads[0].cpu_usage : 0.);
+  metric_add(&window->io_pressure, slot, replace, GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, io_pressure),
+             table->io_pressure[row]);
+  if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, memory_bandwidth_usage))
+    metric_add(&window->memory_bandwidth, slot, replace, true, table->memory_bandwidth_usage[row]);
+  else
+    metric_add(&window->memory_bandwidth, slot, replace,
+               GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, mem_bandwidth_rate),
+               device->dynamic_info.mem_bandwidth_rate);
+}
+
+bool bottleneck_window_classify(const struct bottleneck_window *window, enum gpuinfo_bottleneck *bottleneck) {
+  double gpu_usage, value;
+  if (window->gpu_usage.valid_count < min_samples || !metric_average(&window->gpu_usage, &gpu_usage))
+    return false;
+  if (gpu_usage < gpu_busy_usage && metric_average(&window->memory_bandwidth, &value) &&
+      value >= memory_saturated_bandwidth)
+    *bottleneck = gpuinfo_bottleneck_memory;
+  else if (gpu_usage >= gpu_busy_usage)
+    *bottleneck = gpuinfo_bottleneck_gpu;
+  else if (gpu_usage < gpu_starved_usage && metric_average(&window->hot_thread, &value) &&
+           value >= thread_saturated_usage)
+    *bottleneck = gpuinfo_bottleneck_cpu;
+  else if (gpu_usage < gpu_starved_usage && metric_average(&window->io_pressure, &value) &&
+           value >= io_stalled_pressure)
+    *bottleneck = gpuinfo_bottleneck_io;
+  else
+    *bottleneck = gpuinfo_bottleneck_unclear;
+  return true;
+}
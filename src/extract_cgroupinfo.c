@@ -0,0 +1,310 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/extract_cgroupinfo.h"
+#include "nvtop/time.h"
+#include "uthash.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct cgroup_entry {
+  struct cgroup_info info;
+  unsigned read_at;   // Refresh at which the files were last read
+  unsigned used_at;   // Refresh at which a process last referred to it
+  bool throttle_measured;
+  unsigned long long last_throttled_usec;
+  nvtop_time last_throttle_read;
+  UT_hash_handle hh;
+};
+
+struct cgroup_process_key {
+  pid_t pid;
+  unsigned long long start_time;
+};
+
+struct cgroup_process {
+  struct cgroup_process_key key;
+  struct cgroup_entry *cgroup; // NULL when outside of a cgroup v2 hierarchy
+  unsigned used_at;
+  UT_hash_handle hh;
+};
+
+static struct cgroup_entry *cgroups = NULL;
+static struct cgroup_process *cgroup_processes = NULL;
+static unsigned refresh_count = 0;
+
+static bool cgroup2_mount_searched = false;
+static char cgroup2_mount[PATH_MAX];
+
+const char *cgroupinfo_mount_point(void) {
+  if (cgroup2_mount_searched)
+    return cgroup2_mount[0] ? cgroup2_mount : NULL;
+  cgroup2_mount_searched = true;
+  FILE *mounts = fopen("/proc/mounts", "r");
+  if (!mounts)
+    return NULL;
+  char device[256], mount_point[PATH_MAX], type[64];
+  while (fscanf(mounts, "%255s %4095s %63s %*[^\n]", device, mount_point, type) == 3) {
+    if (strcmp(type, "cgroup2") == 0) {
+      strcpy(cgroup2_mount, mount_point);
+      break;
+    }
+  }
+  fclose(mounts);
+  return cgroup2_mount[0] ? cgroup2_mount : NULL;
+}
+
+// The cgroup v2 membership is the "0::<path>" line
+static char *read_process_cgroup_path(pid_t pid) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%" PRIdMAX "/cgroup", (intmax_t)pid);
+  FILE *cgroup_file = fopen(path, "r");
+  if (!cgroup_file)
+    return NULL;
+  char *line = NULL, *cgroup_path = NULL;
+  size_t line_size = 0;
+  ssize_t length;
+  while ((length = getline(&line, &line_size, cgroup_file)) > 0) {
+    if (strncmp(line, "0::", 3) == 0) {
+      if (line[length - 1] == '\n')
+        line[length - 1] = '\0';
+      cgroup_path = strdup(line + 3);
+      break;
+    }
+  }
+  free(line);
+  fclose(cgroup_file);
+  return cgroup_path;
+}
+
+static FILE *open_cgroup_file(const struct cgroup_entry *cgroup, const char *file_name) {
+  const char *mount_point = cgroupinfo_mount_point();
+  if (!mount_point)
+    return NULL;
+  char path[PATH_MAX];
+  int written = snprintf(path, sizeof(path), "%s%s/%s", mount_point, cgroup->info.path, file_name);
+  if (written < 0 || (size_t)written >= sizeof(path))
+    return NULL;
+  return fopen(path, "r");
+}
+
+static bool read_pressure(const struct cgroup_entry *cgroup, const char *file_name, double *pressure) {
+  FILE *pressure_file = open_cgroup_file(cgroup, file_name);
+  if (!pressure_file)
+    return false;
+  bool read_ok = fscanf(pressure_file, "some avg10=%lf", pressure) == 1;
+  fclose(pressure_file);
+  return read_ok;
+}
+
+static bool read_throttled_usec(const struct cgroup_entry *cgroup, unsigned long long *throttled_usec) {
+  FILE *stat_file = open_cgroup_file(cgroup, "cpu.stat");
+  if (!stat_file)
+    return false;
+  char key[64];
+  unsigned long long value;
+  bool found = false;
+  while (!found && fscanf(stat_file, "%63s %llu", key, &value) == 2) {
+    if (strcmp(key, "throttled_usec") == 0) {
+      *throttled_usec = value;
+      found = true;
+    }
+  }
+  fclose(stat_file);
+  return found;
+}
+
+static void read_cgroup_files(struct cgroup_entry *cgroup) {
+  struct cgroup_info *info = &cgroup->info;
+  RESET_ALL(info->valid);
+  double pressure;
+  if (read_pressure(cgroup, "cpu.pressure", &pressure))
+    SET_CGROUPINFO(info, cpu_pressure, pressure);
+  if (read_pressure(cgroup, "memory.pressure", &pressure))
+    SET_CGROUPINFO(info, memory_pressure, pressure);
+  if (read_pressure(cgroup, "io.pressure", &pressure))
+    SET_CGROUPINFO(info, io_pressure, pressure);
+
+  unsigned long long throttled_usec;
+  if (read_throttled_usec(cgroup, &throttled_usec)) {
+    nvtop_time now;
+    nvtop_get_current_time(&now);
+    if (cgroup->throttle_measured && throttled_usec >= cgroup->last_throttled_usec) {
+      double elapsed = nvtop_difftime(cgroup->last_throttle_read, now);
+      if (elapsed > 0.) {
+        double throttled = (throttled_usec - cgroup->last_throttled_usec) / 1e4 / elapsed;
+        SET_CGROUPINFO(info, cpu_throttled, throttled > 100. ? 100. : throttled);
+      }
+    }
+    cgroup->throttle_measured = true;
+    cgroup->last_throttled_usec = throttled_usec;
+    cgroup->last_throttle_read = now;
+  } else {
+    cgroup->throttle_measured = false;
+  }
+}
+
+static struct cgroup_entry *cgroup_from_path(char *path) {
+  struct cgroup_entry *cgroup;
+  HASH_FIND_STR(cgroups, path, cgroup);
+  if (cgroup) {
+    free(path);
+    return cgroup;
+  }
+  cgroup = calloc(1, sizeof(*cgroup));
+  if (!cgroup) {
+    perror("Could not allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  cgroup->info.path = path;
+  HASH_ADD_KEYPTR(hh, cgroups, cgroup->info.path, strlen(cgroup->info.path), cgroup);
+  return cgroup;
+}
+
+void cgroupinfo_begin_refresh(void) { refresh_count++; }
+
+const struct cgroup_info *cgroupinfo_of_process(pid_t pid, unsigned long long start_time) {
+  struct cgroup_process_key key;
+  memset(&key, 0, sizeof(key));
+  key.pid = pid;
+  key.start_time = start_time;
+  struct cgroup_process *process;
+  HASH_FIND(hh, cgroup_processes, &key, sizeof(key), process);
+  if (!process) {
+    process = calloc(1, sizeof(*process));
+    if (!process) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    process->key = key;
+    char *path = cgroupinfo_mount_point() ? read_process_cgroup_path(pid) : NULL;
+    if (path)
+      process->cgroup = cgroup_from_path(path);
+    HASH_ADD(hh, cgroup_processes, key, sizeof(key), process);
+  }
+  process->used_at = refresh_count;
+  struct cgroup_entry *cgroup = process->cgroup;
+  if (!cgroup)
+    return NULL;
+  cgroup->used_at = refresh_count;
+  if (cgroup->read_at != refresh_count) {
+    cgroup->read_at = refresh_count;
+    read_cgroup_files(cgroup);
+  }
+  return &cgroup->info;
+}
+
+static void free_cgroup(struct cgroup_entry *cgroup) {
+  HASH_DEL(cgroups, cgroup);
+  free(cgroup->info.path);
+  free(cgroup);
+}
+
+void cgroupinfo_end_refresh(void) {
+  struct cgroup_process *process, *process_tmp;
+  HASH_ITER(hh, cgroup_processes, process, process_tmp) {
+    if (process->used_at != refresh_count) {
+      HASH_DEL(cgroup_processes, process);
+      free(process);
+    }
+  }
+  struct cgroup_entry *cgroup, *cgroup_tmp;
+  HASH_ITER(hh, cgroups, cgroup, cgroup_tmp) {
+    if (cgroup->used_at != refresh_count)
+      free_cgroup(cgroup);
+  }
+}
+
+static bool ends_with(const char *str, const char *suffix) {
+  size_t length = strlen(str), suffix_length = strlen(suffix);
+  return length >= suffix_length && strcmp(str + length - suffix_length, suffix) == 0;
+}
+
+// The cgroups of systemd grouping other units, the login sessions and those
+// with child cgroups hold more than the process and are left alone
+static bool cgroup_limited_to_process(const char *cgroup_directory, const char *cgroup_path) {
+  const char *name = strrchr(cgroup_path, '/');
+  name = name ? name + 1 : cgroup_path;
+  if (name[0] == '\0' || ends_with(name, ".slice") || strncmp(name, "user@", 5) == 0 ||
+      (strncmp(name, "session-", 8) == 0 && ends_with(name, ".scope")))
+    return false;
+  DIR *directory = opendir(cgroup_directory);
+  if (!directory)
+    return false;
+  bool leaf = true;
+  struct dirent *entry;
+  while (leaf && (entry = readdir(directory))) {
+    if (entry->d_type == DT_DIR && strcmp(entry->d_name, ".") && strcmp(entry->d_name, ".."))
+      leaf = false;
+  }
+  closedir(directory);
+  return leaf;
+}
+
+// The quota is given over the default period of 100ms
+int cgroupinfo_set_cpu_quota(pid_t pid, unsigned cpus) {
+  const char *mount_point = cgroupinfo_mount_point();
+  if (!mount_point)
+    return ENOENT;
+  char *cgroup_path = read_process_cgroup_path(pid);
+  if (!cgroup_path)
+    return ESRCH;
+  char directory[PATH_MAX];
+  int written = snprintf(directory, sizeof(directory), "%s%s", mount_point, cgroup_path);
+  bool limited_to_process = written >= 0 && (size_t)written < sizeof(directory) &&
+                            cgroup_limited_to_process(directory, cgroup_path);
+  free(cgroup_path);
+  if (written < 0 || (size_t)written >= sizeof(directory))
+    return ENAMETOOLONG;
+  if (!limited_to_process)
+    return EPERM;
+  char path[sizeof(directory) + sizeof("/cpu.max")];
+  snprintf(path, sizeof(path), "%s/cpu.max", directory);
+  FILE *cpu_max = fopen(path, "w");
+  if (!cpu_max)
+    return errno;
+  if (cpus)
+    fprintf(cpu_max, "%u 100000\n", cpus * 100000);
+  else
+    fprintf(cpu_max, "max 100000\n");
+  // The kernel reports an invalid write when the buffer is flushed
+  int error = fflush(cpu_max) ? errno : 0;
+  if (fclose(cpu_max) && !error)
+    error = errno;
+  return error;
+}
+
+void cgroupinfo_clear(void) {
+  struct cgroup_process *process, *process_tmp;
+  HASH_ITER(hh, cgroup_processes, process, process_tmp) {
+    HASH_DEL(cgroup_processes, process);
+    free(process);
+  }
+  struct cgroup_entry *cgroup, *cgroup_tmp;
+  HASH_ITER(hh, cgroups, cgroup, cgroup_tmp) { free_cgroup(cgroup); }
+}
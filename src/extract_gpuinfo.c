@@ -20,15 +20,27 @@
  */
 
 #include <assert.h>
+#include <errno.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
+#include "nvtop/extract_bottleneck.h"
+#include "nvtop/extract_cgroupinfo.h"
 #include "nvtop/extract_gpuinfo.h"
 #include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/extract_job_ranks.h"
 #include "nvtop/extract_processinfo_fdinfo.h"
+#include "nvtop/extract_process_exits.h"
+#include "nvtop/extract_process_scope.h"
+#include "nvtop/extract_process_tree.h"
+#include "nvtop/extract_session_summary.h"
 #include "nvtop/get_process_info.h"
+#include "nvtop/process_table.h"
+#include "nvtop/sysfs.h"
 #include "nvtop/time.h"
 #include "uthash.h"
 
@@ -38,44 +50,388 @@
 #define HASH_ADD_PID(head, in_ptr)                                             \
   HASH_ADD(hh, head, pid, sizeof(pid_t), in_ptr)
 
+struct thread_cpu_time {
+  pid_t tid;
+  bool measured;
+  double last_total_time;
+  nvtop_time last_measurement_timestamp;
+};
+
 struct process_info_cache {
   pid_t pid;
+  pid_t parent_pid;
+  unsigned long long start_time; // Zero until read, tells reused pids apart
   char *cmdline;
   char *user_name;
   double last_total_consumed_cpu_time;
   nvtop_time last_measurement_timestamp;
+  // Thread breakdown, collected on request only. The task directory is listed
+  // again when the number of threads changes.
+  unsigned threads_listed_for;
+  unsigned threads_count;
+  struct thread_cpu_time *threads;
+  unsigned top_threads_refresh; // Refresh at which top_threads was computed
+  bool top_threads_valid;
+  struct gpuinfo_top_threads top_threads;
+  unsigned io_refresh; // Refresh at which the I/O rates were computed
+  bool io_measured, io_rates_valid;
+  struct process_io_usage last_io;
+  unsigned long long io_read_rate, io_write_rate;
+  unsigned affinity_refresh; // Refresh at which the affinity was read
+  bool affinity_valid;
+  struct process_affinity affinity;
+  const struct cgroup_info *cgroup; // Until the end of the refresh
+  unsigned descendants_refresh; // Refresh at which the descendants were walked
+  bool descendants_valid;
+  struct process_tree_usage descendants;
   UT_hash_handle hh;
 };
 
 struct process_info_cache *cached_process_info = NULL;
 struct process_info_cache *updated_process_info = NULL;
 
+struct process_device_key {
+  const struct gpu_info *device;
+  pid_t pid;
+};
+
+// Counters of a process on one device carried over between refreshes
+struct process_device_accounting {
+  struct process_device_key key;
+  bool engine_used_known;
+  uint64_t last_engine_used; // gfx + compute engine time in nanoseconds
+  double busy_time;          // Seconds of GPU time since the previous refresh
+  double energy_consumed;    // Joules attributed since the process appeared
+  struct gpu_time_window window;
+  double window_busy_time;   // Seconds of GPU time over the time share window
+  struct duty_cycle duty_cycle;
+  struct memory_trend memory_trend;
+  struct bottleneck_window bottleneck;
+  bool idle;                 // Held memory without using the GPU since the previous refresh
+  struct gpuinfo_stranded stranded;
+  UT_hash_handle hh;
+};
+
+static struct process_device_accounting *cached_accounting = NULL;
+static struct process_device_accounting *updated_accounting = NULL;
+static bool processes_refreshed = false;
+static nvtop_time last_processes_refresh;
+static unsigned processes_refresh_count = 0;
+
+static pid_t thread_breakdown_pid = -1;
+static bool thread_breakdown_all = false;
+static unsigned optional_process_info = 0;
+static unsigned time_share_window = 10;
+// Busy fraction of a refresh interval above which the engine is saturated
+static const double time_sliced_saturation = 0.9;
+static unsigned stranded_threshold = 5;
+
+// Scratch list of thread ids, reused across processes
+static unsigned scratch_tids_count, scratch_tids_capacity;
+static pid_t *scratch_tids = NULL;
+
+// Processes of all the devices, rebuilt by gpuinfo_refresh_processes
+static struct gpuinfo_process_table process_table;
+
 static LIST_HEAD(gpu_vendors);
 
 void register_gpu_vendor(struct gpu_vendor *vendor) {
   list_add(&vendor->list, &gpu_vendors);
 }
 
-bool gpuinfo_init_info_extraction(ssize_t mask, unsigned *devices_count,
-                                  struct list_head *devices) {
+// The vendors only register from their constructor. Referencing them keeps
+// their object files when linking against the static libnvtop.
+#ifdef NVTOP_HAS_NVIDIA
+extern struct gpu_vendor gpu_vendor_nvidia;
+#endif
+#ifdef NVTOP_HAS_AMDGPU
+extern struct gpu_vendor gpu_vendor_amdgpu;
+#endif
+__attribute__((used)) static struct gpu_vendor *const linked_gpu_vendors[] = {
+#ifdef NVTOP_HAS_NVIDIA
+    &gpu_vendor_nvidia,
+#endif
+#ifdef NVTOP_HAS_AMDGPU
+    &gpu_vendor_amdgpu,
+#endif
+    NULL,
+};
+
+void gpuinfo_read_pci_numa_info(int pci_device_dirfd, struct gpuinfo_static_info *static_info) {
+  char line[4096];
+  int numa_node;
+  // The kernel reports -1 on machines without NUMA
+  if (sysfs_read_line(pci_device_dirfd, "numa_node", line, sizeof(line)) && sscanf(line, "%d", &numa_node) == 1 &&
+      numa_node >= 0 && numa_node < CPU_MASK_MAX_ID)
+    SET_GPUINFO_STATIC(static_info, numa_node, (unsigned)numa_node);
+  if (sysfs_read_line(pci_device_dirfd, "local_cpulist", line, sizeof(line)) &&
+      cpu_mask_parse_list(line, &static_info->local_cpus) && !cpu_mask_is_empty(&static_info->local_cpus))
+    SET_VALID(gpuinfo_local_cpus_valid, static_info->valid);
+}
+
+#define DEVICE_MASK_WORD_BITS (CHAR_BIT * sizeof(uint64_t))
+
+void gpuinfo_device_mask_init(struct gpuinfo_device_mask *mask,
+                              bool select_by_default) {
+  mask->select_by_default = select_by_default;
+  mask->words_count = 0;
+  mask->words = NULL;
+  mask->next_device = 0;
+}
+
+void gpuinfo_device_mask_free(struct gpuinfo_device_mask *mask) {
+  free(mask->words);
+  mask->words = NULL;
+  mask->words_count = 0;
+}
+
+void gpuinfo_device_mask_set(struct gpuinfo_device_mask *mask,
+                             unsigned device_id, bool selected) {
+  unsigned word = device_id / DEVICE_MASK_WORD_BITS;
+  if (word >= mask->words_count) {
+    uint64_t *words = realloc(mask->words, (word + 1) * sizeof(*words));
+    if (!words) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    for (unsigned i = mask->words_count; i <= word; ++i)
+      words[i] = mask->select_by_default ? UINT64_MAX : 0;
+    mask->words = words;
+    mask->words_count = word + 1;
+  }
+  uint64_t bit = UINT64_C(1) << (device_id % DEVICE_MASK_WORD_BITS);
+  if (selected)
+    mask->words[word] |= bit;
+  else
+    mask->words[word] &= ~bit;
+}
+
+bool gpuinfo_device_mask_isset(const struct gpuinfo_device_mask *mask,
+                               unsigned device_id) {
+  unsigned word = device_id / DEVICE_MASK_WORD_BITS;
+  if (word >= mask->words_count)
+    return mask->select_by_default;
+  return (mask->words[word] >> (device_id % DEVICE_MASK_WORD_BITS)) & 1;
+}
+
+bool gpuinfo_device_mask_select_next(struct gpuinfo_device_mask *mask) {
+  return gpuinfo_device_mask_isset(mask, mask->next_device++);
+}
+
+// The vendors are initialized concurrently on background threads (e.g.,
+// nvmlInit can take seconds on large nodes). Their devices are collected in
+// the registration order to keep the device IDs stable.
+struct vendor_init_state {
   struct gpu_vendor *vendor;
+  pthread_t thread;
+  bool thread_started;
+  bool done;      // Protected by vendors_init.lock
+  bool success;   // Protected by vendors_init.lock
+  bool abandoned; // Protected by vendors_init.lock, the thread frees the state
+};
 
-  *devices_count = 0;
+static struct {
+  pthread_mutex_t lock;
+  pthread_cond_t vendor_done;
+  unsigned vendors_count;
+  unsigned next_to_collect;
+  struct vendor_init_state **vendors;
+  struct gpuinfo_device_mask *mask;
+} vendors_init = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .vendor_done = PTHREAD_COND_INITIALIZER,
+};
+
+static void *vendor_init_thread(void *arg) {
+  struct vendor_init_state *state = arg;
+  bool success = state->vendor->init();
+  pthread_mutex_lock(&vendors_init.lock);
+  state->success = success;
+  state->done = true;
+  state->vendor->init_in_flight = false;
+  bool abandoned = state->abandoned;
+  pthread_cond_broadcast(&vendors_init.vendor_done);
+  pthread_mutex_unlock(&vendors_init.lock);
+  if (abandoned)
+    free(state);
+  return NULL;
+}
+
+// Placeholders stand for the devices expected from a vendor still initializing
+static void placeholder_no_op(struct gpu_info *gpu_info) { (void)gpu_info; }
+
+static struct gpu_vendor gpu_vendor_placeholder = {
+    .populate_static_info = placeholder_no_op,
+    .refresh_dynamic_info = placeholder_no_op,
+    .refresh_running_processes = placeholder_no_op,
+};
+
+void gpuinfo_add_placeholder_devices(unsigned count, char *const names[],
+                                     struct list_head *devices) {
+  for (unsigned i = 0; i < count; ++i) {
+    struct gpu_info *placeholder = calloc(1, sizeof(*placeholder));
+    if (!placeholder) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    placeholder->vendor = &gpu_vendor_placeholder;
+    if (names && names[i] && names[i][0] != '\0') {
+      strncpy(placeholder->static_info.device_name, names[i],
+              MAX_DEVICE_NAME - 1);
+      SET_VALID(gpuinfo_device_name_valid, placeholder->static_info.valid);
+    }
+    list_add_tail(&placeholder->list, devices);
+  }
+}
+
+bool gpuinfo_is_placeholder_device(const struct gpu_info *device) {
+  return device->vendor == &gpu_vendor_placeholder;
+}
+
+bool gpuinfo_init_info_extraction_start(struct gpuinfo_device_mask *mask) {
+  struct gpu_vendor *vendor;
+
+  // An initialization abandoned by a previous shutdown must end before the
+  // vendor is initialized again
+  pthread_mutex_lock(&vendors_init.lock);
+  vendors_init.vendors_count = 0;
   list_for_each_entry(vendor, &gpu_vendors, list) {
-    unsigned vendor_devices_count = 0;
-
-    if (vendor->init()) {
-      bool retval = vendor->get_device_handles(
-          devices, &vendor_devices_count, &mask);
-      if (!retval || (retval && vendor_devices_count == 0)) {
-        vendor->shutdown();
-        vendor_devices_count = 0;
-      }
+    while (vendor->init_in_flight)
+      pthread_cond_wait(&vendors_init.vendor_done, &vendors_init.lock);
+    vendors_init.vendors_count++;
+  }
+  pthread_mutex_unlock(&vendors_init.lock);
+  vendors_init.vendors =
+      calloc(vendors_init.vendors_count, sizeof(*vendors_init.vendors));
+  if (vendors_init.vendors_count && !vendors_init.vendors) {
+    perror("Could not allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  vendors_init.next_to_collect = 0;
+  vendors_init.mask = mask;
+  mask->next_device = 0;
+
+  unsigned vendor_id = 0;
+  list_for_each_entry(vendor, &gpu_vendors, list) {
+    struct vendor_init_state *state = calloc(1, sizeof(*state));
+    if (!state) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    vendors_init.vendors[vendor_id++] = state;
+    state->vendor = vendor;
+    vendor->init_in_flight = true;
+    state->thread_started =
+        pthread_create(&state->thread, NULL, vendor_init_thread, state) == 0;
+    if (!state->thread_started) { // Initialize in place then
+      vendor->init_in_flight = false;
+      state->success = vendor->init();
+      state->done = true;
+    }
+  }
+  return true;
+}
+
+// Appends the devices of an initialized vendor and populates their static
+// information
+static unsigned gpuinfo_collect_vendor_devices(struct vendor_init_state *state,
+                                               struct list_head *devices) {
+  if (state->thread_started)
+    pthread_join(state->thread, NULL);
+  if (!state->success)
+    return 0;
+
+  unsigned vendor_devices_count = 0;
+  struct list_head *last_device = devices->prev;
+  bool retval = state->vendor->get_device_handles(
+      devices, &vendor_devices_count, vendors_init.mask);
+  if (!retval || vendor_devices_count == 0) {
+    state->vendor->shutdown();
+    return 0;
+  }
+  for (struct list_head *new_device = last_device->next; new_device != devices;
+       new_device = new_device->next) {
+    struct gpu_info *device = list_entry(new_device, struct gpu_info, list);
+    device->vendor->populate_static_info(device);
+  }
+  return vendor_devices_count;
+}
+
+static void free_placeholder_device(struct gpu_info *device) {
+  list_del(&device->list);
+  free(device);
+}
+
+bool gpuinfo_init_info_extraction_collect(int timeout_ms,
+                                          unsigned *devices_count,
+                                          struct list_head *devices) {
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  if (timeout_ms > 0) {
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+  }
+
+  // The placeholders stay at the end of the list while the devices are added
+  LIST_HEAD(placeholders);
+  struct gpu_info *device, *tmp;
+  list_for_each_entry_safe(device, tmp, devices, list) {
+    if (gpuinfo_is_placeholder_device(device)) {
+      list_del(&device->list);
+      list_add_tail(&device->list, &placeholders);
     }
+  }
+
+  unsigned added = 0;
+  pthread_mutex_lock(&vendors_init.lock);
+  while (vendors_init.next_to_collect < vendors_init.vendors_count) {
+    struct vendor_init_state *state =
+        vendors_init.vendors[vendors_init.next_to_collect];
+    if (!state->done) {
+      if (timeout_ms == 0)
+        break;
+      if (timeout_ms < 0)
+        pthread_cond_wait(&vendors_init.vendor_done, &vendors_init.lock);
+      else if (pthread_cond_timedwait(&vendors_init.vendor_done,
+                                      &vendors_init.lock,
+                                      &deadline) == ETIMEDOUT)
+        break;
+      continue;
+    }
+    pthread_mutex_unlock(&vendors_init.lock);
+    added += gpuinfo_collect_vendor_devices(state, devices);
+    pthread_mutex_lock(&vendors_init.lock);
+    vendors_init.next_to_collect++;
+  }
+  bool finished = vendors_init.next_to_collect == vendors_init.vendors_count;
+  pthread_mutex_unlock(&vendors_init.lock);
 
-    *devices_count += vendor_devices_count;
+  // Each new device takes the place of one placeholder
+  list_for_each_entry_safe(device, tmp, &placeholders, list) {
+    if (finished || added) {
+      free_placeholder_device(device);
+      if (added)
+        added--;
+    } else {
+      list_del(&device->list);
+      list_add_tail(&device->list, devices);
+    }
   }
 
+  *devices_count = 0;
+  list_for_each_entry(device, devices, list) { (*devices_count)++; }
+  return finished;
+}
+
+bool gpuinfo_init_info_extraction(struct gpuinfo_device_mask *mask,
+                                  unsigned *devices_count,
+                                  struct list_head *devices) {
+  gpuinfo_init_info_extraction_start(mask);
+  gpuinfo_init_info_extraction_collect(-1, devices_count, devices);
   return true;
 }
 
@@ -85,13 +441,44 @@ bool gpuinfo_shutdown_info_extraction(struct list_head *devices) {
 
   list_for_each_entry_safe(device, tmp, devices, list) {
     free(device->processes);
-    list_del(&device->list);
+    if (gpuinfo_is_placeholder_device(device))
+      free_placeholder_device(device);
+    else
+      list_del(&device->list);
   }
 
+  // A hung driver initialization must not block the exit: the vendors still
+  // initializing are left to their detached thread, which frees its state, and
+  // are not shut down
+  pthread_mutex_lock(&vendors_init.lock);
+  for (unsigned i = 0; i < vendors_init.vendors_count; ++i) {
+    struct vendor_init_state *state = vendors_init.vendors[i];
+    vendors_init.vendors[i] = NULL;
+    if (i >= vendors_init.next_to_collect && !state->done) {
+      pthread_detach(state->thread);
+      state->abandoned = true;
+      continue;
+    }
+    if (i >= vendors_init.next_to_collect && state->thread_started)
+      pthread_join(state->thread, NULL);
+    free(state);
+  }
   list_for_each_entry(vendor, &gpu_vendors, list) {
-    vendor->shutdown();
+    if (!vendor->init_in_flight)
+      vendor->shutdown();
   }
+  pthread_mutex_unlock(&vendors_init.lock);
+  free(vendors_init.vendors);
+  vendors_init.vendors = NULL;
+  vendors_init.vendors_count = 0;
+  vendors_init.next_to_collect = 0;
+  gpuinfo_process_table_free(&process_table);
   gpuinfo_clear_cache();
+  process_scope_clear();
+  process_tree_clear();
+  jobranks_clear();
+  session_summary_clear();
+  process_exits_clear();
   return true;
 }
 
@@ -104,9 +491,100 @@ bool gpuinfo_populate_static_infos(struct list_head *devices) {
   return true;
 }
 
+// Trapezoidal integration of the power draw between two refreshes. Gaps in
+// the power readings are not integrated. Returns the Joules added.
+static double gpuinfo_integrate_energy(struct gpu_info *device) {
+  struct gpuinfo_energy_counter *energy = &device->energy;
+  if (!GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, power_draw)) {
+    energy->sampling = false;
+    return 0.;
+  }
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  uint64_t now_ns = nvtop_time_u64(now);
+  unsigned power_draw = device->dynamic_info.power_draw;
+  double added = 0.;
+  if (energy->sampling)
+    added = (energy->last_power_draw + (double)power_draw) / 2000. * (now_ns - energy->last_sample) / 1e9;
+  energy->consumed += added;
+  energy->sampling = true;
+  energy->last_power_draw = power_draw;
+  energy->last_sample = now_ns;
+  return added;
+}
+
+void gpuinfo_set_stranded_threshold(unsigned percent) { stranded_threshold = percent; }
+
+// The device holds the memory of its processes while its utilization stays
+// under the threshold
+static void gpuinfo_sample_stranded(struct gpu_info *device, double energy) {
+  const struct gpuinfo_dynamic_info *dynamic_info = &device->dynamic_info;
+  bool idle = device->processes_count > 0 && GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, used_memory) &&
+              dynamic_info->used_memory > 0 && GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, gpu_util_rate) &&
+              dynamic_info->gpu_util_rate < stranded_threshold;
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  gpuinfo_stranded_update(&device->stranded, idle, nvtop_time_u64(now), energy);
+}
+
+static bool gpuinfo_free_memory(const struct gpu_info *device, double *free_memory) {
+  const struct gpuinfo_dynamic_info *dynamic_info = &device->dynamic_info;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, free_memory)) {
+    *free_memory = dynamic_info->free_memory;
+    return true;
+  }
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, total_memory) &&
+      GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, used_memory)) {
+    *free_memory = (double)dynamic_info->total_memory - (double)dynamic_info->used_memory;
+    return true;
+  }
+  return false;
+}
+
+static void gpuinfo_sample_free_memory(struct gpu_info *device) {
+  double free_memory;
+  if (!gpuinfo_free_memory(device, &free_memory))
+    return;
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  memory_trend_add_sample(&device->free_memory_trend, nvtop_time_u64(now), free_memory);
+}
+
+bool gpuinfo_time_to_full_memory(const struct gpu_info *device, double *seconds) {
+  double free_memory, slope;
+  if (!gpuinfo_free_memory(device, &free_memory) || !memory_trend_slope(&device->free_memory_trend, &slope) ||
+      slope >= 0.)
+    return false;
+  *seconds = free_memory > 0. ? free_memory / -slope : 0.;
+  return true;
+}
+
+// Without finer samples from the vendor, the device is seen busy or idle
+// for a whole refresh interval
+static void gpuinfo_sample_duty_cycle(struct gpu_info *device) {
+  if (device->duty_cycle_sampled || !GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate))
+    return;
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  duty_cycle_add_sample(&device->duty_cycle, nvtop_time_u64(now), device->dynamic_info.gpu_util_rate > 0);
+}
+
 bool gpuinfo_refresh_dynamic_info(struct list_head *devices) {
   struct gpu_info *device;
 
+  list_for_each_entry(device, devices, list) {
+    device->vendor->refresh_dynamic_info(device);
+    double energy = gpuinfo_integrate_energy(device);
+    gpuinfo_sample_duty_cycle(device);
+    gpuinfo_sample_free_memory(device);
+    gpuinfo_sample_stranded(device, energy);
+  }
+  return true;
+}
+
+bool gpuinfo_sample_dynamic_info(struct list_head *devices) {
+  struct gpu_info *device;
+
   list_for_each_entry(device, devices, list) {
     device->vendor->refresh_dynamic_info(device);
   }
@@ -158,6 +636,163 @@ bool gpuinfo_fix_dynamic_info_from_process_info(struct list_head *devices) {
 }
 #undef MYMIN
 
+void gpuinfo_set_thread_breakdown(pid_t pid, bool all_processes) {
+  thread_breakdown_pid = pid;
+  thread_breakdown_all = all_processes;
+}
+
+void gpuinfo_set_optional_process_info(unsigned info_mask) { optional_process_info = info_mask; }
+
+void gpuinfo_set_time_share_window(unsigned seconds) {
+  if (seconds < 1)
+    seconds = 1;
+  if (seconds > GPU_TIME_SHARE_MAX_WINDOW)
+    seconds = GPU_TIME_SHARE_MAX_WINDOW;
+  time_share_window = seconds;
+}
+
+static void refresh_process_io(struct process_info_cache *cached) {
+  struct process_io_usage io;
+  cached->io_rates_valid = false;
+  if (!get_process_io(cached->pid, &io)) {
+    cached->io_measured = false;
+    return;
+  }
+  if (cached->io_measured) {
+    double elapsed = nvtop_difftime(cached->last_io.timestamp, io.timestamp);
+    if (elapsed > 0. && io.read_bytes >= cached->last_io.read_bytes &&
+        io.write_bytes >= cached->last_io.write_bytes) {
+      cached->io_read_rate = (unsigned long long)((io.read_bytes - cached->last_io.read_bytes) / elapsed);
+      cached->io_write_rate = (unsigned long long)((io.write_bytes - cached->last_io.write_bytes) / elapsed);
+      cached->io_rates_valid = true;
+    }
+  }
+  cached->io_measured = true;
+  cached->last_io = io;
+}
+
+// A process is remote when it may only run, or only allocate, away from the
+// device. Memory is judged on the node alone since sysfs lists no other.
+static bool gpuinfo_numa_placement_of(const struct gpuinfo_static_info *static_info,
+                                      const struct process_affinity *affinity,
+                                      enum gpuinfo_numa_placement *placement) {
+  bool cpus_known = GPUINFO_STATIC_FIELD_VALID(static_info, local_cpus);
+  bool mems_known = GPUINFO_STATIC_FIELD_VALID(static_info, numa_node);
+  if (!cpus_known && !mems_known)
+    return false;
+  bool local = true;
+  if (cpus_known) {
+    if (!cpu_mask_intersects(&affinity->cpus_allowed, &static_info->local_cpus)) {
+      *placement = gpuinfo_numa_remote;
+      return true;
+    }
+    local = cpu_mask_is_subset(&affinity->cpus_allowed, &static_info->local_cpus);
+  }
+  if (mems_known) {
+    if (!cpu_mask_is_set(&affinity->mems_allowed, static_info->numa_node)) {
+      *placement = gpuinfo_numa_remote;
+      return true;
+    }
+    struct cpu_mask device_node;
+    memset(&device_node, 0, sizeof(device_node));
+    device_node.bits[static_info->numa_node / 64] = UINT64_C(1) << (static_info->numa_node % 64);
+    local = local && cpu_mask_is_subset(&affinity->mems_allowed, &device_node);
+  }
+  *placement = local ? gpuinfo_numa_local : gpuinfo_numa_spread;
+  return true;
+}
+
+static void free_process_info_cache(struct process_info_cache *cached) {
+  free(cached->cmdline);
+  free(cached->user_name);
+  free(cached->threads);
+  free(cached);
+}
+
+static void list_process_threads(struct process_info_cache *cached, unsigned num_threads) {
+  if (!get_process_thread_ids(cached->pid, &scratch_tids_count, &scratch_tids_capacity, &scratch_tids))
+    scratch_tids_count = 0;
+  struct thread_cpu_time *threads = calloc(scratch_tids_count ? scratch_tids_count : 1, sizeof(*threads));
+  if (!threads) {
+    perror("Could not allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  // Keep the measurements of the threads still alive
+  for (unsigned i = 0; i < scratch_tids_count; ++i) {
+    threads[i].tid = scratch_tids[i];
+    for (unsigned j = 0; j < cached->threads_count; ++j) {
+      if (cached->threads[j].tid == scratch_tids[i]) {
+        threads[i] = cached->threads[j];
+        break;
+      }
+    }
+  }
+  free(cached->threads);
+  cached->threads = threads;
+  cached->threads_count = scratch_tids_count;
+  cached->threads_listed_for = num_threads;
+}
+
+static bool refresh_top_threads(struct process_info_cache *cached, unsigned num_threads) {
+  if (num_threads != cached->threads_listed_for)
+    list_process_threads(cached, num_threads);
+  struct gpuinfo_top_threads *top = &cached->top_threads;
+  top->count = 0;
+  bool measured = false;
+  for (unsigned i = 0; i < cached->threads_count; ++i) {
+    struct thread_cpu_time *thread = &cached->threads[i];
+    struct thread_cpu_usage usage;
+    if (!get_thread_info(cached->pid, thread->tid, &usage)) {
+      // Exited thread, listed again at the next change of the thread count
+      thread->measured = false;
+      continue;
+    }
+    bool had_measurement = thread->measured;
+    double elapsed = nvtop_difftime(thread->last_measurement_timestamp, usage.timestamp);
+    unsigned cpu_usage = 0;
+    if (had_measurement && elapsed > 0.)
+      cpu_usage = (unsigned)lround(100. * (usage.total_time - thread->last_total_time) / elapsed);
+    thread->measured = true;
+    thread->last_total_time = usage.total_time;
+    thread->last_measurement_timestamp = usage.timestamp;
+    if (!had_measurement)
+      continue;
+    measured = true;
+    // Insertion into the few busiest threads
+    unsigned position = top->count;
+    while (position > 0 && top->threads[position - 1].cpu_usage < cpu_usage)
+      position--;
+    if (position >= GPUINFO_TOP_THREADS)
+      continue;
+    unsigned last = top->count < GPUINFO_TOP_THREADS ? top->count : GPUINFO_TOP_THREADS - 1;
+    for (unsigned j = last; j > position; --j)
+      top->threads[j] = top->threads[j - 1];
+    strcpy(top->threads[position].name, usage.name);
+    top->threads[position].cpu_usage = cpu_usage;
+    if (top->count < GPUINFO_TOP_THREADS)
+      top->count++;
+  }
+  return measured;
+}
+
+static void forget_process_threads(struct process_info_cache *cached) {
+  cached->threads_count = 0;
+  cached->threads_listed_for = 0;
+  cached->top_threads_valid = false;
+}
+
+static void gpuinfo_derive_cgroup_info(unsigned row, const struct cgroup_info *cgroup) {
+  SET_GPUINFO_PROCESS_TABLE(&process_table, row, cgroup, gpuinfo_process_table_intern(&process_table, cgroup->path));
+  if (CGROUPINFO_FIELD_VALID(cgroup, cpu_pressure))
+    SET_GPUINFO_PROCESS_TABLE(&process_table, row, cpu_pressure, cgroup->cpu_pressure);
+  if (CGROUPINFO_FIELD_VALID(cgroup, memory_pressure))
+    SET_GPUINFO_PROCESS_TABLE(&process_table, row, memory_pressure, cgroup->memory_pressure);
+  if (CGROUPINFO_FIELD_VALID(cgroup, io_pressure))
+    SET_GPUINFO_PROCESS_TABLE(&process_table, row, io_pressure, cgroup->io_pressure);
+  if (CGROUPINFO_FIELD_VALID(cgroup, cpu_throttled))
+    SET_GPUINFO_PROCESS_TABLE(&process_table, row, cpu_throttled, cgroup->cpu_throttled);
+}
+
 static void gpuinfo_populate_process_info(struct gpu_info *device) {
   for (unsigned j = 0; j < device->processes_count; ++j) {
     pid_t current_pid = device->processes[j].pid;
@@ -202,10 +837,48 @@ static void gpuinfo_populate_process_info(struct gpu_info *device) {
       }
       SET_GPUINFO_PROCESS(&device->processes[j], cpu_memory_res, cpu_usage.resident_memory);
       SET_GPUINFO_PROCESS(&device->processes[j], cpu_memory_virt, cpu_usage.virtual_memory);
+      cached_pid_info->parent_pid = cpu_usage.parent_pid;
+      cached_pid_info->start_time = cpu_usage.start_time;
       cached_pid_info->last_measurement_timestamp = cpu_usage.timestamp;
       cached_pid_info->last_total_consumed_cpu_time = cpu_usage.total_kernel_time + cpu_usage.total_user_time;
+
+      if (thread_breakdown_all || current_pid == thread_breakdown_pid ||
+          (optional_process_info & gpuinfo_optional_bottleneck)) {
+        // A process using several devices is only measured once per refresh
+        if (cached_pid_info->top_threads_refresh != processes_refresh_count) {
+          cached_pid_info->top_threads_refresh = processes_refresh_count;
+          cached_pid_info->top_threads_valid = refresh_top_threads(cached_pid_info, cpu_usage.num_threads);
+        }
+      } else {
+        forget_process_threads(cached_pid_info);
+      }
+
+      cached_pid_info->cgroup = optional_process_info & gpuinfo_optional_cgroup
+                                    ? cgroupinfo_of_process(current_pid, cpu_usage.start_time)
+                                    : NULL;
     } else {
       cached_pid_info->last_total_consumed_cpu_time = -1;
+      cached_pid_info->top_threads_valid = false;
+      cached_pid_info->cgroup = NULL;
+    }
+
+    if (optional_process_info & gpuinfo_optional_io) {
+      if (cached_pid_info->io_refresh != processes_refresh_count) {
+        cached_pid_info->io_refresh = processes_refresh_count;
+        refresh_process_io(cached_pid_info);
+      }
+    } else {
+      cached_pid_info->io_measured = false;
+      cached_pid_info->io_rates_valid = false;
+    }
+
+    if (optional_process_info & gpuinfo_optional_numa) {
+      if (cached_pid_info->affinity_refresh != processes_refresh_count) {
+        cached_pid_info->affinity_refresh = processes_refresh_count;
+        cached_pid_info->affinity_valid = get_process_affinity(current_pid, &cached_pid_info->affinity);
+      }
+    } else {
+      cached_pid_info->affinity_valid = false;
     }
 
     // Process memory usage percent of total device memory
@@ -219,13 +892,273 @@ static void gpuinfo_populate_process_info(struct gpu_info *device) {
   }
 }
 
+// The measurements kept in the process cache go to the table rows of the device
+static void gpuinfo_derive_process_info(struct gpu_info *device, unsigned first_row) {
+  for (unsigned j = 0; j < device->processes_count; ++j) {
+    unsigned row = first_row + j;
+    struct process_info_cache *cached;
+    HASH_FIND_PID(updated_process_info, &device->processes[j].pid, cached);
+    if (!cached)
+      continue;
+    if (cached->top_threads_valid)
+      SET_GPUINFO_PROCESS_TABLE(&process_table, row, top_threads, cached->top_threads);
+    if (cached->cgroup)
+      gpuinfo_derive_cgroup_info(row, cached->cgroup);
+    if (cached->io_rates_valid) {
+      SET_GPUINFO_PROCESS_TABLE(&process_table, row, io_read_rate, cached->io_read_rate);
+      SET_GPUINFO_PROCESS_TABLE(&process_table, row, io_write_rate, cached->io_write_rate);
+    }
+    enum gpuinfo_numa_placement placement;
+    if (cached->affinity_valid && gpuinfo_numa_placement_of(&device->static_info, &cached->affinity, &placement))
+      SET_GPUINFO_PROCESS_TABLE(&process_table, row, numa_placement, placement);
+  }
+}
+
+static unsigned long long gpuinfo_process_start_time(struct process_info_cache *cache, pid_t pid) {
+  struct process_info_cache *cached;
+  HASH_FIND_PID(cache, &pid, cached);
+  return cached ? cached->start_time : 0;
+}
+
+static bool gpuinfo_has_own_row(pid_t pid) {
+  struct process_info_cache *cached;
+  HASH_FIND_PID(updated_process_info, &pid, cached);
+  return cached != NULL;
+}
+
+// Runs once every device listed its processes, so that the descendants using
+// a GPU themselves are left to their own row
+static void gpuinfo_roll_up_descendants(unsigned row) {
+  struct gpuinfo_process_table *table = &process_table;
+  struct process_info_cache *cached;
+  HASH_FIND_PID(updated_process_info, &table->pid[row], cached);
+  if (!cached)
+    return;
+  if (cached->descendants_refresh != processes_refresh_count) {
+    cached->descendants_refresh = processes_refresh_count;
+    cached->descendants_valid =
+        process_tree_descendants_usage(table->pid[row], gpuinfo_has_own_row, &cached->descendants);
+  }
+  if (!cached->descendants_valid)
+    return;
+  const struct process_tree_usage *descendants = &cached->descendants;
+  SET_GPUINFO_PROCESS_TABLE(table, row, descendants, descendants->descendants_count);
+  if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, cpu_usage))
+    table->cpu_usage[row] += (unsigned)lround(descendants->cpu_usage);
+  if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, cpu_memory_res))
+    table->cpu_memory_res[row] += descendants->resident_memory;
+  if (descendants->io_rates_valid && GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, io_read_rate)) {
+    table->io_read_rate[row] += descendants->io_read_rate;
+    table->io_write_rate[row] += descendants->io_write_rate;
+  }
+}
+
+static struct process_device_accounting *
+gpuinfo_find_accounting(struct process_device_accounting *head,
+                        const struct gpu_info *device, pid_t pid) {
+  struct process_device_key key;
+  memset(&key, 0, sizeof(key));
+  key.device = device;
+  key.pid = pid;
+  struct process_device_accounting *accounting;
+  HASH_FIND(hh, head, &key, sizeof(key), accounting);
+  return accounting;
+}
+
+// GPU time the process kept the device busy since the previous refresh. The
+// engine counters are used when the driver exposes them, the utilization
+// sampled over the refresh interval otherwise.
+static bool gpuinfo_process_busy_time(const struct gpu_process *process,
+                                      struct process_device_accounting *accounting,
+                                      double interval, double *busy_time) {
+  bool gfx_valid = GPUINFO_PROCESS_FIELD_VALID(process, gfx_engine_used);
+  bool compute_valid = GPUINFO_PROCESS_FIELD_VALID(process, compute_engine_used);
+  if (gfx_valid || compute_valid) {
+    uint64_t engine_used = (gfx_valid ? process->gfx_engine_used : 0) +
+                           (compute_valid ? process->compute_engine_used : 0);
+    bool known = accounting->engine_used_known && engine_used >= accounting->last_engine_used;
+    if (known)
+      *busy_time = (engine_used - accounting->last_engine_used) / 1e9;
+    accounting->engine_used_known = true;
+    accounting->last_engine_used = engine_used;
+    return known;
+  }
+  if (GPUINFO_PROCESS_FIELD_VALID(process, gpu_usage) && interval > 0.) {
+    *busy_time = process->gpu_usage / 100. * interval;
+    return true;
+  }
+  return false;
+}
+
+static void gpu_time_window_add(struct gpu_time_window *window, uint64_t second, double busy_time) {
+  if (second > window->last_second) {
+    uint64_t elapsed = second - window->last_second;
+    if (elapsed > GPU_TIME_SHARE_MAX_WINDOW)
+      elapsed = GPU_TIME_SHARE_MAX_WINDOW;
+    for (uint64_t i = 1; i <= elapsed; ++i)
+      window->busy_time[(second - elapsed + i) % GPU_TIME_SHARE_MAX_WINDOW] = 0.;
+    window->last_second = second;
+  }
+  window->busy_time[second % GPU_TIME_SHARE_MAX_WINDOW] += busy_time;
+}
+
+static double gpu_time_window_sum(const struct gpu_time_window *window, unsigned seconds) {
+  double sum = 0.;
+  for (unsigned i = 0; i < seconds && i <= window->last_second; ++i)
+    sum += window->busy_time[(window->last_second - i) % GPU_TIME_SHARE_MAX_WINDOW];
+  return sum;
+}
+
+// The vendors reporting their processes directly (e.g., NVML) ignore the
+// scope, so their processes are dropped before reading anything about them
+static void gpuinfo_drop_unscoped_processes(struct gpu_info *device) {
+  if (!process_scope_active())
+    return;
+  unsigned kept = 0;
+  for (unsigned i = 0; i < device->processes_count; ++i) {
+    if (process_scope_contains(device->processes[i].pid))
+      device->processes[kept++] = device->processes[i];
+  }
+  device->processes_count = kept;
+}
+
+// The device energy spent since the previous refresh is shared among its
+// processes in proportion to the GPU time each of them used. The GPU time is
+// also summed over the time share window and feeds the idle gaps of the
+// processes. While the device is idle, its energy is charged to the idle
+// processes in proportion to the memory they hold.
+static void gpuinfo_account_processes(struct gpu_info *device, unsigned first_row, double interval) {
+  double total_busy_time = 0., window_busy_time = 0., idle_memory = 0.;
+  unsigned busy_processes = 0;
+  for (unsigned j = 0; j < device->processes_count; ++j) {
+    struct gpu_process *process = &device->processes[j];
+    struct process_device_accounting *accounting =
+        gpuinfo_find_accounting(updated_accounting, device, process->pid);
+    // The same process can be listed more than once per device
+    if (accounting)
+      continue;
+    accounting = gpuinfo_find_accounting(cached_accounting, device, process->pid);
+    if (accounting) {
+      HASH_DEL(cached_accounting, accounting);
+    } else {
+      accounting = calloc(1, sizeof(*accounting));
+      if (!accounting) {
+        perror("Could not allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+      accounting->key.device = device;
+      accounting->key.pid = process->pid;
+    }
+    HASH_ADD(hh, updated_accounting, key, sizeof(accounting->key), accounting);
+    accounting->busy_time = 0.;
+    accounting->idle = false;
+    if (gpuinfo_process_busy_time(process, accounting, interval, &accounting->busy_time)) {
+      total_busy_time += accounting->busy_time;
+      if (accounting->busy_time > 0.)
+        busy_processes++;
+      duty_cycle_add_sample(&accounting->duty_cycle, nvtop_time_u64(last_processes_refresh),
+                            accounting->busy_time > 0.);
+      accounting->idle = interval > 0. && GPUINFO_PROCESS_FIELD_VALID(process, gpu_memory_usage) &&
+                         process->gpu_memory_usage > 0 &&
+                         100. * accounting->busy_time / interval < stranded_threshold;
+      if (accounting->idle)
+        idle_memory += process->gpu_memory_usage;
+    }
+    session_summary_record_process(process, gpuinfo_process_start_time(updated_process_info, process->pid),
+                                   accounting->busy_time);
+    double memory_growth;
+    if (GPUINFO_PROCESS_FIELD_VALID(process, gpu_memory_usage)) {
+      memory_trend_add_sample(&accounting->memory_trend, nvtop_time_u64(last_processes_refresh),
+                              process->gpu_memory_usage);
+      if (memory_trend_slope(&accounting->memory_trend, &memory_growth))
+        SET_GPUINFO_PROCESS_TABLE(&process_table, first_row + j, gpu_memory_growth, memory_growth);
+    }
+    enum gpuinfo_bottleneck bottleneck;
+    if (optional_process_info & gpuinfo_optional_bottleneck) {
+      bottleneck_window_add(&accounting->bottleneck, device, &process_table, first_row + j);
+      if (bottleneck_window_classify(&accounting->bottleneck, &bottleneck))
+        SET_GPUINFO_PROCESS_TABLE(&process_table, first_row + j, bottleneck, bottleneck);
+    }
+    gpu_time_window_add(&accounting->window, (uint64_t)last_processes_refresh.tv_sec, accounting->busy_time);
+    accounting->window_busy_time = gpu_time_window_sum(&accounting->window, time_share_window);
+    window_busy_time += accounting->window_busy_time;
+  }
+
+  // The oldest second of the window is whole, the current one is not over
+  struct gpuinfo_time_share *time_share = &device->time_share;
+  if (!time_share->valid) {
+    time_share->valid = true;
+    time_share->since = nvtop_time_u64(last_processes_refresh);
+  }
+  time_share->window = time_share_window - 1 + last_processes_refresh.tv_nsec / 1e9;
+  double accounted = (nvtop_time_u64(last_processes_refresh) - time_share->since) / 1e9;
+  if (accounted < time_share->window)
+    time_share->window = accounted;
+  bool saturated = interval > 0. && (total_busy_time >= time_sliced_saturation * interval ||
+                                     (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate) &&
+                                      device->dynamic_info.gpu_util_rate >= 100. * time_sliced_saturation));
+  gpu_time_window_add(&time_share->history, (uint64_t)last_processes_refresh.tv_sec,
+                      saturated && busy_processes > 1 ? interval : 0.);
+  time_share->sliced = gpu_time_window_sum(&time_share->history, time_share_window);
+  if (time_share->sliced > time_share->window)
+    time_share->sliced = time_share->window;
+
+  double energy = device->energy.consumed - device->energy.attributed;
+  device->energy.attributed = device->energy.consumed;
+  for (unsigned j = 0; j < device->processes_count; ++j) {
+    struct gpu_process *process = &device->processes[j];
+    unsigned row = first_row + j;
+    struct process_device_accounting *accounting =
+        gpuinfo_find_accounting(updated_accounting, device, process->pid);
+    double share = total_busy_time > 0. ? energy * accounting->busy_time / total_busy_time : 0.;
+    accounting->energy_consumed += share;
+    accounting->busy_time = 0.;
+    // Updated once for the processes listed more than once
+    uint64_t now = nvtop_time_u64(last_processes_refresh);
+    if (accounting->stranded.last_update != now) {
+      double idle_share = accounting->idle && device->stranded.idle && idle_memory > 0.
+                              ? energy * process->gpu_memory_usage / idle_memory
+                              : 0.;
+      double stranded_energy = accounting->stranded.energy;
+      gpuinfo_stranded_update(&accounting->stranded, accounting->idle, now, idle_share);
+      session_summary_record_stranded(process->pid, gpuinfo_process_start_time(updated_process_info, process->pid),
+                                      &accounting->stranded, device->energy.sampling,
+                                      accounting->stranded.energy - stranded_energy);
+    }
+    double stranded_time;
+    if (gpuinfo_stranded_duration(&accounting->stranded, &stranded_time))
+      SET_GPUINFO_PROCESS_TABLE(&process_table, row, stranded_time, stranded_time);
+    if (window_busy_time > 0.)
+      SET_GPUINFO_PROCESS_TABLE(&process_table, row, gpu_time_share,
+                                (unsigned)lround(100. * accounting->window_busy_time / window_busy_time));
+    struct gpuinfo_idle_gaps idle_gaps;
+    if (duty_cycle_percentiles(&accounting->duty_cycle.gaps, &idle_gaps.median, &idle_gaps.p95))
+      SET_GPUINFO_PROCESS_TABLE(&process_table, row, idle_gaps, idle_gaps);
+    if (!device->energy.sampling)
+      continue;
+    SET_GPUINFO_PROCESS_TABLE(&process_table, row, energy_consumed, accounting->energy_consumed);
+    if (accounting->stranded.energy > 0.)
+      SET_GPUINFO_PROCESS_TABLE(&process_table, row, idle_energy, accounting->stranded.energy);
+    if (interval > 0.)
+      SET_GPUINFO_PROCESS_TABLE(&process_table, row, power_draw, (unsigned)(share / interval * 1000.));
+  }
+}
+
+static void gpuinfo_clean_old_accounting(void) {
+  struct process_device_accounting *accounting, *tmp;
+  HASH_ITER(hh, cached_accounting, accounting, tmp) {
+    HASH_DEL(cached_accounting, accounting);
+    free(accounting);
+  }
+  cached_accounting = updated_accounting;
+  updated_accounting = NULL;
+}
+
 static void gpuinfo_clean_old_cache(void) {
   struct process_info_cache *pid_not_encountered, *tmp;
   HASH_ITER(hh, cached_process_info, pid_not_encountered, tmp) {
     HASH_DEL(cached_process_info, pid_not_encountered);
-    free(pid_not_encountered->cmdline);
-    free(pid_not_encountered->user_name);
-    free(pid_not_encountered);
+    free_process_info_cache(pid_not_encountered);
   }
   cached_process_info = updated_process_info;
   updated_process_info = NULL;
@@ -237,25 +1170,115 @@ bool gpuinfo_refresh_processes(struct list_head *devices) {
   list_for_each_entry(device, devices, list) { device->processes_count = 0; }
 
   // Go through the /proc hierarchy once and populate the processes for all registered GPUs
+  process_scope_refresh();
   processinfo_sweep_fdinfos();
 
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  double interval = processes_refreshed ? nvtop_difftime(last_processes_refresh, now) : 0.;
+  processes_refreshed = true;
+  last_processes_refresh = now;
+  processes_refresh_count++;
+  session_summary_begin_process_refresh();
+
+  cgroupinfo_begin_refresh();
+  process_tree_begin_refresh(optional_process_info & gpuinfo_optional_io);
   list_for_each_entry(device, devices, list) {
     device->vendor->refresh_running_processes(device);
+    gpuinfo_drop_unscoped_processes(device);
     gpuinfo_populate_process_info(device);
   }
+  // The derived information goes straight into the table
+  gpuinfo_process_table_fill(&process_table, devices);
+  unsigned first_row = 0;
+  list_for_each_entry(device, devices, list) {
+    gpuinfo_derive_process_info(device, first_row);
+    gpuinfo_account_processes(device, first_row, interval);
+    first_row += device->processes_count;
+  }
+  if (optional_process_info & gpuinfo_optional_descendants) {
+    for (unsigned row = 0; row < process_table.count; ++row)
+      gpuinfo_roll_up_descendants(row);
+  }
+  if (optional_process_info & gpuinfo_optional_stragglers) {
+    jobranks_begin_refresh(&process_table);
+    first_row = 0;
+    list_for_each_entry(device, devices, list) {
+      for (unsigned j = 0; j < device->processes_count; ++j) {
+        struct process_info_cache *cached;
+        HASH_FIND_PID(updated_process_info, &device->processes[j].pid, cached);
+        jobranks_add_process(device, first_row + j, cached ? cached->parent_pid : 0);
+      }
+      first_row += device->processes_count;
+    }
+    jobranks_end_refresh();
+  }
+  for (unsigned row = 0; row < process_table.count; ++row)
+    process_exits_track(process_table.pid[row]);
+  process_exits_end_refresh();
+  cgroupinfo_end_refresh();
+  process_tree_end_refresh();
   gpuinfo_clean_old_cache();
+  gpuinfo_clean_old_accounting();
 
   return true;
 }
 
+bool gpuinfo_process_exits_watched(void) { return process_exits_watched(); }
+
+// The last readings of an exited process are final, it leaves the devices and
+// the caches right away
+static void gpuinfo_finalize_exited_process(struct list_head *devices, pid_t pid) {
+  session_summary_process_exited(pid, gpuinfo_process_start_time(cached_process_info, pid));
+  struct gpu_info *device;
+  list_for_each_entry(device, devices, list) {
+    unsigned kept = 0;
+    for (unsigned i = 0; i < device->processes_count; ++i) {
+      if (device->processes[i].pid != pid)
+        device->processes[kept++] = device->processes[i];
+    }
+    device->processes_count = kept;
+    struct process_device_accounting *accounting = gpuinfo_find_accounting(cached_accounting, device, pid);
+    if (accounting) {
+      HASH_DEL(cached_accounting, accounting);
+      free(accounting);
+    }
+  }
+  struct process_info_cache *cached;
+  HASH_FIND_PID(cached_process_info, &pid, cached);
+  if (cached) {
+    HASH_DEL(cached_process_info, cached);
+    free_process_info_cache(cached);
+  }
+}
+
+bool gpuinfo_wait_process_exits(struct list_head *devices, int input_fd, int timeout_ms) {
+  const pid_t *exited;
+  unsigned exited_count = process_exits_wait(input_fd, timeout_ms, &exited);
+  for (unsigned i = 0; i < exited_count; ++i) {
+    gpuinfo_finalize_exited_process(devices, exited[i]);
+    gpuinfo_process_table_remove_pid(&process_table, exited[i]);
+  }
+  return exited_count > 0;
+}
+
+const struct gpuinfo_process_table *gpuinfo_get_process_table(void) {
+  return &process_table;
+}
+
 void gpuinfo_clear_cache(void) {
   if (cached_process_info) {
     struct process_info_cache *pid_cached, *tmp;
     HASH_ITER(hh, cached_process_info, pid_cached, tmp) {
       HASH_DEL(cached_process_info, pid_cached);
-      free(pid_cached->cmdline);
-      free(pid_cached->user_name);
-      free(pid_cached);
+      free_process_info_cache(pid_cached);
     }
   }
+  cgroupinfo_clear();
+  free(scratch_tids);
+  scratch_tids = NULL;
+  scratch_tids_count = scratch_tids_capacity = 0;
+  // The first call makes the entries of the last refresh stale
+  gpuinfo_clean_old_accounting();
+  gpuinfo_clean_old_accounting();
 }
@@ -22,6 +22,7 @@
  */
 
 #include "nvtop/common.h"
+#include "nvtop/device_tuning.h"
 #include "nvtop/extract_gpuinfo_common.h"
 #include "nvtop/extract_processinfo_fdinfo.h"
 #include "nvtop/time.h"
@@ -139,10 +140,12 @@ static void gpuinfo_amdgpu_shutdown(void);
 static const char *gpuinfo_amdgpu_last_error_string(void);
 static bool gpuinfo_amdgpu_get_device_handles(
     struct list_head *devices, unsigned *count,
-    ssize_t *mask);
+    struct gpuinfo_device_mask *mask);
 static void gpuinfo_amdgpu_populate_static_info(struct gpu_info *_gpu_info);
 static void gpuinfo_amdgpu_refresh_dynamic_info(struct gpu_info *_gpu_info);
 static void gpuinfo_amdgpu_get_running_processes(struct gpu_info *_gpu_info);
+static void gpuinfo_amdgpu_get_tuning(struct gpu_info *_gpu_info, struct gpuinfo_tuning *tuning);
+static bool gpuinfo_amdgpu_set_tuning(struct gpu_info *_gpu_info, enum gpuinfo_tuning_knob_id knob, int value);
 
 struct gpu_vendor gpu_vendor_amdgpu = {
     .init = gpuinfo_amdgpu_init,
@@ -152,6 +155,8 @@ struct gpu_vendor gpu_vendor_amdgpu = {
     .populate_static_info = gpuinfo_amdgpu_populate_static_info,
     .refresh_dynamic_info = gpuinfo_amdgpu_refresh_dynamic_info,
     .refresh_running_processes = gpuinfo_amdgpu_get_running_processes,
+    .get_tuning = gpuinfo_amdgpu_get_tuning,
+    .set_tuning = gpuinfo_amdgpu_set_tuning,
 };
 
 __attribute__((constructor))
@@ -350,7 +355,7 @@ static void initDeviceSysfsPaths(struct gpu_info_amdgpu *gpu_info) {
 
 static bool gpuinfo_amdgpu_get_device_handles(
     struct list_head *devices, unsigned *count,
-    ssize_t *mask) {
+    struct gpuinfo_device_mask *mask) {
   if (!libdrm_handle)
     return false;
 
@@ -407,13 +412,11 @@ static bool gpuinfo_amdgpu_get_device_handles(
       continue;
     }
 
-    if ((*mask & 1) == 0) {
-      *mask >>= 1;
+    if (!gpuinfo_device_mask_select_next(mask)) {
       _drmFreeVersion(ver);
       close(fd);
       continue;
     }
-    *mask >>= 1;
 
     authenticate_drm(fd);
 
@@ -700,6 +703,13 @@ static void gpuinfo_amdgpu_populate_static_info(struct gpu_info *_gpu_info) {
       SET_GPUINFO_STATIC(static_info, max_pcie_gen, pcieGen);
     }
   }
+
+  strncpy(static_info->pdev, gpu_info->pdev, sizeof(static_info->pdev) - 1);
+  static_info->pdev[sizeof(static_info->pdev) - 1] = '\0';
+  SET_VALID(gpuinfo_pdev_valid, static_info->valid);
+
+  if (gpu_info->sysfsFD >= 0)
+    gpuinfo_read_pci_numa_info(gpu_info->sysfsFD, static_info);
   // Open current link speed
   gpu_info->PCIeDPM = NULL;
   int pcieDPMFD = openat(gpu_info->sysfsFD, "pp_dpm_pcie", O_RDONLY);
@@ -1112,3 +1122,16 @@ static void gpuinfo_amdgpu_get_running_processes(struct gpu_info *_gpu_info) {
   struct gpu_info_amdgpu *gpu_info = container_of(_gpu_info, struct gpu_info_amdgpu, base);
   swap_process_cache_for_next_update(gpu_info);
 }
+
+static void gpuinfo_amdgpu_get_tuning(struct gpu_info *_gpu_info, struct gpuinfo_tuning *tuning) {
+  struct gpu_info_amdgpu *gpu_info = container_of(_gpu_info, struct gpu_info_amdgpu, base);
+  tuning_read_amdgpu_sysfs(gpu_info->sysfsFD, tuning);
+}
+
+static bool gpuinfo_amdgpu_set_tuning(struct gpu_info *_gpu_info, enum gpuinfo_tuning_knob_id knob, int value) {
+  struct gpu_info_amdgpu *gpu_info = container_of(_gpu_info, struct gpu_info_amdgpu, base);
+  if (tuning_write_amdgpu_sysfs(gpu_info->sysfsFD, knob, value))
+    return true;
+  local_error_string = strerror(errno);
+  return false;
+}
@@ -21,13 +21,17 @@
 
 #include "nvtop/extract_gpuinfo_common.h"
 #include "nvtop/common.h"
+#include "nvtop/time.h"
 
 #include <dlfcn.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 #define NVML_SUCCESS 0
 #define NVML_ERROR_INSUFFICIENT_SIZE 7
@@ -141,6 +145,36 @@ static nvmlReturn_t (*nvmlDeviceGetDecoderUtilization)(
     nvmlDevice_t device, unsigned int *utilization,
     unsigned int *samplingPeriodUs);
 
+typedef enum {
+  NVML_GPU_UTILIZATION_SAMPLES = 1,
+} nvmlSamplingType_t;
+
+typedef enum {
+  NVML_VALUE_TYPE_DOUBLE = 0,
+  NVML_VALUE_TYPE_UNSIGNED_INT = 1,
+  NVML_VALUE_TYPE_UNSIGNED_LONG = 2,
+  NVML_VALUE_TYPE_UNSIGNED_LONG_LONG = 3,
+  NVML_VALUE_TYPE_SIGNED_LONG_LONG = 4,
+} nvmlValueType_t;
+
+typedef union {
+  double dVal;
+  unsigned int uiVal;
+  unsigned long ulVal;
+  unsigned long long ullVal;
+  signed long long sllVal;
+} nvmlValue_t;
+
+typedef struct {
+  unsigned long long timeStamp;
+  nvmlValue_t sampleValue;
+} nvmlSample_t;
+
+static nvmlReturn_t (*nvmlDeviceGetSamples)(
+    nvmlDevice_t device, nvmlSamplingType_t type,
+    unsigned long long lastSeenTimeStamp, nvmlValueType_t *sampleValType,
+    unsigned int *sampleCount, nvmlSample_t *samples);
+
 // Processes running on GPU
 
 typedef struct {
@@ -156,6 +190,53 @@ static nvmlReturn_t (*nvmlDeviceGetGraphicsRunningProcesses)(
 static nvmlReturn_t (*nvmlDeviceGetComputeRunningProcesses)(
     nvmlDevice_t device, unsigned int *infoCount, nvmlProcessInfo_t *infos);
 
+typedef struct {
+  char busIdLegacy[16];
+  unsigned int domain;
+  unsigned int bus;
+  unsigned int device;
+  unsigned int pciDeviceId;
+  unsigned int pciSubSystemId;
+  char busId[32];
+} nvmlPciInfo_t;
+
+static nvmlReturn_t (*nvmlDeviceGetPciInfo)(nvmlDevice_t device,
+                                            nvmlPciInfo_t *pci);
+
+// Performance tuning, all optional
+
+static nvmlReturn_t (*nvmlDeviceGetPowerManagementLimit)(nvmlDevice_t device,
+                                                         unsigned int *limit);
+
+static nvmlReturn_t (*nvmlDeviceGetPowerManagementLimitConstraints)(
+    nvmlDevice_t device, unsigned int *minLimit, unsigned int *maxLimit);
+
+static nvmlReturn_t (*nvmlDeviceSetPowerManagementLimit)(nvmlDevice_t device,
+                                                         unsigned int limit);
+
+static nvmlReturn_t (*nvmlDeviceSetGpuLockedClocks)(
+    nvmlDevice_t device, unsigned int minGpuClockMHz,
+    unsigned int maxGpuClockMHz);
+
+static nvmlReturn_t (*nvmlDeviceResetGpuLockedClocks)(nvmlDevice_t device);
+
+static nvmlReturn_t (*nvmlDeviceGetApplicationsClock)(nvmlDevice_t device,
+                                                      nvmlClockType_t clockType,
+                                                      unsigned int *clockMHz);
+
+static nvmlReturn_t (*nvmlDeviceGetDefaultApplicationsClock)(
+    nvmlDevice_t device, nvmlClockType_t clockType, unsigned int *clockMHz);
+
+static nvmlReturn_t (*nvmlDeviceGetSupportedGraphicsClocks)(
+    nvmlDevice_t device, unsigned int memoryClockMHz, unsigned int *count,
+    unsigned int *clocksMHz);
+
+static nvmlReturn_t (*nvmlDeviceSetApplicationsClocks)(
+    nvmlDevice_t device, unsigned int memClockMHz,
+    unsigned int graphicsClockMHz);
+
+static nvmlReturn_t (*nvmlDeviceResetApplicationsClocks)(nvmlDevice_t device);
+
 static void *libnvidia_ml_handle;
 
 static nvmlReturn_t last_nvml_return_status = NVML_SUCCESS;
@@ -185,19 +266,30 @@ struct gpu_info_nvidia {
 
   nvmlDevice_t gpuhandle;
   unsigned long long last_utilization_timestamp;
+  unsigned long long last_device_sample_timestamp;
+  unsigned locked_gpu_clock; // NVML does not report the lock, 0 if not set by us
 };
 
 static LIST_HEAD(allocations);
 
+// Device utilization samples, reused across devices
+static size_t device_samples_size = 0;
+static nvmlSample_t *device_samples = NULL;
+
 static bool gpuinfo_nvidia_init(void);
 static void gpuinfo_nvidia_shutdown(void);
 static const char *gpuinfo_nvidia_last_error_string(void);
 static bool gpuinfo_nvidia_get_device_handles(
     struct list_head *devices, unsigned *count,
-    ssize_t *mask);
+    struct gpuinfo_device_mask *mask);
 static void gpuinfo_nvidia_populate_static_info(struct gpu_info *_gpu_info);
 static void gpuinfo_nvidia_refresh_dynamic_info(struct gpu_info *_gpu_info);
 static void gpuinfo_nvidia_get_running_processes(struct gpu_info *_gpu_info);
+static void gpuinfo_nvidia_get_tuning(struct gpu_info *_gpu_info,
+                                      struct gpuinfo_tuning *tuning);
+static bool gpuinfo_nvidia_set_tuning(struct gpu_info *_gpu_info,
+                                      enum gpuinfo_tuning_knob_id knob,
+                                      int value);
 
 struct gpu_vendor gpu_vendor_nvidia = {
   .init = gpuinfo_nvidia_init,
@@ -207,6 +299,8 @@ struct gpu_vendor gpu_vendor_nvidia = {
   .populate_static_info = gpuinfo_nvidia_populate_static_info,
   .refresh_dynamic_info = gpuinfo_nvidia_refresh_dynamic_info,
   .refresh_running_processes = gpuinfo_nvidia_get_running_processes,
+  .get_tuning = gpuinfo_nvidia_get_tuning,
+  .set_tuning = gpuinfo_nvidia_set_tuning,
 };
 
 __attribute__((constructor))
@@ -359,6 +453,38 @@ static bool gpuinfo_nvidia_init(void) {
   nvmlDeviceGetProcessUtilization =
       dlsym(libnvidia_ml_handle, "nvmlDeviceGetProcessUtilization");
 
+  // This one might not be available
+  nvmlDeviceGetSamples = dlsym(libnvidia_ml_handle, "nvmlDeviceGetSamples");
+
+  // Tuning knobs are unavailable when these are missing
+  nvmlDeviceGetPowerManagementLimit =
+      dlsym(libnvidia_ml_handle, "nvmlDeviceGetPowerManagementLimit");
+  nvmlDeviceGetPowerManagementLimitConstraints = dlsym(
+      libnvidia_ml_handle, "nvmlDeviceGetPowerManagementLimitConstraints");
+  nvmlDeviceSetPowerManagementLimit =
+      dlsym(libnvidia_ml_handle, "nvmlDeviceSetPowerManagementLimit");
+  nvmlDeviceSetGpuLockedClocks =
+      dlsym(libnvidia_ml_handle, "nvmlDeviceSetGpuLockedClocks");
+  nvmlDeviceResetGpuLockedClocks =
+      dlsym(libnvidia_ml_handle, "nvmlDeviceResetGpuLockedClocks");
+  nvmlDeviceGetApplicationsClock =
+      dlsym(libnvidia_ml_handle, "nvmlDeviceGetApplicationsClock");
+  nvmlDeviceGetDefaultApplicationsClock =
+      dlsym(libnvidia_ml_handle, "nvmlDeviceGetDefaultApplicationsClock");
+  nvmlDeviceGetSupportedGraphicsClocks =
+      dlsym(libnvidia_ml_handle, "nvmlDeviceGetSupportedGraphicsClocks");
+  nvmlDeviceSetApplicationsClocks =
+      dlsym(libnvidia_ml_handle, "nvmlDeviceSetApplicationsClocks");
+  nvmlDeviceResetApplicationsClocks =
+      dlsym(libnvidia_ml_handle, "nvmlDeviceResetApplicationsClocks");
+
+  // Only used to locate the device in sysfs, the leading fields did not change
+  // between versions
+  nvmlDeviceGetPciInfo = dlsym(libnvidia_ml_handle, "nvmlDeviceGetPciInfo_v3");
+  if (!nvmlDeviceGetPciInfo)
+    nvmlDeviceGetPciInfo =
+        dlsym(libnvidia_ml_handle, "nvmlDeviceGetPciInfo_v2");
+
   last_nvml_return_status = nvmlInit();
   if (last_nvml_return_status != NVML_SUCCESS) {
     return false;
@@ -387,6 +513,9 @@ static void gpuinfo_nvidia_shutdown(void) {
     list_del(&allocated->allocate_list);
     free(allocated);
   }
+  free(device_samples);
+  device_samples = NULL;
+  device_samples_size = 0;
 }
 
 static const char *gpuinfo_nvidia_last_error_string(void) {
@@ -402,7 +531,7 @@ static const char *gpuinfo_nvidia_last_error_string(void) {
 
 static bool gpuinfo_nvidia_get_device_handles(
     struct list_head *devices, unsigned *count,
-    ssize_t *mask) {
+    struct gpuinfo_device_mask *mask) {
 
   if (!libnvidia_ml_handle)
     return false;
@@ -423,11 +552,8 @@ static bool gpuinfo_nvidia_get_device_handles(
 
   *count = 0;
   for (unsigned int i = 0; i < num_devices; ++i) {
-    if ((*mask & 1) == 0) {
-      *mask >>= 1;
+    if (!gpuinfo_device_mask_select_next(mask))
       continue;
-    }
-    *mask >>= 1;
 
     last_nvml_return_status =
         nvmlDeviceGetHandleByIndex(i, &gpu_infos[*count].gpuhandle);
@@ -475,6 +601,88 @@ static void gpuinfo_nvidia_populate_static_info(struct gpu_info *_gpu_info) {
       &static_info->temperature_slowdown_threshold);
   if (last_nvml_return_status == NVML_SUCCESS)
     SET_VALID(gpuinfo_temperature_slowdown_threshold_valid, static_info->valid);
+
+  nvmlPciInfo_t pci;
+  if (nvmlDeviceGetPciInfo &&
+      nvmlDeviceGetPciInfo(device, &pci) == NVML_SUCCESS) {
+    snprintf(static_info->pdev, sizeof(static_info->pdev), "%04x:%02x:%02x.0",
+             pci.domain, pci.bus, pci.device);
+    SET_VALID(gpuinfo_pdev_valid, static_info->valid);
+    char device_path[64];
+    snprintf(device_path, sizeof(device_path),
+             "/sys/bus/pci/devices/%04x:%02x:%02x.0", pci.domain, pci.bus,
+             pci.device);
+    int device_dirfd = open(device_path, O_RDONLY | O_DIRECTORY);
+    if (device_dirfd >= 0) {
+      gpuinfo_read_pci_numa_info(device_dirfd, static_info);
+      close(device_dirfd);
+    }
+  }
+}
+
+static int compare_sample_timestamps(const void *a, const void *b) {
+  const nvmlSample_t *sample_a = a, *sample_b = b;
+  if (sample_a->timeStamp < sample_b->timeStamp)
+    return -1;
+  return sample_a->timeStamp > sample_b->timeStamp;
+}
+
+// The driver samples the device utilization much faster than the refresh
+// rate, which gives the length of the short idle gaps between kernels
+static void gpuinfo_nvidia_sample_duty_cycle(struct gpu_info_nvidia *gpu_info) {
+  if (!nvmlDeviceGetSamples)
+    return;
+  nvmlDevice_t device = gpu_info->gpuhandle;
+  nvmlValueType_t value_type;
+  unsigned samples_count = 0;
+  nvmlReturn_t retval = nvmlDeviceGetSamples(
+      device, NVML_GPU_UTILIZATION_SAMPLES, gpu_info->last_device_sample_timestamp, &value_type, &samples_count, NULL);
+  if (retval != NVML_SUCCESS || !samples_count)
+    return;
+  if (samples_count > device_samples_size) {
+    device_samples_size = samples_count;
+    device_samples = reallocarray(device_samples, device_samples_size, sizeof(*device_samples));
+    if (!device_samples) {
+      perror("Could not re-allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+  nvmlSample_t *samples = device_samples;
+  retval = nvmlDeviceGetSamples(device, NVML_GPU_UTILIZATION_SAMPLES, gpu_info->last_device_sample_timestamp,
+                                &value_type, &samples_count, samples);
+  if (retval != NVML_SUCCESS)
+    return;
+  qsort(samples, samples_count, sizeof(*samples), compare_sample_timestamps);
+  // The samples are time stamped in microseconds of the wall clock, the duty
+  // cycle uses the monotonic clock of nvtop_get_current_time
+  struct timespec wall_clock;
+  nvtop_time monotonic_clock;
+  clock_gettime(CLOCK_REALTIME, &wall_clock);
+  nvtop_get_current_time(&monotonic_clock);
+  int64_t wall_to_monotonic = (int64_t)nvtop_time_u64(monotonic_clock) - (int64_t)nvtop_time_u64(wall_clock);
+  for (unsigned i = 0; i < samples_count; ++i) {
+    if (samples[i].timeStamp <= gpu_info->last_device_sample_timestamp)
+      continue;
+    bool busy;
+    switch (value_type) {
+    case NVML_VALUE_TYPE_UNSIGNED_INT:
+      busy = samples[i].sampleValue.uiVal > 0;
+      break;
+    case NVML_VALUE_TYPE_UNSIGNED_LONG:
+      busy = samples[i].sampleValue.ulVal > 0;
+      break;
+    case NVML_VALUE_TYPE_UNSIGNED_LONG_LONG:
+      busy = samples[i].sampleValue.ullVal > 0;
+      break;
+    default:
+      return;
+    }
+    int64_t timestamp = (int64_t)(samples[i].timeStamp * 1000) + wall_to_monotonic;
+    if (timestamp > 0)
+      duty_cycle_add_sample(&gpu_info->base.duty_cycle, (uint64_t)timestamp, busy);
+    gpu_info->last_device_sample_timestamp = samples[i].timeStamp;
+    gpu_info->base.duty_cycle_sampled = true;
+  }
 }
 
 static void gpuinfo_nvidia_refresh_dynamic_info(struct gpu_info *_gpu_info) {
@@ -538,6 +746,7 @@ static void gpuinfo_nvidia_refresh_dynamic_info(struct gpu_info *_gpu_info) {
       nvmlDeviceGetUtilizationRates(device, &utilization_percentages);
   if (last_nvml_return_status == NVML_SUCCESS) {
     SET_GPUINFO_DYNAMIC(dynamic_info, gpu_util_rate, utilization_percentages.gpu);
+    SET_GPUINFO_DYNAMIC(dynamic_info, mem_bandwidth_rate, utilization_percentages.memory);
   }
 
   // Encoder utilization rate
@@ -610,6 +819,8 @@ static void gpuinfo_nvidia_refresh_dynamic_info(struct gpu_info *_gpu_info) {
       nvmlDeviceGetEnforcedPowerLimit(device, &dynamic_info->power_draw_max);
   if (last_nvml_return_status == NVML_SUCCESS)
     SET_VALID(gpuinfo_power_draw_max_valid, dynamic_info->valid);
+
+  gpuinfo_nvidia_sample_duty_cycle(gpu_info);
 }
 
 static void gpuinfo_nvidia_get_process_utilization(
@@ -658,6 +869,8 @@ static void gpuinfo_nvidia_get_process_utilization(
           SET_GPUINFO_PROCESS(&processes[j], gpu_usage, samples[i].smUtil);
           SET_GPUINFO_PROCESS(&processes[j], encode_usage, samples[i].encUtil);
           SET_GPUINFO_PROCESS(&processes[j], decode_usage, samples[i].decUtil);
+          if (samples[i].memUtil <= 100)
+            SET_GPUINFO_PROCESS(&processes[j], memory_bandwidth_usage, samples[i].memUtil);
           process_matched = true;
         }
       }
@@ -681,7 +894,7 @@ retry_query_graphical:
   last_nvml_return_status = nvmlDeviceGetGraphicsRunningProcesses(
       device, &recovered_count, retrieved_infos);
   if (last_nvml_return_status == NVML_ERROR_INSUFFICIENT_SIZE) {
-    array_size += COMMON_PROCESS_LINEAR_REALLOC_INC;
+    array_size = COMMON_PROCESS_GROWN_SIZE(array_size);
     retrieved_infos = reallocarray(retrieved_infos, array_size, sizeof(*retrieved_infos));
     if (!retrieved_infos) {
       perror("Could not re-allocate memory: ");
@@ -697,7 +910,7 @@ retry_query_compute:
   last_nvml_return_status = nvmlDeviceGetComputeRunningProcesses(
       device, &recovered_count, retrieved_infos + graphical_count);
   if (last_nvml_return_status == NVML_ERROR_INSUFFICIENT_SIZE) {
-    array_size += COMMON_PROCESS_LINEAR_REALLOC_INC;
+    array_size = COMMON_PROCESS_GROWN_SIZE(array_size);
     retrieved_infos = reallocarray(retrieved_infos, array_size, sizeof(*retrieved_infos));
     if (!retrieved_infos) {
       perror("Could not re-allocate memory: ");
@@ -712,7 +925,9 @@ retry_query_compute:
   _gpu_info->processes_count = graphical_count + compute_count;
   if (_gpu_info->processes_count > 0) {
     if (_gpu_info->processes_count > _gpu_info->processes_array_size) {
-      _gpu_info->processes_array_size = _gpu_info->processes_count + COMMON_PROCESS_LINEAR_REALLOC_INC;
+      _gpu_info->processes_array_size = COMMON_PROCESS_GROWN_SIZE(_gpu_info->processes_array_size);
+      if (_gpu_info->processes_array_size < _gpu_info->processes_count)
+        _gpu_info->processes_array_size = _gpu_info->processes_count;
       _gpu_info->processes =
           reallocarray(_gpu_info->processes, _gpu_info->processes_array_size, sizeof(*_gpu_info->processes));
       if (!_gpu_info->processes) {
@@ -720,8 +935,9 @@ retry_query_compute:
         exit(EXIT_FAILURE);
       }
     }
-    memset(_gpu_info->processes, 0, _gpu_info->processes_count * sizeof(*_gpu_info->processes));
+    // Only the validity bits need a reset, every valid field is written below
     for (unsigned i = 0; i < graphical_count + compute_count; ++i) {
+      RESET_ALL(_gpu_info->processes[i].valid);
       if (i < graphical_count)
         _gpu_info->processes[i].type = gpu_process_graphical;
       else
@@ -733,3 +949,132 @@ retry_query_compute:
   }
   gpuinfo_nvidia_get_process_utilization(gpu_info, _gpu_info->processes_count, _gpu_info->processes);
 }
+
+static const unsigned nvidia_locked_clock_step = 15;
+
+static void gpuinfo_nvidia_get_tuning(struct gpu_info *_gpu_info,
+                                      struct gpuinfo_tuning *tuning) {
+  struct gpu_info_nvidia *gpu_info =
+      container_of(_gpu_info, struct gpu_info_nvidia, base);
+  nvmlDevice_t device = gpu_info->gpuhandle;
+
+  unsigned limit, min_limit, max_limit;
+  if (nvmlDeviceGetPowerManagementLimit &&
+      nvmlDeviceGetPowerManagementLimitConstraints &&
+      nvmlDeviceSetPowerManagementLimit &&
+      nvmlDeviceGetPowerManagementLimit(device, &limit) == NVML_SUCCESS &&
+      nvmlDeviceGetPowerManagementLimitConstraints(
+          device, &min_limit, &max_limit) == NVML_SUCCESS) {
+    struct gpuinfo_tuning_knob *knob =
+        &tuning->knobs[gpuinfo_tuning_power_limit];
+    knob->available = true;
+    knob->value = (int)limit;
+    knob->minimum = (int)min_limit;
+    knob->maximum = (int)max_limit;
+    knob->step = 5000;
+  }
+
+  unsigned max_clock;
+  if (nvmlDeviceSetGpuLockedClocks && nvmlDeviceResetGpuLockedClocks &&
+      nvmlDeviceGetMaxClockInfo(device, NVML_CLOCK_GRAPHICS, &max_clock) ==
+          NVML_SUCCESS) {
+    struct gpuinfo_tuning_knob *knob =
+        &tuning->knobs[gpuinfo_tuning_locked_gpu_clock];
+    knob->available = true;
+    knob->value = gpu_info->locked_gpu_clock;
+    knob->minimum = 0;
+    knob->maximum = max_clock;
+    knob->step = nvidia_locked_clock_step;
+  }
+
+  // The graphics clocks supported at the current memory clock, thinned out to
+  // fit the choices after the default
+  unsigned mem_clock, graphics_clock;
+  unsigned clocks[512];
+  unsigned clocks_count = sizeof(clocks) / sizeof(*clocks);
+  if (nvmlDeviceGetApplicationsClock && nvmlDeviceGetSupportedGraphicsClocks &&
+      nvmlDeviceSetApplicationsClocks && nvmlDeviceResetApplicationsClocks &&
+      nvmlDeviceGetApplicationsClock(device, NVML_CLOCK_MEM, &mem_clock) ==
+          NVML_SUCCESS &&
+      nvmlDeviceGetApplicationsClock(device, NVML_CLOCK_GRAPHICS,
+                                     &graphics_clock) == NVML_SUCCESS &&
+      nvmlDeviceGetSupportedGraphicsClocks(device, mem_clock, &clocks_count,
+                                           clocks) == NVML_SUCCESS &&
+      clocks_count > 0) {
+    struct gpuinfo_tuning_knob *knob =
+        &tuning->knobs[gpuinfo_tuning_applications_clock];
+    knob->available = true;
+    unsigned default_clock;
+    if (nvmlDeviceGetDefaultApplicationsClock &&
+        nvmlDeviceGetDefaultApplicationsClock(device, NVML_CLOCK_GRAPHICS,
+                                              &default_clock) == NVML_SUCCESS &&
+        default_clock == graphics_clock)
+      knob->value = 0;
+    else
+      knob->value = (int)graphics_clock;
+    knob->choice_values[0] = 0;
+    snprintf(knob->choice_names[0], GPUINFO_TUNING_CHOICE_NAME_SIZE,
+             "default");
+    knob->choices_count = 1;
+    unsigned stride =
+        (clocks_count + GPUINFO_TUNING_MAX_CHOICES - 2) /
+        (GPUINFO_TUNING_MAX_CHOICES - 1);
+    // NVML lists the clocks from the highest, the choices go upward
+    for (unsigned i = 0; i < clocks_count &&
+                         knob->choices_count < GPUINFO_TUNING_MAX_CHOICES;
+         i += stride) {
+      unsigned clock = clocks[clocks_count - 1 - i];
+      knob->choice_values[knob->choices_count] = (int)clock;
+      snprintf(knob->choice_names[knob->choices_count],
+               GPUINFO_TUNING_CHOICE_NAME_SIZE, "%u MHz", clock);
+      knob->choices_count++;
+    }
+  }
+}
+
+static bool gpuinfo_nvidia_set_tuning(struct gpu_info *_gpu_info,
+                                      enum gpuinfo_tuning_knob_id knob,
+                                      int value) {
+  struct gpu_info_nvidia *gpu_info =
+      container_of(_gpu_info, struct gpu_info_nvidia, base);
+  nvmlDevice_t device = gpu_info->gpuhandle;
+  if (value < 0)
+    return false;
+
+  switch (knob) {
+  case gpuinfo_tuning_power_limit:
+    if (!nvmlDeviceSetPowerManagementLimit)
+      return false;
+    last_nvml_return_status =
+        nvmlDeviceSetPowerManagementLimit(device, (unsigned)value);
+    break;
+  case gpuinfo_tuning_locked_gpu_clock:
+    if (!nvmlDeviceSetGpuLockedClocks || !nvmlDeviceResetGpuLockedClocks)
+      return false;
+    if (value)
+      last_nvml_return_status = nvmlDeviceSetGpuLockedClocks(
+          device, (unsigned)value, (unsigned)value);
+    else
+      last_nvml_return_status = nvmlDeviceResetGpuLockedClocks(device);
+    if (last_nvml_return_status == NVML_SUCCESS)
+      gpu_info->locked_gpu_clock = (unsigned)value;
+    break;
+  case gpuinfo_tuning_applications_clock: {
+    unsigned mem_clock;
+    if (!nvmlDeviceSetApplicationsClocks || !nvmlDeviceResetApplicationsClocks)
+      return false;
+    if (value) {
+      last_nvml_return_status =
+          nvmlDeviceGetApplicationsClock(device, NVML_CLOCK_MEM, &mem_clock);
+      if (last_nvml_return_status == NVML_SUCCESS)
+        last_nvml_return_status = nvmlDeviceSetApplicationsClocks(
+            device, mem_clock, (unsigned)value);
+    } else {
+      last_nvml_return_status = nvmlDeviceResetApplicationsClocks(device);
+    }
+  } break;
+  default:
+    return false;
+  }
+  return last_nvml_return_status == NVML_SUCCESS;
+}
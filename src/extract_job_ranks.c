@@ -0,0 +1,289 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/extract_job_ranks.h"
+#include "nvtop/common.h"
+#include "uthash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// Refreshes covered by the sliding window
+#define JOB_RANK_WINDOW 20
+// A rank is behind when its window average is that much below the job median
+static const double behind_tolerance = 0.15;
+// Refreshes a rank has to stay behind before being reported
+static const unsigned behind_persistence = JOB_RANK_WINDOW / 2;
+// Below that median utilization, the job is considered idle
+static const double min_median_utilization = 10.;
+
+struct rank_key {
+  const struct gpu_info *device;
+  pid_t pid;
+};
+
+struct rank_window {
+  struct rank_key key;
+  unsigned samples_count, next_sample;
+  double utilization[JOB_RANK_WINDOW];
+  double utilization_sum;
+  bool power_valid[JOB_RANK_WINDOW];
+  double power[JOB_RANK_WINDOW];
+  double power_sum;
+  unsigned power_count;
+  unsigned behind_streak;
+  UT_hash_handle hh;
+};
+
+struct rank_member {
+  unsigned row;
+  struct rank_window *window;
+  char *job_key;
+};
+
+static struct rank_window *cached_windows = NULL;
+static struct rank_window *updated_windows = NULL;
+
+static struct gpuinfo_process_table *ranks_table = NULL;
+
+static unsigned members_count, members_capacity;
+static struct rank_member *members = NULL;
+static unsigned medians_capacity;
+static double *medians = NULL;
+
+void jobranks_begin_refresh(struct gpuinfo_process_table *table) {
+  ranks_table = table;
+  members_count = 0;
+}
+
+static struct rank_window *find_window(struct rank_window *head, const struct gpu_info *device, pid_t pid) {
+  struct rank_key key;
+  memset(&key, 0, sizeof(key));
+  key.device = device;
+  key.pid = pid;
+  struct rank_window *window;
+  HASH_FIND(hh, head, &key, sizeof(key), window);
+  return window;
+}
+
+static void window_add_sample(struct rank_window *window, unsigned row) {
+  unsigned slot = window->next_sample;
+  if (window->samples_count == JOB_RANK_WINDOW) {
+    window->utilization_sum -= window->utilization[slot];
+    if (window->power_valid[slot]) {
+      window->power_sum -= window->power[slot];
+      window->power_count--;
+    }
+  } else {
+    window->samples_count++;
+  }
+  window->utilization[slot] =
+      GPUINFO_PROCESS_TABLE_FIELD_VALID(ranks_table, row, gpu_usage) ? ranks_table->gpu_usage[row] : 0.;
+  window->utilization_sum += window->utilization[slot];
+  window->power_valid[slot] = GPUINFO_PROCESS_TABLE_FIELD_VALID(ranks_table, row, power_draw);
+  if (window->power_valid[slot]) {
+    window->power[slot] = ranks_table->power_draw[row];
+    window->power_sum += window->power[slot];
+    window->power_count++;
+  }
+  window->next_sample = (slot + 1) % JOB_RANK_WINDOW;
+}
+
+// Rank arguments such as "--local-rank 3" or "--node_rank=1" differ between
+// the ranks of a job and are left out of the command
+static void append_command_without_ranks(char *key, size_t *length, const char *cmdline) {
+  bool skip_value = false;
+  const char *token = cmdline;
+  while (*token) {
+    size_t token_length = strcspn(token, " ");
+    bool rank_option = false;
+    if (token_length > 1 && token[0] == '-') {
+      for (size_t i = 1; i + 4 <= token_length && !rank_option; ++i)
+        rank_option = strncasecmp(token + i, "rank", 4) == 0;
+    }
+    bool keep = !rank_option && !skip_value;
+    skip_value = rank_option && memchr(token, '=', token_length) == NULL;
+    if (keep) {
+      memcpy(key + *length, token, token_length);
+      *length += token_length;
+      key[(*length)++] = ' ';
+    }
+    token += token_length;
+    while (*token == ' ')
+      token++;
+  }
+  key[*length] = '\0';
+}
+
+static char *job_key_of(unsigned row, pid_t parent_pid) {
+  char owner[32];
+  const char *owner_name = owner;
+  if (GPUINFO_PROCESS_TABLE_FIELD_VALID(ranks_table, row, cgroup))
+    owner_name = gpuinfo_process_table_string(ranks_table, ranks_table->cgroup[row]);
+  else
+    snprintf(owner, sizeof(owner), "parent %d", (int)parent_pid);
+  const char *cmdline = gpuinfo_process_table_string(ranks_table, ranks_table->cmdline[row]);
+  size_t owner_length = strlen(owner_name);
+  char *key = malloc(owner_length + strlen(cmdline) + 3);
+  if (!key) {
+    perror("Could not allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(key, owner_name, owner_length);
+  key[owner_length] = '\n';
+  size_t length = owner_length + 1;
+  append_command_without_ranks(key, &length, cmdline);
+  return key;
+}
+
+void jobranks_add_process(const struct gpu_info *device, unsigned row, pid_t parent_pid) {
+  if (!GPUINFO_PROCESS_TABLE_FIELD_VALID(ranks_table, row, cmdline))
+    return;
+  pid_t pid = ranks_table->pid[row];
+  // The same process can be listed more than once per device
+  if (find_window(updated_windows, device, pid))
+    return;
+  struct rank_window *window = find_window(cached_windows, device, pid);
+  if (window) {
+    HASH_DEL(cached_windows, window);
+  } else {
+    window = calloc(1, sizeof(*window));
+    if (!window) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    window->key.device = device;
+    window->key.pid = pid;
+  }
+  HASH_ADD(hh, updated_windows, key, sizeof(window->key), window);
+  window_add_sample(window, row);
+
+  if (members_count == members_capacity) {
+    members_capacity = COMMON_PROCESS_GROWN_SIZE(members_capacity);
+    members = reallocarray(members, members_capacity, sizeof(*members));
+    if (!members) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+  members[members_count].row = row;
+  members[members_count].window = window;
+  members[members_count].job_key = job_key_of(row, parent_pid);
+  members_count++;
+}
+
+static int compare_members(const void *member1, const void *member2) {
+  return strcmp(((const struct rank_member *)member1)->job_key, ((const struct rank_member *)member2)->job_key);
+}
+
+static int compare_doubles(const void *value1, const void *value2) {
+  double v1 = *(const double *)value1, v2 = *(const double *)value2;
+  return (v1 > v2) - (v1 < v2);
+}
+
+static double median_of(unsigned count) {
+  qsort(medians, count, sizeof(*medians), compare_doubles);
+  return count % 2 ? medians[count / 2] : (medians[count / 2 - 1] + medians[count / 2]) / 2.;
+}
+
+static void flag_job_stragglers(struct rank_member *job, unsigned job_size) {
+  bool several_devices = false;
+  bool power_known = true;
+  for (unsigned i = 0; i < job_size; ++i) {
+    several_devices = several_devices || job[i].window->key.device != job[0].window->key.device;
+    power_known = power_known && job[i].window->power_count > 0;
+  }
+  if (!several_devices) {
+    for (unsigned i = 0; i < job_size; ++i)
+      job[i].window->behind_streak = 0;
+    return;
+  }
+
+  if (job_size > medians_capacity) {
+    medians_capacity = job_size;
+    medians = reallocarray(medians, medians_capacity, sizeof(*medians));
+    if (!medians) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+  for (unsigned i = 0; i < job_size; ++i)
+    medians[i] = job[i].window->utilization_sum / job[i].window->samples_count;
+  double median_utilization = median_of(job_size);
+  double median_power = 0.;
+  if (power_known) {
+    for (unsigned i = 0; i < job_size; ++i)
+      medians[i] = job[i].window->power_sum / job[i].window->power_count;
+    median_power = median_of(job_size);
+  }
+
+  for (unsigned i = 0; i < job_size; ++i) {
+    struct rank_window *window = job[i].window;
+    bool behind = false;
+    if (median_utilization >= min_median_utilization) {
+      behind = window->utilization_sum / window->samples_count < (1. - behind_tolerance) * median_utilization;
+      if (power_known && median_power > 0.)
+        behind = behind || window->power_sum / window->power_count < (1. - behind_tolerance) * median_power;
+    }
+    window->behind_streak = behind ? window->behind_streak + 1 : 0;
+    SET_GPUINFO_PROCESS_TABLE(ranks_table, job[i].row, straggler,
+                              window->samples_count >= behind_persistence &&
+                                  window->behind_streak >= behind_persistence);
+  }
+}
+
+void jobranks_end_refresh(void) {
+  if (members_count)
+    qsort(members, members_count, sizeof(*members), compare_members);
+  for (unsigned start = 0, end; start < members_count; start = end) {
+    for (end = start + 1; end < members_count && !strcmp(members[start].job_key, members[end].job_key); ++end)
+      ;
+    flag_job_stragglers(&members[start], end - start);
+  }
+  for (unsigned i = 0; i < members_count; ++i)
+    free(members[i].job_key);
+  members_count = 0;
+
+  struct rank_window *window, *tmp;
+  HASH_ITER(hh, cached_windows, window, tmp) {
+    HASH_DEL(cached_windows, window);
+    free(window);
+  }
+  cached_windows = updated_windows;
+  updated_windows = NULL;
+}
+
+void jobranks_clear(void) {
+  jobranks_end_refresh();
+  struct rank_window *window, *tmp;
+  HASH_ITER(hh, cached_windows, window, tmp) {
+    HASH_DEL(cached_windows, window);
+    free(window);
+  }
+  free(members);
+  members = NULL;
+  members_capacity = 0;
+  free(medians);
+  medians = NULL;
+  medians_capacity = 0;
+}
@@ -0,0 +1,161 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/extract_process_exits.h"
+#include "nvtop/common.h"
+#include "uthash.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Keeps the file descriptors well below the usual soft limit, the processes
+// past that are left to the sweeps
+static const unsigned max_watched_processes = 512;
+
+struct watched_process {
+  pid_t pid;
+  int pidfd;
+  UT_hash_handle hh;
+};
+
+static struct watched_process *cached_watched = NULL;
+static struct watched_process *updated_watched = NULL;
+static unsigned watched_count = 0;
+static bool pidfd_unsupported = false;
+
+static struct pollfd *poll_fds = NULL;
+static struct watched_process **poll_processes = NULL;
+static unsigned poll_capacity = 0;
+static pid_t *exited_pids = NULL;
+
+static int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+  return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+  (void)pid;
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+static void release_watched_process(struct watched_process *watched) {
+  close(watched->pidfd);
+  free(watched);
+  watched_count--;
+}
+
+void process_exits_track(pid_t pid) {
+  if (pidfd_unsupported)
+    return;
+  struct watched_process *watched;
+  HASH_FIND(hh, updated_watched, &pid, sizeof(pid), watched);
+  if (watched)
+    return;
+  HASH_FIND(hh, cached_watched, &pid, sizeof(pid), watched);
+  if (watched) {
+    HASH_DEL(cached_watched, watched);
+    HASH_ADD(hh, updated_watched, pid, sizeof(watched->pid), watched);
+    return;
+  }
+  if (watched_count >= max_watched_processes)
+    return;
+  int pidfd = open_pidfd(pid);
+  if (pidfd < 0) {
+    if (errno == ENOSYS)
+      pidfd_unsupported = true;
+    return;
+  }
+  watched = malloc(sizeof(*watched));
+  if (!watched) {
+    perror("Could not allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  watched->pid = pid;
+  watched->pidfd = pidfd;
+  watched_count++;
+  HASH_ADD(hh, updated_watched, pid, sizeof(watched->pid), watched);
+}
+
+void process_exits_end_refresh(void) {
+  struct watched_process *watched, *tmp;
+  HASH_ITER(hh, cached_watched, watched, tmp) {
+    HASH_DEL(cached_watched, watched);
+    release_watched_process(watched);
+  }
+  cached_watched = updated_watched;
+  updated_watched = NULL;
+}
+
+bool process_exits_watched(void) { return watched_count > 0; }
+
+unsigned process_exits_wait(int input_fd, int timeout_ms, const pid_t **exited) {
+  if (watched_count + 1 > poll_capacity) {
+    poll_capacity = watched_count + 1;
+    poll_fds = reallocarray(poll_fds, poll_capacity, sizeof(*poll_fds));
+    poll_processes = reallocarray(poll_processes, poll_capacity, sizeof(*poll_processes));
+    exited_pids = reallocarray(exited_pids, poll_capacity, sizeof(*exited_pids));
+    if (!poll_fds || !poll_processes || !exited_pids) {
+      perror("Could not re-allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+  unsigned count = 0;
+  poll_fds[count].fd = input_fd;
+  poll_fds[count].events = POLLIN;
+  poll_processes[count++] = NULL;
+  struct watched_process *watched, *tmp;
+  HASH_ITER(hh, cached_watched, watched, tmp) {
+    poll_fds[count].fd = watched->pidfd;
+    poll_fds[count].events = POLLIN;
+    poll_processes[count++] = watched;
+  }
+  *exited = exited_pids;
+  // Interrupted by a signal, the caller handles it
+  if (poll(poll_fds, count, timeout_ms) <= 0)
+    return 0;
+  unsigned exited_count = 0;
+  for (unsigned i = 1; i < count; ++i) {
+    if (!poll_fds[i].revents)
+      continue;
+    watched = poll_processes[i];
+    exited_pids[exited_count++] = watched->pid;
+    HASH_DEL(cached_watched, watched);
+    release_watched_process(watched);
+  }
+  return exited_count;
+}
+
+void process_exits_clear(void) {
+  process_exits_end_refresh();
+  process_exits_end_refresh();
+  free(poll_fds);
+  free(poll_processes);
+  free(exited_pids);
+  poll_fds = NULL;
+  poll_processes = NULL;
+  exited_pids = NULL;
+  poll_capacity = 0;
+}
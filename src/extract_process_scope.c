@@ -0,0 +1,182 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/extract_process_scope.h"
+#include "nvtop/common.h"
+#include "nvtop/extract_cgroupinfo.h"
+#include "nvtop/get_process_info.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum process_scope_kind {
+  process_scope_none,
+  process_scope_cgroup,
+  process_scope_pid_tree,
+};
+
+static enum process_scope_kind scope_kind = process_scope_none;
+static char *scope_cgroup_dir = NULL;
+static pid_t scope_root_pid;
+
+static unsigned scope_pids_count, scope_pids_capacity;
+static pid_t *scope_pids = NULL;
+
+static void scope_add_pid(pid_t pid) {
+  if (scope_pids_count == scope_pids_capacity) {
+    scope_pids_capacity = COMMON_PROCESS_GROWN_SIZE(scope_pids_capacity);
+    scope_pids = reallocarray(scope_pids, scope_pids_capacity, sizeof(*scope_pids));
+    if (!scope_pids) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+  scope_pids[scope_pids_count++] = pid;
+}
+
+bool process_scope_set_cgroup(const char *path) {
+  const char *mount_point = cgroupinfo_mount_point();
+  if (!mount_point)
+    return false;
+  size_t mount_length = strlen(mount_point);
+  char *dir;
+  if (!strncmp(path, mount_point, mount_length) && (path[mount_length] == '/' || path[mount_length] == '\0'))
+    dir = strdup(path);
+  else if (asprintf(&dir, "%s%s%s", mount_point, path[0] == '/' ? "" : "/", path) < 0)
+    dir = NULL;
+  if (!dir) {
+    perror("Could not allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  struct stat dir_stat;
+  char procs_file[PATH_MAX];
+  snprintf(procs_file, sizeof(procs_file), "%s/cgroup.procs", dir);
+  if (stat(procs_file, &dir_stat) != 0) {
+    free(dir);
+    return false;
+  }
+  free(scope_cgroup_dir);
+  scope_cgroup_dir = dir;
+  scope_kind = process_scope_cgroup;
+  return true;
+}
+
+void process_scope_set_pid_tree(pid_t root) {
+  scope_root_pid = root;
+  scope_kind = process_scope_pid_tree;
+}
+
+bool process_scope_active(void) { return scope_kind != process_scope_none; }
+
+// Members of the cgroup and of its descendants
+static void gather_cgroup_pids(int cgroup_dir_fd) {
+  int procs_fd = openat(cgroup_dir_fd, "cgroup.procs", O_RDONLY);
+  if (procs_fd >= 0) {
+    FILE *procs = fdopen(procs_fd, "r");
+    if (procs) {
+      intmax_t pid;
+      while (fscanf(procs, "%" SCNdMAX, &pid) == 1)
+        scope_add_pid((pid_t)pid);
+      fclose(procs);
+    } else {
+      close(procs_fd);
+    }
+  }
+  DIR *cgroup_dir = fdopendir(cgroup_dir_fd);
+  if (!cgroup_dir) {
+    close(cgroup_dir_fd);
+    return;
+  }
+  struct dirent *entry;
+  while ((entry = readdir(cgroup_dir)) != NULL) {
+    if (entry->d_type != DT_DIR || entry->d_name[0] == '.')
+      continue;
+    int child_fd = openat(dirfd(cgroup_dir), entry->d_name, O_RDONLY | O_DIRECTORY);
+    if (child_fd >= 0)
+      gather_cgroup_pids(child_fd);
+  }
+  closedir(cgroup_dir);
+}
+
+// The tree is walked breadth first with scope_pids as the queue
+static void gather_pid_tree(void) {
+  scope_add_pid(scope_root_pid);
+  for (unsigned next = 0; next < scope_pids_count; ++next)
+    get_process_children(scope_pids[next], &scope_pids_count, &scope_pids_capacity, &scope_pids);
+}
+
+static int compare_pids(const void *pid1, const void *pid2) {
+  pid_t p1 = *(const pid_t *)pid1, p2 = *(const pid_t *)pid2;
+  return (p1 > p2) - (p1 < p2);
+}
+
+void process_scope_refresh(void) {
+  scope_pids_count = 0;
+  switch (scope_kind) {
+  case process_scope_cgroup: {
+    int cgroup_dir_fd = open(scope_cgroup_dir, O_RDONLY | O_DIRECTORY);
+    if (cgroup_dir_fd >= 0)
+      gather_cgroup_pids(cgroup_dir_fd);
+  } break;
+  case process_scope_pid_tree:
+    gather_pid_tree();
+    break;
+  case process_scope_none:
+  default:
+    return;
+  }
+  if (!scope_pids_count)
+    return;
+  qsort(scope_pids, scope_pids_count, sizeof(*scope_pids), compare_pids);
+  unsigned unique = 1;
+  for (unsigned i = 1; i < scope_pids_count; ++i)
+    if (scope_pids[i] != scope_pids[unique - 1])
+      scope_pids[unique++] = scope_pids[i];
+  scope_pids_count = unique;
+}
+
+const pid_t *process_scope_pids(unsigned *count) {
+  *count = scope_pids_count;
+  return scope_pids;
+}
+
+bool process_scope_contains(pid_t pid) {
+  if (scope_kind == process_scope_none)
+    return true;
+  return scope_pids_count &&
+         bsearch(&pid, scope_pids, scope_pids_count, sizeof(*scope_pids), compare_pids) != NULL;
+}
+
+void process_scope_clear(void) {
+  free(scope_cgroup_dir);
+  scope_cgroup_dir = NULL;
+  free(scope_pids);
+  scope_pids = NULL;
+  scope_pids_count = scope_pids_capacity = 0;
+  scope_kind = process_scope_none;
+}
@@ -0,0 +1,181 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/extract_process_tree.h"
+#include "nvtop/common.h"
+#include "nvtop/get_process_info.h"
+#include "nvtop/time.h"
+#include "uthash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct process_tree_node {
+  pid_t pid;
+  pid_t parent_pid;
+  unsigned long long start_time;
+  double last_total_time; // User and kernel time in seconds
+  nvtop_time last_measurement_timestamp;
+  bool io_measured;
+  struct process_io_usage last_io;
+  // Usage over the last refresh interval
+  double cpu_usage;
+  size_t resident_memory;
+  bool io_rates_valid;
+  unsigned long long io_read_rate, io_write_rate;
+  UT_hash_handle hh;
+};
+
+static struct process_tree_node *cached_nodes = NULL;
+static struct process_tree_node *updated_nodes = NULL;
+static bool measure_io = false;
+
+// Breadth first walk queue with the parent each pid was listed by, reused
+// across refreshes
+static unsigned walk_count, walk_capacity, walk_parents_capacity;
+static pid_t *walk_pids = NULL, *walk_parents = NULL;
+
+void process_tree_begin_refresh(bool with_io) { measure_io = with_io; }
+
+static void measure_node_io(struct process_tree_node *node) {
+  struct process_io_usage io;
+  node->io_rates_valid = false;
+  if (!measure_io || !get_process_io(node->pid, &io)) {
+    node->io_measured = false;
+    return;
+  }
+  if (node->io_measured) {
+    double elapsed = nvtop_difftime(node->last_io.timestamp, io.timestamp);
+    if (elapsed > 0. && io.read_bytes >= node->last_io.read_bytes && io.write_bytes >= node->last_io.write_bytes) {
+      node->io_read_rate = (unsigned long long)((io.read_bytes - node->last_io.read_bytes) / elapsed);
+      node->io_write_rate = (unsigned long long)((io.write_bytes - node->last_io.write_bytes) / elapsed);
+      node->io_rates_valid = true;
+    }
+  }
+  node->io_measured = true;
+  node->last_io = io;
+}
+
+// The node of a pid listed as a child of parent_pid, NULL if the process is
+// gone or was reparented meanwhile
+static struct process_tree_node *refresh_node(pid_t pid, pid_t parent_pid) {
+  struct process_tree_node *node;
+  HASH_FIND(hh, updated_nodes, &pid, sizeof(pid), node);
+  if (node)
+    return node->parent_pid == parent_pid ? node : NULL;
+
+  struct process_cpu_usage usage;
+  if (!get_process_info(pid, &usage) || usage.parent_pid != parent_pid)
+    return NULL;
+  HASH_FIND(hh, cached_nodes, &pid, sizeof(pid), node);
+  if (node) {
+    HASH_DEL(cached_nodes, node);
+    // A reused pid starts over
+    if (node->start_time != usage.start_time) {
+      free(node);
+      node = NULL;
+    }
+  }
+  double total_time = usage.total_user_time + usage.total_kernel_time;
+  if (!node) {
+    node = calloc(1, sizeof(*node));
+    if (!node) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    node->pid = pid;
+    node->start_time = usage.start_time;
+  } else {
+    double elapsed = nvtop_difftime(node->last_measurement_timestamp, usage.timestamp);
+    node->cpu_usage = elapsed > 0. ? 100. * (total_time - node->last_total_time) / elapsed : 0.;
+  }
+  node->parent_pid = parent_pid;
+  node->last_total_time = total_time;
+  node->last_measurement_timestamp = usage.timestamp;
+  node->resident_memory = usage.resident_memory;
+  measure_node_io(node);
+  HASH_ADD(hh, updated_nodes, pid, sizeof(pid_t), node);
+  return node;
+}
+
+static void queue_children(pid_t parent) {
+  unsigned first = walk_count;
+  if (!get_process_children(parent, &walk_count, &walk_capacity, &walk_pids))
+    return;
+  if (walk_parents_capacity < walk_capacity) {
+    walk_parents_capacity = walk_capacity;
+    walk_parents = reallocarray(walk_parents, walk_parents_capacity, sizeof(*walk_parents));
+    if (!walk_parents) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+  for (unsigned i = first; i < walk_count; ++i)
+    walk_parents[i] = parent;
+}
+
+bool process_tree_descendants_usage(pid_t root, bool (*has_own_row)(pid_t pid), struct process_tree_usage *usage) {
+  memset(usage, 0, sizeof(*usage));
+  usage->io_rates_valid = measure_io;
+  walk_count = 0;
+  queue_children(root);
+  for (unsigned i = 0; i < walk_count; ++i) {
+    pid_t pid = walk_pids[i];
+    if (has_own_row && has_own_row(pid))
+      continue;
+    struct process_tree_node *node = refresh_node(pid, walk_parents[i]);
+    if (!node)
+      continue;
+    usage->descendants_count++;
+    usage->cpu_usage += node->cpu_usage;
+    usage->resident_memory += node->resident_memory;
+    if (node->io_rates_valid) {
+      usage->io_read_rate += node->io_read_rate;
+      usage->io_write_rate += node->io_write_rate;
+    }
+    queue_children(pid);
+  }
+  return usage->descendants_count > 0;
+}
+
+static void free_nodes(struct process_tree_node **nodes) {
+  struct process_tree_node *node, *tmp;
+  HASH_ITER(hh, *nodes, node, tmp) {
+    HASH_DEL(*nodes, node);
+    free(node);
+  }
+}
+
+void process_tree_end_refresh(void) {
+  free_nodes(&cached_nodes);
+  cached_nodes = updated_nodes;
+  updated_nodes = NULL;
+}
+
+void process_tree_clear(void) {
+  free_nodes(&cached_nodes);
+  free_nodes(&updated_nodes);
+  free(walk_pids);
+  free(walk_parents);
+  walk_pids = walk_parents = NULL;
+  walk_count = walk_capacity = walk_parents_capacity = 0;
+}
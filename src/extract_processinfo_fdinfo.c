@@ -21,10 +21,12 @@
 
 #include "nvtop/extract_processinfo_fdinfo.h"
 #include "nvtop/common.h"
+#include "nvtop/extract_process_scope.h"
 
 #include <ctype.h>
 #include <dirent.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <linux/kcmp.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -79,182 +81,196 @@ static bool is_drm_fd(int fd_dir_fd, const char *name) {
 // 8 has been experimentally selected for being small while avoiding multipe allocations in most common cases
 #define DRM_FD_LINEAR_REALLOC_INC 8
 
-void processinfo_sweep_fdinfos(void) {
-  if (registered_callback_entries == 0)
-    return;
+static unsigned seen_fds_capacity = 0;
+static int *seen_fds = NULL;
 
-  DIR *proc_dir = opendir("/proc");
-  if (!proc_dir)
+static void sweep_process_fdinfos(int proc_dir_fd, const char *pid_name) {
+  int pid_dir_fd = -1, fd_dir_fd = -1, fdinfo_dir_fd = -1;
+  DIR *fdinfo_dir = NULL;
+  unsigned int seen_fds_len = 0;
+  struct dirent *fdinfo_dent;
+  unsigned int client_pid;
+
+  pid_dir_fd = openat(proc_dir_fd, pid_name, O_DIRECTORY);
+  if (pid_dir_fd < 0)
     return;
 
-  static unsigned seen_fds_capacity = 0;
-  static int *seen_fds = NULL;
+  client_pid = atoi(pid_name);
+  if (!client_pid)
+    goto next;
+
+  fd_dir_fd = openat(pid_dir_fd, "fd", O_DIRECTORY);
+  if (fd_dir_fd < 0)
+    goto next;
+
+  fdinfo_dir_fd = openat(pid_dir_fd, "fdinfo", O_DIRECTORY);
+  if (fdinfo_dir_fd < 0)
+    goto next;
 
-  struct dirent *proc_dent;
-  while ((proc_dent = readdir(proc_dir)) != NULL) {
-    int pid_dir_fd = -1, fd_dir_fd = -1, fdinfo_dir_fd = -1;
-    DIR *fdinfo_dir = NULL;
-    unsigned int seen_fds_len = 0;
-    struct dirent *fdinfo_dent;
-    unsigned int client_pid;
+  fdinfo_dir = fdopendir(fdinfo_dir_fd);
+  if (!fdinfo_dir) {
+    close(fdinfo_dir_fd);
+    goto next;
+  }
+
+next_fd:
+  while ((fdinfo_dent = readdir(fdinfo_dir)) != NULL) {
+    struct gpu_process processes_info_local = {0};
+    int fd_num;
 
-    if (proc_dent->d_type != DT_DIR)
+    if (fdinfo_dent->d_type != DT_REG)
       continue;
-    if (!isdigit(proc_dent->d_name[0]))
+    if (!isdigit(fdinfo_dent->d_name[0]))
       continue;
 
-    pid_dir_fd = openat(dirfd(proc_dir), proc_dent->d_name, O_DIRECTORY);
-    if (pid_dir_fd < 0)
+    if (!is_drm_fd(fd_dir_fd, fdinfo_dent->d_name))
       continue;
 
-    client_pid = atoi(proc_dent->d_name);
-    if (!client_pid)
-      goto next;
-
-    fd_dir_fd = openat(pid_dir_fd, "fd", O_DIRECTORY);
-    if (fd_dir_fd < 0)
-      goto next;
-
-    fdinfo_dir_fd = openat(pid_dir_fd, "fdinfo", O_DIRECTORY);
-    if (fdinfo_dir_fd < 0)
-      goto next;
+    fd_num = atoi(fdinfo_dent->d_name);
 
-    fdinfo_dir = fdopendir(fdinfo_dir_fd);
-    if (!fdinfo_dir) {
-      close(fdinfo_dir_fd);
-      goto next;
+    // check if this fd refers to the same open file as any seen ones.
+    // we only care about unique opens
+    for (unsigned i = 0; i < seen_fds_len; i++) {
+      if (syscall(SYS_kcmp, client_pid, client_pid, KCMP_FILE, fd_num, seen_fds[i]) <= 0)
+        goto next_fd;
     }
 
-  next_fd:
-    while ((fdinfo_dent = readdir(fdinfo_dir)) != NULL) {
-      struct gpu_process processes_info_local = {0};
-      int fd_num;
-
-      if (fdinfo_dent->d_type != DT_REG)
-        continue;
-      if (!isdigit(fdinfo_dent->d_name[0]))
-        continue;
-
-      if (!is_drm_fd(fd_dir_fd, fdinfo_dent->d_name))
-        continue;
+    if (seen_fds_len == seen_fds_capacity) {
+      seen_fds_capacity += DRM_FD_LINEAR_REALLOC_INC;
+      seen_fds = reallocarray(seen_fds, seen_fds_capacity, sizeof(*seen_fds));
+      if (!seen_fds) {
+        perror("Could not re-allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+    }
+    seen_fds[seen_fds_len++] = fd_num;
 
-      fd_num = atoi(fdinfo_dent->d_name);
+    int fdinfo_fd = openat(fdinfo_dir_fd, fdinfo_dent->d_name, O_RDONLY);
+    if (fdinfo_fd < 0)
+      continue;
+    FILE *fdinfo_file = fdopen(fdinfo_fd, "r");
+    if (!fdinfo_file) {
+      close(fdinfo_fd);
+      continue;
+    }
 
-      // check if this fd refers to the same open file as any seen ones.
-      // we only care about unique opens
-      for (unsigned i = 0; i < seen_fds_len; i++) {
-        if (syscall(SYS_kcmp, client_pid, client_pid, KCMP_FILE, fd_num, seen_fds[i]) <= 0)
-          goto next_fd;
-      }
+    bool callback_success = false;
+    struct callback_entry *current_callback = NULL;
+    processes_info_local.pid = client_pid;
+    processes_info_local.type = gpu_process_graphical;
+    for (unsigned callback_idx = 0; !callback_success && callback_idx < registered_callback_entries; ++callback_idx) {
+      rewind(fdinfo_file);
+      fflush(fdinfo_file);
+      RESET_ALL(processes_info_local.valid);
+      current_callback = &callback_entries[callback_idx];
+      callback_success = current_callback->callback(current_callback->gpu_info, fdinfo_file, &processes_info_local);
+    }
+    fclose(fdinfo_file);
+    if (!callback_success)
+      continue;
 
-      if (seen_fds_len == seen_fds_capacity) {
-        seen_fds_capacity += DRM_FD_LINEAR_REALLOC_INC;
-        seen_fds = reallocarray(seen_fds, seen_fds_capacity, sizeof(*seen_fds));
-        if (!seen_fds) {
-          perror("Could not re-allocate memory: ");
-          exit(EXIT_FAILURE);
-        }
+    unsigned process_index =
+        current_callback->gpu_info->processes_count ? current_callback->gpu_info->processes_count - 1 : 0;
+    // Alloc when array is empty or realloc when this pid does not correspond to the last entry and the array is full
+    if ((current_callback->gpu_info->processes_count == 0 ||
+         current_callback->gpu_info->processes[process_index].pid != (pid_t)client_pid) &&
+        current_callback->gpu_info->processes_count == current_callback->gpu_info->processes_array_size) {
+      current_callback->gpu_info->processes_array_size =
+          COMMON_PROCESS_GROWN_SIZE(current_callback->gpu_info->processes_array_size);
+      current_callback->gpu_info->processes =
+          reallocarray(current_callback->gpu_info->processes, current_callback->gpu_info->processes_array_size,
+                       sizeof(*current_callback->gpu_info->processes));
+      if (!current_callback->gpu_info->processes) {
+        perror("Could not re-allocate memory: ");
+        exit(EXIT_FAILURE);
       }
-      seen_fds[seen_fds_len++] = fd_num;
+    new_empty_process_entry:
+      process_index = current_callback->gpu_info->processes_count++;
+      memset(&current_callback->gpu_info->processes[process_index], 0,
+             sizeof(*current_callback->gpu_info->processes));
+      current_callback->gpu_info->processes[process_index].pid = client_pid;
+    }
+    // No alloc/realloc with different pid case
+    if (current_callback->gpu_info->processes_count == 0 ||
+        current_callback->gpu_info->processes[process_index].pid != (pid_t)client_pid) {
+      goto new_empty_process_entry;
+    }
+    struct gpu_process *process_info = &current_callback->gpu_info->processes[process_index];
 
-      int fdinfo_fd = openat(fdinfo_dir_fd, fdinfo_dent->d_name, O_RDONLY);
-      if (fdinfo_fd < 0)
-        continue;
-      FILE *fdinfo_file = fdopen(fdinfo_fd, "r");
-      if (!fdinfo_file) {
-        close(fdinfo_fd);
-        continue;
-      }
+    process_info->type = processes_info_local.type;
 
-      bool callback_success = false;
-      struct callback_entry *current_callback = NULL;
-      processes_info_local.pid = client_pid;
-      processes_info_local.type = gpu_process_graphical;
-      for (unsigned callback_idx = 0; !callback_success && callback_idx < registered_callback_entries; ++callback_idx) {
-        rewind(fdinfo_file);
-        fflush(fdinfo_file);
-        RESET_ALL(processes_info_local.valid);
-        current_callback = &callback_entries[callback_idx];
-        callback_success = current_callback->callback(current_callback->gpu_info, fdinfo_file, &processes_info_local);
-      }
-      fclose(fdinfo_file);
-      if (!callback_success)
-        continue;
+    if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, gpu_memory_usage)) {
+      SET_GPUINFO_PROCESS(process_info, gpu_memory_usage,
+                          process_info->gpu_memory_usage + processes_info_local.gpu_memory_usage);
+    }
 
-      unsigned process_index =
-          current_callback->gpu_info->processes_count ? current_callback->gpu_info->processes_count - 1 : 0;
-      // Alloc when array is empty or realloc when this pid does not correspond to the last entry and the array is full
-      if ((current_callback->gpu_info->processes_count == 0 ||
-           current_callback->gpu_info->processes[process_index].pid != (pid_t)client_pid) &&
-          current_callback->gpu_info->processes_count == current_callback->gpu_info->processes_array_size) {
-        current_callback->gpu_info->processes_array_size += COMMON_PROCESS_LINEAR_REALLOC_INC;
-        current_callback->gpu_info->processes =
-            reallocarray(current_callback->gpu_info->processes, current_callback->gpu_info->processes_array_size,
-                         sizeof(*current_callback->gpu_info->processes));
-        if (!current_callback->gpu_info->processes) {
-          perror("Could not re-allocate memory: ");
-          exit(EXIT_FAILURE);
-        }
-      new_empty_process_entry:
-        process_index = current_callback->gpu_info->processes_count++;
-        memset(&current_callback->gpu_info->processes[process_index], 0,
-               sizeof(*current_callback->gpu_info->processes));
-        current_callback->gpu_info->processes[process_index].pid = client_pid;
-      }
-      // No alloc/realloc with different pid case
-      if (current_callback->gpu_info->processes_count == 0 ||
-          current_callback->gpu_info->processes[process_index].pid != (pid_t)client_pid) {
-        goto new_empty_process_entry;
-      }
-      struct gpu_process *process_info = &current_callback->gpu_info->processes[process_index];
+    if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, gpu_usage)) {
+      SET_GPUINFO_PROCESS(process_info, gpu_usage, process_info->gpu_usage + processes_info_local.gpu_usage);
+    }
 
-      process_info->type = processes_info_local.type;
+    if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, encode_usage)) {
+      SET_GPUINFO_PROCESS(process_info, encode_usage, process_info->encode_usage + processes_info_local.encode_usage);
+    }
 
-      if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, gpu_memory_usage)) {
-        SET_GPUINFO_PROCESS(process_info, gpu_memory_usage,
-                            process_info->gpu_memory_usage + processes_info_local.gpu_memory_usage);
-      }
+    if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, decode_usage)) {
+      SET_GPUINFO_PROCESS(process_info, decode_usage, process_info->decode_usage + processes_info_local.decode_usage);
+    }
 
-      if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, gpu_usage)) {
-        SET_GPUINFO_PROCESS(process_info, gpu_usage, process_info->gpu_usage + processes_info_local.gpu_usage);
-      }
+    if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, gfx_engine_used)) {
+      SET_GPUINFO_PROCESS(process_info, gfx_engine_used,
+                          process_info->gfx_engine_used + processes_info_local.gfx_engine_used);
+    }
 
-      if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, encode_usage)) {
-        SET_GPUINFO_PROCESS(process_info, encode_usage, process_info->encode_usage + processes_info_local.encode_usage);
-      }
+    if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, compute_engine_used)) {
+      SET_GPUINFO_PROCESS(process_info, compute_engine_used,
+                          process_info->compute_engine_used + processes_info_local.compute_engine_used);
+    }
 
-      if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, decode_usage)) {
-        SET_GPUINFO_PROCESS(process_info, decode_usage, process_info->decode_usage + processes_info_local.decode_usage);
-      }
+    if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, enc_engine_used)) {
+      SET_GPUINFO_PROCESS(process_info, enc_engine_used,
+                          process_info->enc_engine_used + processes_info_local.enc_engine_used);
+    }
 
-      if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, gfx_engine_used)) {
-        SET_GPUINFO_PROCESS(process_info, gfx_engine_used,
-                            process_info->gfx_engine_used + processes_info_local.gfx_engine_used);
-      }
+    if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, dec_engine_used)) {
+      SET_GPUINFO_PROCESS(process_info, dec_engine_used,
+                          process_info->dec_engine_used + processes_info_local.dec_engine_used);
+    }
+  }
 
-      if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, compute_engine_used)) {
-        SET_GPUINFO_PROCESS(process_info, compute_engine_used,
-                            process_info->compute_engine_used + processes_info_local.compute_engine_used);
-      }
+next:
+  if (fdinfo_dir)
+    closedir(fdinfo_dir);
 
-      if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, enc_engine_used)) {
-        SET_GPUINFO_PROCESS(process_info, enc_engine_used,
-                            process_info->enc_engine_used + processes_info_local.enc_engine_used);
-      }
+  if (fd_dir_fd >= 0)
+    close(fd_dir_fd);
+  close(pid_dir_fd);
+}
 
-      if (GPUINFO_PROCESS_FIELD_VALID(&processes_info_local, dec_engine_used)) {
-        SET_GPUINFO_PROCESS(process_info, dec_engine_used,
-                            process_info->dec_engine_used + processes_info_local.dec_engine_used);
-      }
-    }
+void processinfo_sweep_fdinfos(void) {
+  if (registered_callback_entries == 0)
+    return;
 
-  next:
-    if (fdinfo_dir)
-      closedir(fdinfo_dir);
+  DIR *proc_dir = opendir("/proc");
+  if (!proc_dir)
+    return;
 
-    if (fd_dir_fd >= 0)
-      close(fd_dir_fd);
-    close(pid_dir_fd);
+  if (process_scope_active()) {
+    unsigned scope_pids_count;
+    const pid_t *scope_pids = process_scope_pids(&scope_pids_count);
+    for (unsigned i = 0; i < scope_pids_count; ++i) {
+      char pid_name[24];
+      snprintf(pid_name, sizeof(pid_name), "%" PRIdMAX, (intmax_t)scope_pids[i]);
+      sweep_process_fdinfos(dirfd(proc_dir), pid_name);
+    }
+  } else {
+    struct dirent *proc_dent;
+    while ((proc_dent = readdir(proc_dir)) != NULL) {
+      if (proc_dent->d_type != DT_DIR)
+        continue;
+      if (!isdigit(proc_dent->d_name[0]))
+        continue;
+      sweep_process_fdinfos(dirfd(proc_dir), proc_dent->d_name);
+    }
   }
 
   closedir(proc_dir);
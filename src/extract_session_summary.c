@@ -0,0 +1,366 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/extract_session_summary.h"
+#include "nvtop/common.h"
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/time.h"
+#include "uthash.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The device is considered throttled while at its slowdown temperature or
+// that close to its enforced power limit
+static const double power_limit_margin = 0.98;
+
+struct device_summary {
+  const struct gpu_info *device;
+  unsigned id; // Position in the device list, as numbered by the interface
+  char name[MAX_DEVICE_NAME];
+  char pdev[MAX_PDEV_NAME];
+  bool sampling;
+  nvtop_time last_sample;
+  double observed;  // Seconds
+  double throttled; // Seconds
+  unsigned long long utilization_samples;
+  double utilization_sum;
+  unsigned long long utilization_histogram[101];
+  bool memory_valid;
+  unsigned long long peak_memory;
+  bool energy_valid;
+  double energy; // Joules
+  double stranded_time;   // Seconds
+  double stranded_energy; // Joules
+};
+
+struct process_summary_key {
+  pid_t pid;
+  unsigned long long start_time;
+};
+
+struct process_summary {
+  struct process_summary_key key;
+  char *cmdline;
+  nvtop_time first_seen;
+  nvtop_time last_seen;
+  unsigned last_refresh;
+  double gpu_time; // Seconds
+  unsigned long long refresh_memory;
+  unsigned long long peak_memory;
+  double cpu_usage_sum;
+  unsigned cpu_samples;
+  double longest_stranded; // Seconds
+  bool energy_valid;
+  double stranded_energy;  // Joules, summed over the devices
+  UT_hash_handle hh;
+};
+
+static bool enabled = false;
+static nvtop_time session_start;
+static unsigned device_summaries_count = 0;
+static struct device_summary *device_summaries = NULL;
+static struct process_summary *processes = NULL;
+static unsigned refresh_count = 0;
+static nvtop_time refresh_time;
+
+void session_summary_enable(void) {
+  enabled = true;
+  nvtop_get_current_time(&session_start);
+}
+
+bool session_summary_enabled(void) { return enabled; }
+
+static struct device_summary *find_device_summary(const struct gpu_info *device) {
+  for (unsigned i = 0; i < device_summaries_count; ++i) {
+    if (device_summaries[i].device == device)
+      return &device_summaries[i];
+  }
+  device_summaries = reallocarray(device_summaries, device_summaries_count + 1, sizeof(*device_summaries));
+  if (!device_summaries) {
+    perror("Could not allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  struct device_summary *summary = &device_summaries[device_summaries_count++];
+  memset(summary, 0, sizeof(*summary));
+  summary->device = device;
+  return summary;
+}
+
+static bool device_throttled(const struct gpu_info *device) {
+  const struct gpuinfo_dynamic_info *dynamic_info = &device->dynamic_info;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, gpu_temp) &&
+      GPUINFO_STATIC_FIELD_VALID(&device->static_info, temperature_slowdown_threshold) &&
+      dynamic_info->gpu_temp >= device->static_info.temperature_slowdown_threshold)
+    return true;
+  return GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, power_draw) &&
+         GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, power_draw_max) && dynamic_info->power_draw_max > 0 &&
+         dynamic_info->power_draw >= power_limit_margin * dynamic_info->power_draw_max;
+}
+
+static void record_device(const struct gpu_info *device, unsigned id) {
+  struct device_summary *summary = find_device_summary(device);
+  summary->id = id;
+  if (GPUINFO_STATIC_FIELD_VALID(&device->static_info, device_name))
+    strncpy(summary->name, device->static_info.device_name, sizeof(summary->name) - 1);
+  if (GPUINFO_STATIC_FIELD_VALID(&device->static_info, pdev))
+    strncpy(summary->pdev, device->static_info.pdev, sizeof(summary->pdev) - 1);
+
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  if (summary->sampling) {
+    double interval = nvtop_difftime(summary->last_sample, now);
+    summary->observed += interval;
+    if (device_throttled(device))
+      summary->throttled += interval;
+  }
+  summary->sampling = true;
+  summary->last_sample = now;
+
+  const struct gpuinfo_dynamic_info *dynamic_info = &device->dynamic_info;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, gpu_util_rate)) {
+    unsigned utilization = dynamic_info->gpu_util_rate > 100 ? 100 : dynamic_info->gpu_util_rate;
+    summary->utilization_samples++;
+    summary->utilization_sum += utilization;
+    summary->utilization_histogram[utilization]++;
+  }
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, used_memory)) {
+    summary->memory_valid = true;
+    if (dynamic_info->used_memory > summary->peak_memory)
+      summary->peak_memory = dynamic_info->used_memory;
+  }
+  if (device->energy.sampling) {
+    summary->energy_valid = true;
+    summary->energy = device->energy.consumed;
+  }
+  summary->stranded_time = device->stranded.time;
+  summary->stranded_energy = device->stranded.energy;
+}
+
+void session_summary_record_devices(struct list_head *devices) {
+  if (!enabled)
+    return;
+  struct gpu_info *device;
+  unsigned id = 0;
+  list_for_each_entry(device, devices, list) {
+    if (!gpuinfo_is_placeholder_device(device))
+      record_device(device, id);
+    id++;
+  }
+}
+
+void session_summary_begin_process_refresh(void) {
+  if (!enabled)
+    return;
+  refresh_count++;
+  nvtop_get_current_time(&refresh_time);
+}
+
+static struct process_summary *find_process_summary(pid_t pid, unsigned long long start_time) {
+  struct process_summary_key key;
+  memset(&key, 0, sizeof(key));
+  key.pid = pid;
+  key.start_time = start_time;
+  struct process_summary *summary;
+  HASH_FIND(hh, processes, &key, sizeof(key), summary);
+  return summary;
+}
+
+void session_summary_record_process(const struct gpu_process *process, unsigned long long start_time,
+                                    double busy_time) {
+  if (!enabled)
+    return;
+  struct process_summary *summary = find_process_summary(process->pid, start_time);
+  if (!summary) {
+    summary = calloc(1, sizeof(*summary));
+    if (!summary) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    summary->key.pid = process->pid;
+    summary->key.start_time = start_time;
+    summary->first_seen = refresh_time;
+    HASH_ADD(hh, processes, key, sizeof(summary->key), summary);
+  }
+  if (!summary->cmdline && GPUINFO_PROCESS_FIELD_VALID(process, cmdline)) {
+    summary->cmdline = strdup(process->cmdline);
+    if (!summary->cmdline) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+  }
+  summary->gpu_time += busy_time;
+
+  // The process may use several devices, its memory is summed over them and
+  // its CPU usage only counted once per refresh
+  if (summary->last_refresh != refresh_count) {
+    summary->last_refresh = refresh_count;
+    summary->last_seen = refresh_time;
+    summary->refresh_memory = 0;
+    if (GPUINFO_PROCESS_FIELD_VALID(process, cpu_usage)) {
+      summary->cpu_usage_sum += process->cpu_usage;
+      summary->cpu_samples++;
+    }
+  }
+  if (GPUINFO_PROCESS_FIELD_VALID(process, gpu_memory_usage)) {
+    summary->refresh_memory += process->gpu_memory_usage;
+    if (summary->refresh_memory > summary->peak_memory)
+      summary->peak_memory = summary->refresh_memory;
+  }
+}
+
+void session_summary_record_stranded(pid_t pid, unsigned long long start_time,
+                                     const struct gpuinfo_stranded *stranded, bool energy_valid, double energy) {
+  if (!enabled)
+    return;
+  struct process_summary *summary = find_process_summary(pid, start_time);
+  if (!summary)
+    return;
+  double stranded_time;
+  if (gpuinfo_stranded_duration(stranded, &stranded_time) && stranded_time > summary->longest_stranded)
+    summary->longest_stranded = stranded_time;
+  if (energy_valid) {
+    summary->energy_valid = true;
+    summary->stranded_energy += energy;
+  }
+}
+
+void session_summary_process_exited(pid_t pid, unsigned long long start_time) {
+  if (!enabled)
+    return;
+  struct process_summary *summary = find_process_summary(pid, start_time);
+  if (summary)
+    nvtop_get_current_time(&summary->last_seen);
+}
+
+static void format_duration(char *buffer, size_t size, double seconds) {
+  unsigned long total = (unsigned long)seconds;
+  if (total >= 3600)
+    snprintf(buffer, size, "%luh%02lum%02lus", total / 3600, total / 60 % 60, total % 60);
+  else if (total >= 60)
+    snprintf(buffer, size, "%lum%02lus", total / 60, total % 60);
+  else
+    snprintf(buffer, size, "%.1fs", seconds);
+}
+
+static const char *memory_prefix[] = {"B", "KiB", "MiB", "GiB", "TiB", "PiB"};
+
+static void format_memory(char *buffer, size_t size, unsigned long long bytes) {
+  double prefixed = bytes;
+  size_t prefix_off;
+  for (prefix_off = 0; prefix_off < 5 && prefixed >= 1024.; ++prefix_off)
+    prefixed /= 1024.;
+  snprintf(buffer, size, "%.1f%s", prefixed, memory_prefix[prefix_off]);
+}
+
+static unsigned utilization_percentile(const struct device_summary *summary, double fraction) {
+  unsigned long long target = (unsigned long long)(fraction * summary->utilization_samples);
+  unsigned long long cumulated = 0;
+  unsigned utilization;
+  for (utilization = 0; utilization < 100; ++utilization) {
+    cumulated += summary->utilization_histogram[utilization];
+    if (cumulated > target)
+      break;
+  }
+  return utilization;
+}
+
+static int compare_gpu_time(const struct process_summary *a, const struct process_summary *b) {
+  if (a->gpu_time > b->gpu_time)
+    return -1;
+  return a->gpu_time < b->gpu_time;
+}
+
+void session_summary_report(FILE *output) {
+  if (!enabled)
+    return;
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  char duration[32], memory[32], energy[32];
+  format_duration(duration, sizeof(duration), nvtop_difftime(session_start, now));
+  fprintf(output, "nvtop session summary over %s\n\n", duration);
+
+  fprintf(output, "%3s %-12s %-32s %7s %7s %10s %10s %10s %10s %10s\n", "DEV", "PCI", "NAME", "GPU AVG", "GPU P95", "PEAK MEM",
+          "ENERGY", "THROTTLED", "STRANDED", "IDLE NRG");
+  for (unsigned i = 0; i < device_summaries_count; ++i) {
+    const struct device_summary *summary = &device_summaries[i];
+    fprintf(output, "%3u %-12.12s %-32.32s ", summary->id, summary->pdev[0] ? summary->pdev : "N/A",
+            summary->name[0] ? summary->name : "N/A");
+    if (summary->utilization_samples)
+      fprintf(output, "%6.0f%% %6u%% ", summary->utilization_sum / summary->utilization_samples,
+              utilization_percentile(summary, 0.95));
+    else
+      fprintf(output, "%7s %7s ", "N/A", "N/A");
+    if (summary->memory_valid)
+      format_memory(memory, sizeof(memory), summary->peak_memory);
+    else
+      strcpy(memory, "N/A");
+    if (summary->energy_valid)
+      snprintf(energy, sizeof(energy), "%.1fkJ", summary->energy / 1000.);
+    else
+      strcpy(energy, "N/A");
+    format_duration(duration, sizeof(duration), summary->throttled);
+    fprintf(output, "%10s %10s %10s ", memory, energy, duration);
+    format_duration(duration, sizeof(duration), summary->stranded_time);
+    if (summary->energy_valid)
+      snprintf(energy, sizeof(energy), "%.1fkJ", summary->stranded_energy / 1000.);
+    fprintf(output, "%10s %10s\n", duration, energy);
+  }
+
+  if (!processes)
+    return;
+  HASH_SORT(processes, compare_gpu_time);
+  fprintf(output, "\n%7s %10s %10s %7s %10s %10s %10s %s\n", "PID", "GPU TIME", "PEAK MEM", "CPU AVG", "LIFETIME",
+          "STRANDED", "IDLE NRG", "Command");
+  struct process_summary *summary, *tmp;
+  HASH_ITER(hh, processes, summary, tmp) {
+    char gpu_time[32];
+    format_duration(gpu_time, sizeof(gpu_time), summary->gpu_time);
+    format_memory(memory, sizeof(memory), summary->peak_memory);
+    format_duration(duration, sizeof(duration), nvtop_difftime(summary->first_seen, summary->last_seen));
+    fprintf(output, "%7d %10s %10s ", (int)summary->key.pid, gpu_time, memory);
+    if (summary->cpu_samples)
+      fprintf(output, "%6.0f%% ", summary->cpu_usage_sum / summary->cpu_samples);
+    else
+      fprintf(output, "%7s ", "N/A");
+    fprintf(output, "%10s ", duration);
+    format_duration(duration, sizeof(duration), summary->longest_stranded);
+    if (summary->energy_valid)
+      snprintf(energy, sizeof(energy), "%.1fkJ", summary->stranded_energy / 1000.);
+    else
+      strcpy(energy, "N/A");
+    fprintf(output, "%10s %10s %s\n", duration, energy, summary->cmdline ? summary->cmdline : "N/A");
+  }
+}
+
+void session_summary_clear(void) {
+  struct process_summary *summary, *tmp;
+  HASH_ITER(hh, processes, summary, tmp) {
+    HASH_DEL(processes, summary);
+    free(summary->cmdline);
+    free(summary);
+  }
+  free(device_summaries);
+  device_summaries = NULL;
+  device_summaries_count = 0;
+  refresh_count = 0;
+}
@@ -0,0 +1,377 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/flight_recorder.h"
+#include "nvtop/common.h"
+#include "nvtop/extract_gpuinfo.h"
+#include "nvtop/time.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum recorder_field {
+  recorder_gpu_util,
+  recorder_mem_util,
+  recorder_temperature,
+  recorder_power,
+  recorder_gpu_clock,
+  recorder_mem_clock,
+  recorder_fan_speed,
+  recorder_encoder,
+  recorder_decoder,
+  recorder_pcie_rx,
+  recorder_pcie_tx,
+  recorder_field_count,
+};
+
+static const char *recorder_field_names[recorder_field_count] = {
+    [recorder_gpu_util] = "gpu_util",       [recorder_mem_util] = "mem_util",
+    [recorder_temperature] = "temperature", [recorder_power] = "power",
+    [recorder_gpu_clock] = "gpu_clock",     [recorder_mem_clock] = "mem_clock",
+    [recorder_fan_speed] = "fan_speed",     [recorder_encoder] = "encoder",
+    [recorder_decoder] = "decoder",         [recorder_pcie_rx] = "pcie_rx",
+    [recorder_pcie_tx] = "pcie_tx",
+};
+
+enum recorder_comparison {
+  recorder_less,
+  recorder_less_equal,
+  recorder_greater,
+  recorder_greater_equal,
+};
+
+struct recorder_trigger {
+  int device; // Negative for any device
+  enum recorder_field field;
+  enum recorder_comparison comparison;
+  double threshold;
+  const char *text; // Points into the trigger list
+  size_t text_length;
+};
+
+// NAN for the fields the device did not report
+struct recorder_snapshot {
+  uint64_t timestamp;
+  unsigned device;
+  double values[recorder_field_count];
+};
+
+static struct {
+  bool enabled;
+  char *triggers_text;
+  char *trace_file;
+  unsigned seconds;
+  uint64_t window; // Nanoseconds before and after the trigger
+  unsigned devices_count;
+  unsigned triggers_count;
+  struct recorder_trigger *triggers;
+  bool primed;           // The conditions were evaluated once
+  bool *condition_held;  // Per trigger and device, at the previous tick
+  unsigned capacity;
+  unsigned next;
+  unsigned count;
+  struct recorder_snapshot *ring;
+  bool capturing;
+  uint64_t trigger_time;
+  const struct recorder_trigger *fired;
+  unsigned fired_device;
+} recorder;
+
+static void *recorder_alloc(size_t count, size_t size) {
+  void *ptr = calloc(count, size);
+  if (!ptr) {
+    perror("Could not allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
+
+static void release_recorder(void) {
+  free(recorder.triggers_text);
+  free(recorder.trace_file);
+  free(recorder.triggers);
+  free(recorder.condition_held);
+  free(recorder.ring);
+  memset(&recorder, 0, sizeof(recorder));
+}
+
+static const char *skip_spaces(const char *str) {
+  while (isspace((unsigned char)*str))
+    str++;
+  return str;
+}
+
+static bool parse_trigger(const char *text, struct recorder_trigger *trigger, const char **error) {
+  const char *str = skip_spaces(text);
+  trigger->text = str;
+  trigger->device = -1;
+  char *end;
+  if (isdigit((unsigned char)*str)) {
+    long device = strtol(str, &end, 10);
+    if (*end != ':') {
+      *error = "expected device:field";
+      return false;
+    }
+    trigger->device = (int)device;
+    str = skip_spaces(end + 1);
+  }
+  size_t name_length = 0;
+  while (isalnum((unsigned char)str[name_length]) || str[name_length] == '_')
+    name_length++;
+  unsigned field;
+  for (field = 0; field < recorder_field_count; ++field) {
+    if (strlen(recorder_field_names[field]) == name_length &&
+        strncmp(str, recorder_field_names[field], name_length) == 0)
+      break;
+  }
+  if (field == recorder_field_count) {
+    *error = "unknown field";
+    return false;
+  }
+  trigger->field = field;
+  str = skip_spaces(str + name_length);
+  if (str[0] == '<' || str[0] == '>') {
+    bool or_equal = str[1] == '=';
+    if (str[0] == '<')
+      trigger->comparison = or_equal ? recorder_less_equal : recorder_less;
+    else
+      trigger->comparison = or_equal ? recorder_greater_equal : recorder_greater;
+    str += or_equal ? 2 : 1;
+  } else {
+    *error = "expected one of <, <=, >, >=";
+    return false;
+  }
+  trigger->threshold = strtod(str, &end);
+  if (end == str) {
+    *error = "expected a number";
+    return false;
+  }
+  str = skip_spaces(end);
+  if (*str != ',' && *str != '\0') {
+    *error = "expected a comma between the triggers";
+    return false;
+  }
+  trigger->text_length = (size_t)(end - trigger->text);
+  return true;
+}
+
+bool flight_recorder_configure(const char *triggers, const char *trace_file, unsigned seconds,
+                               const char **error) {
+  flight_recorder_clear();
+  if (!triggers || !*skip_spaces(triggers))
+    return true;
+  if (!trace_file || !*trace_file) {
+    *error = "no trace file given";
+    return false;
+  }
+  if (!seconds)
+    return true;
+
+  recorder.triggers_text = strdup(triggers);
+  recorder.trace_file = strdup(trace_file);
+  if (!recorder.triggers_text || !recorder.trace_file) {
+    perror("Could not allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  unsigned count = 1;
+  for (const char *str = triggers; *str; ++str)
+    count += *str == ',';
+  recorder.triggers = recorder_alloc(count, sizeof(*recorder.triggers));
+  const char *str = recorder.triggers_text;
+  for (unsigned i = 0; i < count; ++i) {
+    if (!parse_trigger(str, &recorder.triggers[i], error)) {
+      release_recorder();
+      return false;
+    }
+    str = strchr(str, ',') + 1;
+  }
+  recorder.triggers_count = count;
+  recorder.seconds = seconds;
+  recorder.window = (uint64_t)seconds * UINT64_C(1000000000);
+  recorder.enabled = true;
+  return true;
+}
+
+void flight_recorder_set_devices_count(unsigned devices_count) {
+  if (!recorder.enabled || !devices_count || devices_count == recorder.devices_count)
+    return;
+  bool *condition_held = recorder_alloc(recorder.triggers_count * devices_count, sizeof(*condition_held));
+  unsigned kept_devices = devices_count < recorder.devices_count ? devices_count : recorder.devices_count;
+  for (unsigned i = 0; i < recorder.triggers_count; ++i)
+    for (unsigned j = 0; j < kept_devices; ++j)
+      condition_held[i * devices_count + j] = recorder.condition_held[i * recorder.devices_count + j];
+
+  // The window before the trigger at the burst rate at most, as much after
+  unsigned capacity = 2 * recorder.seconds * (1000 / FLIGHT_RECORDER_BURST_INTERVAL) * devices_count;
+  struct recorder_snapshot *ring = recorder_alloc(capacity, sizeof(*ring));
+  // The most recent snapshots of the devices still there move over, oldest first
+  unsigned count = 0;
+  unsigned oldest = recorder.count < recorder.capacity ? 0 : recorder.next;
+  for (unsigned i = 0; i < recorder.count; ++i) {
+    const struct recorder_snapshot *snapshot = &recorder.ring[(oldest + i) % recorder.capacity];
+    if (snapshot->device < devices_count)
+      ring[count++ % capacity] = *snapshot;
+  }
+
+  free(recorder.condition_held);
+  free(recorder.ring);
+  recorder.condition_held = condition_held;
+  recorder.ring = ring;
+  recorder.devices_count = devices_count;
+  recorder.capacity = capacity;
+  recorder.next = count % capacity;
+  recorder.count = count < capacity ? count : capacity;
+}
+
+bool flight_recorder_capturing(void) { return recorder.capturing; }
+
+static void take_snapshot(struct recorder_snapshot *snapshot, const struct gpu_info *device) {
+  const struct gpuinfo_dynamic_info *dynamic_info = &device->dynamic_info;
+  double *values = snapshot->values;
+  for (unsigned i = 0; i < recorder_field_count; ++i)
+    values[i] = NAN;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, gpu_util_rate))
+    values[recorder_gpu_util] = dynamic_info->gpu_util_rate;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, total_memory) &&
+      GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, used_memory) && dynamic_info->total_memory)
+    values[recorder_mem_util] = 100. * dynamic_info->used_memory / dynamic_info->total_memory;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, gpu_temp))
+    values[recorder_temperature] = dynamic_info->gpu_temp;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, power_draw))
+    values[recorder_power] = dynamic_info->power_draw / 1000.;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, gpu_clock_speed))
+    values[recorder_gpu_clock] = dynamic_info->gpu_clock_speed;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, mem_clock_speed))
+    values[recorder_mem_clock] = dynamic_info->mem_clock_speed;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, fan_speed))
+    values[recorder_fan_speed] = dynamic_info->fan_speed;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, encoder_rate))
+    values[recorder_encoder] = dynamic_info->encoder_rate;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, decoder_rate))
+    values[recorder_decoder] = dynamic_info->decoder_rate;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, pcie_rx))
+    values[recorder_pcie_rx] = dynamic_info->pcie_rx;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(dynamic_info, pcie_tx))
+    values[recorder_pcie_tx] = dynamic_info->pcie_tx;
+}
+
+// Comparisons with a missing value (NAN) never hold
+static bool trigger_holds(const struct recorder_trigger *trigger, const struct recorder_snapshot *snapshot) {
+  double value = snapshot->values[trigger->field];
+  switch (trigger->comparison) {
+  case recorder_less:
+    return value < trigger->threshold;
+  case recorder_less_equal:
+    return value <= trigger->threshold;
+  case recorder_greater:
+    return value > trigger->threshold;
+  case recorder_greater_equal:
+    return value >= trigger->threshold;
+  }
+  return false;
+}
+
+static void evaluate_triggers(const struct recorder_snapshot *snapshot) {
+  for (unsigned i = 0; i < recorder.triggers_count; ++i) {
+    const struct recorder_trigger *trigger = &recorder.triggers[i];
+    if (trigger->device >= 0 && (unsigned)trigger->device != snapshot->device)
+      continue;
+    bool holds = trigger_holds(trigger, snapshot);
+    bool *held = &recorder.condition_held[i * recorder.devices_count + snapshot->device];
+    if (holds && !*held && recorder.primed && !recorder.capturing) {
+      recorder.capturing = true;
+      recorder.trigger_time = snapshot->timestamp;
+      recorder.fired = trigger;
+      recorder.fired_device = snapshot->device;
+    }
+    *held = holds;
+  }
+}
+
+static void write_incident(void) {
+  FILE *trace = fopen(recorder.trace_file, "a");
+  if (!trace)
+    return;
+  fprintf(trace, "# Trigger %.*s on device %u, %.0fs before and after\n", (int)recorder.fired->text_length,
+          recorder.fired->text, recorder.fired_device, recorder.window / 1e9);
+  fprintf(trace, "time,device");
+  for (unsigned i = 0; i < recorder_field_count; ++i)
+    fprintf(trace, ",%s", recorder_field_names[i]);
+  fprintf(trace, "\n");
+  unsigned oldest = recorder.count < recorder.capacity ? 0 : recorder.next;
+  for (unsigned i = 0; i < recorder.count; ++i) {
+    const struct recorder_snapshot *snapshot = &recorder.ring[(oldest + i) % recorder.capacity];
+    if (snapshot->timestamp + recorder.window < recorder.trigger_time)
+      continue;
+    fprintf(trace, "%.3f,%u", ((double)snapshot->timestamp - (double)recorder.trigger_time) / 1e9,
+            snapshot->device);
+    for (unsigned j = 0; j < recorder_field_count; ++j) {
+      if (isnan(snapshot->values[j]))
+        fprintf(trace, ",");
+      else
+        fprintf(trace, ",%g", snapshot->values[j]);
+    }
+    fprintf(trace, "\n");
+  }
+  fprintf(trace, "\n");
+  fclose(trace);
+}
+
+void flight_recorder_tick(struct list_head *devices) {
+  if (!recorder.enabled || !recorder.capacity)
+    return;
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  uint64_t timestamp = nvtop_time_u64(now);
+  unsigned index = 0;
+  struct gpu_info *device;
+  list_for_each_entry(device, devices, list) {
+    if (index >= recorder.devices_count)
+      break;
+    if (gpuinfo_is_placeholder_device(device)) {
+      index++;
+      continue;
+    }
+    struct recorder_snapshot *snapshot = &recorder.ring[recorder.next];
+    recorder.next = (recorder.next + 1) % recorder.capacity;
+    if (recorder.count < recorder.capacity)
+      recorder.count++;
+    snapshot->timestamp = timestamp;
+    snapshot->device = index++;
+    take_snapshot(snapshot, device);
+    evaluate_triggers(snapshot);
+  }
+  recorder.primed = true;
+  if (recorder.capturing && timestamp >= recorder.trigger_time + recorder.window) {
+    write_incident();
+    recorder.capturing = false;
+  }
+}
+
+void flight_recorder_clear(void) {
+  if (recorder.capturing)
+    write_incident();
+  release_recorder();
+}
@@ -20,7 +20,10 @@
  */
 
 #include "nvtop/get_process_info.h"
+#include "nvtop/common.h"
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <inttypes.h>
 #include <pwd.h>
 #include <stdbool.h>
@@ -196,18 +199,180 @@ bool get_process_info(pid_t pid, struct process_cpu_usage *usage) {
   unsigned long total_kernel_time; // in clock_ticks
   unsigned long virtual_memory;    // In bytes
   long resident_memory;            // In page number?
+  long num_threads;
+  unsigned long long start_time;   // in clock_ticks
+  intmax_t parent_pid;
 
   int retval = fscanf(stat_file,
-                      "%*d %*[^)]) %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u "
-                      "%*u %lu %lu %*d %*d %*d %*d %*d %*d %*u %lu %ld",
-                      &total_user_time, &total_kernel_time, &virtual_memory,
+                      "%*d %*[^)]) %*c %" SCNdMAX " %*d %*d %*d %*d %*u %*u %*u %*u "
+                      "%*u %lu %lu %*d %*d %*d %*d %ld %*d %llu %lu %ld",
+                      &parent_pid, &total_user_time, &total_kernel_time,
+                      &num_threads, &start_time, &virtual_memory,
                       &resident_memory);
   fclose(stat_file);
-  if (retval != 4)
+  if (retval != 7)
     return false;
+  usage->parent_pid = (pid_t)parent_pid;
+  usage->start_time = start_time;
   usage->total_user_time = total_user_time / clock_ticks_per_second;
   usage->total_kernel_time = total_kernel_time / clock_ticks_per_second;
   usage->virtual_memory = virtual_memory;
   usage->resident_memory = (size_t)resident_memory * page_size;
+  usage->num_threads = num_threads > 0 ? (unsigned)num_threads : 0;
+  return true;
+}
+
+// rchar and wchar include the reads served from the page cache and the
+// network, which is what a data loader waits on
+bool get_process_io(pid_t pid, struct process_io_usage *usage) {
+  int written = snprintf(pid_path, pid_path_size, "/proc/%" PRIdMAX "/io",
+                         (intmax_t)pid);
+  if (written == pid_path_size)
+    return false;
+  FILE *io_file = fopen(pid_path, "r");
+  if (!io_file)
+    return false;
+  nvtop_get_current_time(&usage->timestamp);
+  int retval = fscanf(io_file, "rchar: %llu wchar: %llu", &usage->read_bytes,
+                      &usage->write_bytes);
+  fclose(io_file);
+  return retval == 2;
+}
+
+bool get_process_affinity(pid_t pid, struct process_affinity *affinity) {
+  static const char cpus_allowed[] = "Cpus_allowed_list:";
+  static const char mems_allowed[] = "Mems_allowed_list:";
+  int written = snprintf(pid_path, pid_path_size, "/proc/%" PRIdMAX "/status",
+                         (intmax_t)pid);
+  if (written == pid_path_size)
+    return false;
+  FILE *status_file = fopen(pid_path, "r");
+  if (!status_file)
+    return false;
+  bool cpus_read = false, mems_read = false;
+  char *line = NULL;
+  size_t line_size = 0;
+  while ((!cpus_read || !mems_read) &&
+         getline(&line, &line_size, status_file) != -1) {
+    if (strncmp(line, cpus_allowed, sizeof(cpus_allowed) - 1) == 0)
+      cpus_read = cpu_mask_parse_list(line + sizeof(cpus_allowed) - 1,
+                                      &affinity->cpus_allowed);
+    else if (strncmp(line, mems_allowed, sizeof(mems_allowed) - 1) == 0)
+      mems_read = cpu_mask_parse_list(line + sizeof(mems_allowed) - 1,
+                                      &affinity->mems_allowed);
+  }
+  free(line);
+  fclose(status_file);
+  return cpus_read && mems_read;
+}
+
+bool get_process_thread_ids(pid_t pid, unsigned *count, unsigned *capacity,
+                            pid_t **tids) {
+  int written = snprintf(pid_path, pid_path_size, "/proc/%" PRIdMAX "/task",
+                         (intmax_t)pid);
+  if (written == pid_path_size)
+    return false;
+  DIR *task_dir = opendir(pid_path);
+  if (!task_dir)
+    return false;
+  *count = 0;
+  struct dirent *entry;
+  while ((entry = readdir(task_dir)) != NULL) {
+    char *endptr;
+    long tid = strtol(entry->d_name, &endptr, 10);
+    if (*endptr != '\0' || tid <= 0)
+      continue;
+    if (*count == *capacity) {
+      unsigned new_capacity = COMMON_PROCESS_GROWN_SIZE(*capacity);
+      pid_t *grown = reallocarray(*tids, new_capacity, sizeof(**tids));
+      if (!grown) {
+        perror("Could not allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+      *tids = grown;
+      *capacity = new_capacity;
+    }
+    (*tids)[(*count)++] = (pid_t)tid;
+  }
+  closedir(task_dir);
+  return true;
+}
+
+// Needs CONFIG_PROC_CHILDREN, the children of a thread are those it forked
+bool get_process_children(pid_t pid, unsigned *count, unsigned *capacity,
+                          pid_t **children) {
+  int written = snprintf(pid_path, pid_path_size, "/proc/%" PRIdMAX "/task",
+                         (intmax_t)pid);
+  if (written == pid_path_size)
+    return false;
+  DIR *task_dir = opendir(pid_path);
+  if (!task_dir)
+    return false;
+  struct dirent *entry;
+  while ((entry = readdir(task_dir)) != NULL) {
+    if (entry->d_name[0] == '.')
+      continue;
+    char children_path[sizeof(entry->d_name) + sizeof("/children")];
+    snprintf(children_path, sizeof(children_path), "%s/children",
+             entry->d_name);
+    int children_fd = openat(dirfd(task_dir), children_path, O_RDONLY);
+    if (children_fd < 0)
+      continue;
+    FILE *children_file = fdopen(children_fd, "r");
+    if (!children_file) {
+      close(children_fd);
+      continue;
+    }
+    intmax_t child;
+    while (fscanf(children_file, "%" SCNdMAX, &child) == 1) {
+      if (*count == *capacity) {
+        unsigned new_capacity = COMMON_PROCESS_GROWN_SIZE(*capacity);
+        pid_t *grown = reallocarray(*children, new_capacity, sizeof(**children));
+        if (!grown) {
+          perror("Could not allocate memory: ");
+          exit(EXIT_FAILURE);
+        }
+        *children = grown;
+        *capacity = new_capacity;
+      }
+      (*children)[(*count)++] = (pid_t)child;
+    }
+    fclose(children_file);
+  }
+  closedir(task_dir);
+  return true;
+}
+
+bool get_thread_info(pid_t pid, pid_t tid, struct thread_cpu_usage *usage) {
+  double clock_ticks_per_second = sysconf(_SC_CLK_TCK);
+  int written = snprintf(pid_path, pid_path_size,
+                         "/proc/%" PRIdMAX "/task/%" PRIdMAX "/stat",
+                         (intmax_t)pid, (intmax_t)tid);
+  if (written == pid_path_size)
+    return false;
+  FILE *stat_file = fopen(pid_path, "r");
+  if (!stat_file)
+    return false;
+  nvtop_get_current_time(&usage->timestamp);
+  char stat_line[1024];
+  bool read_ok = fgets(stat_line, sizeof(stat_line), stat_file) != NULL;
+  fclose(stat_file);
+  if (!read_ok)
+    return false;
+  // The name is between the first '(' and the last ')', and may contain both
+  char *name_start = strchr(stat_line, '(');
+  char *name_end = strrchr(stat_line, ')');
+  if (!name_start || !name_end || name_end < name_start)
+    return false;
+  size_t name_length = name_end - name_start - 1;
+  if (name_length >= THREAD_NAME_SIZE)
+    name_length = THREAD_NAME_SIZE - 1;
+  memcpy(usage->name, name_start + 1, name_length);
+  usage->name[name_length] = '\0';
+  unsigned long user_time, kernel_time;
+  if (sscanf(name_end + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+             &user_time, &kernel_time) != 2)
+    return false;
+  usage->total_time = (user_time + kernel_time) / clock_ticks_per_second;
   return true;
 }
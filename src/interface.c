@@ -21,18 +21,23 @@
 
 #include "nvtop/interface.h"
 #include "nvtop/common.h"
+#include "nvtop/extract_cgroupinfo.h"
 #include "nvtop/extract_gpuinfo.h"
 #include "nvtop/extract_gpuinfo_common.h"
+#include "nvtop/interface_bandwidth.h"
 #include "nvtop/interface_common.h"
 #include "nvtop/interface_internal_common.h"
 #include "nvtop/interface_layout_selection.h"
 #include "nvtop/interface_options.h"
 #include "nvtop/interface_ring_buffer.h"
 #include "nvtop/interface_setup_win.h"
+#include "nvtop/interface_tuning_win.h"
 #include "nvtop/plot.h"
+#include "nvtop/process_actions.h"
 #include "nvtop/time.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <inttypes.h>
 #include <ncurses.h>
 #include <signal.h>
@@ -40,6 +45,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <tgmath.h>
+#include <unistd.h>
 
 static unsigned int sizeof_device_field[device_field_count] = {
     [device_name] = 11,  [device_fan_speed] = 8, [device_temperature] = 10,
@@ -53,6 +59,13 @@ static unsigned int sizeof_process_field[process_field_count] = {
     [process_dec_rate] = 4,
     [process_memory] = 14, // 9 for mem 5 for %
     [process_cpu_usage] = 6, [process_cpu_mem_usage] = 9,
+    [process_energy] = 8,    [process_perf_per_watt] = 6,
+    [process_top_threads] = 24, [process_io_read] = 9,
+    [process_io_write] = 9,     [process_cgroup] = 24,
+    [process_pressure] = 11,    [process_cpu_throttled] = 6,
+    [process_numa] = 6,         [process_time_share] = 5,
+    [process_idle_gaps] = 11,   [process_memory_growth] = 10,
+    [process_bottleneck] = 5,   [process_stranded] = 15,
     [process_command] = 0,
 };
 
@@ -200,6 +213,15 @@ static void free_device_windows(struct device_window *dwin) {
   delwin(dwin->temperature);
   delwin(dwin->fan_speed);
   delwin(dwin->pcie_info);
+  delwin(dwin->grid_line);
+  // The next layout may use the other device view
+  dwin->name_win = dwin->gpu_util_enc_dec = dwin->mem_util_enc_dec = NULL;
+  dwin->gpu_util_no_enc_or_dec = dwin->mem_util_no_enc_or_dec = NULL;
+  dwin->gpu_util_no_enc_and_dec = dwin->mem_util_no_enc_and_dec = NULL;
+  dwin->encode_util = dwin->decode_util = NULL;
+  dwin->gpu_clock_info = dwin->mem_clock_info = NULL;
+  dwin->power_info = dwin->temperature = dwin->fan_speed = NULL;
+  dwin->pcie_info = dwin->grid_line = NULL;
 }
 
 static void alloc_process_with_option(struct nvtop_interface *interface,
@@ -215,6 +237,7 @@ static void alloc_process_with_option(struct nvtop_interface *interface,
   }
   interface->process.selected_row = 0;
   interface->process.selected_pid = -1;
+  interface->process.selected_group = -1;
   interface->process.offset_column = 0;
   interface->process.offset = 0;
 
@@ -356,6 +379,20 @@ static unsigned device_length(void) {
                  sizeof_device_field[device_power] + 4);
 }
 
+// Grid view: one line per device with a utilization sparkline
+static const unsigned grid_min_cols = 40;
+static const unsigned grid_history_size = 64;
+static const char sparkline_levels[] = " .:-=+*#%@";
+
+// The full device header is given up when it would take more than two thirds
+// of the terminal
+static bool device_header_fits(unsigned devices_count, unsigned rows,
+                               unsigned cols) {
+  unsigned per_row = max(1u, cols / device_length());
+  unsigned header_stacks = (devices_count + per_row - 1) / per_row;
+  return header_stacks * 3 <= rows * 2 / 3;
+}
+
 static void initialize_all_windows(struct nvtop_interface *dwin) {
   int rows, cols;
   getmaxyx(stdscr, rows, cols);
@@ -368,8 +405,23 @@ static void initialize_all_windows(struct nvtop_interface *dwin) {
   struct window_position plot_positions[MAX_CHARTS];
   struct window_position setup_position;
 
-  compute_sizes_from_layout(devices_count, 3, device_length(), rows - 1, cols,
-                            dwin->options.device_information_drawn,
+  unsigned header_rows = 3, header_cols = device_length();
+  const plot_info_to_draw *to_draw = dwin->options.device_information_drawn;
+  plot_info_to_draw no_plot[max(1u, devices_count)];
+  dwin->grid_view = dwin->options.device_grid_view ||
+                    !device_header_fits(devices_count, rows - 1, cols);
+  if (dwin->grid_view) {
+    unsigned per_row = max(1u, cols / grid_min_cols);
+    if (per_row > devices_count)
+      per_row = max(1u, devices_count);
+    header_rows = 1;
+    header_cols = cols / per_row - (per_row > 1);
+    memset(no_plot, 0, sizeof(no_plot));
+    to_draw = no_plot;
+  }
+
+  compute_sizes_from_layout(devices_count, header_rows, header_cols, rows - 1,
+                            cols, to_draw,
                             dwin->options.process_fields_displayed,
                             device_positions, &dwin->num_plots, plot_positions,
                             map_device_to_plot, &process_position,
@@ -378,8 +430,16 @@ static void initialize_all_windows(struct nvtop_interface *dwin) {
   alloc_plot_window(devices_count, plot_positions, map_device_to_plot, dwin);
 
   for (unsigned int i = 0; i < devices_count; ++i) {
-    alloc_device_window(device_positions[i].posY, device_positions[i].posX,
-                        device_positions[i].sizeX, &dwin->devices_win[i]);
+    if (dwin->grid_view) {
+      // Only the devices that fit on screen get a window
+      if (device_positions[i].posY < (unsigned)rows - 1)
+        dwin->devices_win[i].grid_line =
+            newwin(1, device_positions[i].sizeX, device_positions[i].posY,
+                   device_positions[i].posX);
+    } else {
+      alloc_device_window(device_positions[i].posY, device_positions[i].posX,
+                          device_positions[i].sizeX, &dwin->devices_win[i]);
+    }
   }
 
   alloc_process_with_option(dwin, process_position.posX, process_position.posY,
@@ -388,6 +448,9 @@ static void initialize_all_windows(struct nvtop_interface *dwin) {
   dwin->shortcut_window = newwin(1, cols, rows - 1, 0);
 
   alloc_setup_window(&setup_position, &dwin->setup_win);
+
+  dwin->bandwidth.redraw_plots = true;
+  dwin->bandwidth.redraw_processes = true;
 }
 
 static void delete_all_windows(struct nvtop_interface *dwin) {
@@ -408,9 +471,20 @@ static void delete_all_windows(struct nvtop_interface *dwin) {
   free(dwin->plots);
 }
 
+static short background_color;
+
+static void init_color_pairs(bool monochrome) {
+  short foreground = background_color == -1 ? -1 : COLOR_WHITE;
+  init_pair(cyan_color, monochrome ? foreground : COLOR_CYAN, background_color);
+  init_pair(red_color, monochrome ? foreground : COLOR_RED, background_color);
+  init_pair(green_color, monochrome ? foreground : COLOR_GREEN, background_color);
+  init_pair(yellow_color, monochrome ? foreground : COLOR_YELLOW, background_color);
+  init_pair(blue_color, monochrome ? foreground : COLOR_BLUE, background_color);
+  init_pair(magenta_color, monochrome ? foreground : COLOR_MAGENTA, background_color);
+}
+
 static void initialize_colors(void) {
   start_color();
-  short background_color;
 #ifdef NCURSES_VERSION
   if (use_default_colors() == OK)
     background_color = -1;
@@ -419,12 +493,7 @@ static void initialize_colors(void) {
 #else
   background_color = COLOR_BLACK;
 #endif
-  init_pair(cyan_color, COLOR_CYAN, background_color);
-  init_pair(red_color, COLOR_RED, background_color);
-  init_pair(green_color, COLOR_GREEN, background_color);
-  init_pair(yellow_color, COLOR_YELLOW, background_color);
-  init_pair(blue_color, COLOR_BLUE, background_color);
-  init_pair(magenta_color, COLOR_MAGENTA, background_color);
+  init_color_pairs(false);
 }
 
 struct nvtop_interface *initialize_curses(unsigned devices_count,
@@ -446,6 +515,12 @@ struct nvtop_interface *initialize_curses(unsigned devices_count,
   keypad(stdscr, TRUE);
   curs_set(0);
 
+  bandwidth_init(&interface->bandwidth, interface->options.bandwidth_budget);
+  process_groups_init(&interface->process.groups);
+  if (bandwidth_limited(&interface->bandwidth))
+    bandwidth_measure_round_trip(&interface->bandwidth, STDIN_FILENO,
+                                 STDOUT_FILENO, 1000);
+
   // Hide decode and encode if not active for some time
   if (interface->options.encode_decode_hiding_timer > 0.) {
     nvtop_time time_now, some_time_in_past;
@@ -464,6 +539,8 @@ struct nvtop_interface *initialize_curses(unsigned devices_count,
 
   interface_alloc_ring_buffer(devices_count, 4, 10 * 60 * 1000,
                               &interface->saved_data_ring);
+  interface_alloc_ring_buffer(devices_count, 1, grid_history_size,
+                              &interface->grid_history);
   initialize_all_windows(interface);
   return interface;
 }
@@ -473,26 +550,42 @@ void clean_ncurses(struct nvtop_interface *interface) {
   delete_all_windows(interface);
   free(interface->options.device_information_drawn);
   free(interface->options.config_file_location);
+  free(interface->options.flight_recorder_triggers);
+  free(interface->options.flight_recorder_trace_file);
   free(interface->devices_win);
   interface_free_ring_buffer(&interface->saved_data_ring);
+  interface_free_ring_buffer(&interface->grid_history);
+  free(interface->process.sorted_rows);
+  free(interface->process.action_targets);
+  process_groups_free(&interface->process.groups);
+  bandwidth_free(&interface->bandwidth);
+  layout_selection_clear_cache();
   free(interface);
 }
 
-static void draw_percentage_meter(WINDOW *win, const char *prelude,
-                                  unsigned int new_percentage,
-                                  const char inside_braces_right[1024]) {
-  int rows, cols;
-  getmaxyx(win, rows, cols);
-  (void)rows;
+void clean_ncurses_keep_options(struct nvtop_interface *interface,
+                                nvtop_interface_option *options) {
+  *options = interface->options;
+  interface->options.device_information_drawn = NULL;
+  interface->options.config_file_location = NULL;
+  interface->options.flight_recorder_triggers = NULL;
+  interface->options.flight_recorder_trace_file = NULL;
+  clean_ncurses(interface);
+}
+
+static void draw_percentage_meter_at(WINDOW *win, int startx, int width,
+                                     const char *prelude,
+                                     unsigned int new_percentage,
+                                     const char *inside_braces_right) {
   size_t size_prelude = strlen(prelude);
   wcolor_set(win, cyan_color, NULL);
-  mvwprintw(win, 0, 0, "%s", prelude);
+  mvwprintw(win, 0, startx, "%s", prelude);
   wstandend(win);
   waddch(win, '[');
   int curx, cury;
   curx = getcurx(win);
   cury = getcury(win);
-  int between_sbraces = cols - size_prelude - 2;
+  int between_sbraces = width - size_prelude - 2;
   float usage = round((float)between_sbraces * new_percentage / 100.f);
   int represent_usage = (int)usage;
   whline(win, '|', (int)represent_usage);
@@ -503,6 +596,16 @@ static void draw_percentage_meter(WINDOW *win, const char *prelude,
   wmove(win, cury, curx + between_sbraces - right_side_braces_space_required);
   wprintw(win, "%s", inside_braces_right);
   mvwchgat(win, cury, curx, represent_usage, 0, green_color, NULL);
+}
+
+static void draw_percentage_meter(WINDOW *win, const char *prelude,
+                                  unsigned int new_percentage,
+                                  const char inside_braces_right[1024]) {
+  int rows, cols;
+  getmaxyx(win, rows, cols);
+  (void)rows;
+  draw_percentage_meter_at(win, 0, cols, prelude, new_percentage,
+                           inside_braces_right);
   wnoutrefresh(win);
 }
 
@@ -635,10 +738,215 @@ static void encode_decode_show_select(struct device_window *dev, bool encode_val
   }
 }
 
+// Share of the window (%) from which the time-slicing of the processes is
+// flagged
+static const unsigned time_sliced_flag_share = 50;
+
+// The processes competed for a saturated engine during a good part of the
+// window
+static bool device_time_shared(const struct gpu_info *device,
+                               unsigned *sliced) {
+  const struct gpuinfo_time_share *time_share = &device->time_share;
+  if (!time_share->valid || time_share->window < 1.)
+    return false;
+  *sliced = (unsigned)(100. * time_share->sliced / time_share->window);
+  return *sliced >= time_sliced_flag_share;
+}
+
+// Seconds to a string of at most 5 characters
+static void format_gap_length(char *buffer, size_t size, double seconds) {
+  if (seconds < 1.)
+    snprintf(buffer, size, "%.0fms", seconds * 1000.);
+  else if (seconds < 10.)
+    snprintf(buffer, size, "%.1fs", seconds);
+  else if (seconds < 1000.)
+    snprintf(buffer, size, "%.0fs", seconds);
+  else
+    snprintf(buffer, size, "%.0fm", fmin(seconds / 60., 999.));
+}
+
+// Median and 95th percentile of the periods the device stayed idle
+static bool device_idle_gaps(const struct gpu_info *device, char *buffer,
+                             size_t size) {
+  double median, p95;
+  if (!duty_cycle_percentiles(&device->duty_cycle.gaps, &median, &p95))
+    return false;
+  char median_text[8], p95_text[8];
+  format_gap_length(median_text, sizeof(median_text), median);
+  format_gap_length(p95_text, sizeof(p95_text), p95);
+  snprintf(buffer, size, "idle %s/%s | ", median_text, p95_text);
+  return true;
+}
+
+// Seconds past which the time before the device memory is full is not shown
+static const double memory_full_display_limit = 24. * 3600.;
+
+// Bytes per second to a signed rate per minute of at most 10 characters
+static void format_memory_growth(char *buffer, size_t size,
+                                 double bytes_per_second) {
+  static const char *prefixes[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+  double per_minute = bytes_per_second * 60.;
+  double magnitude = fabs(per_minute);
+  size_t prefix_off;
+  for (prefix_off = 0; prefix_off < 4 && magnitude >= 1000.; ++prefix_off) {
+    magnitude /= 1024.;
+    per_minute /= 1024.;
+  }
+  snprintf(buffer, size, magnitude < 100. ? "%+.1f%s/m" : "%+.0f%s/m",
+           per_minute, prefixes[prefix_off]);
+}
+
+// Time left under a day to a string of at most 3 characters
+static void format_time_left(char *buffer, size_t size, double seconds) {
+  if (seconds < 60.)
+    snprintf(buffer, size, "%.0fs", seconds);
+  else if (seconds < 3600.)
+    snprintf(buffer, size, "%.0fm", seconds / 60.);
+  else
+    snprintf(buffer, size, "%.0fh", seconds / 3600.);
+}
+
+// Seconds to a string of at most 6 characters
+static void format_stranded_time(char *buffer, size_t size, double seconds) {
+  unsigned long total = (unsigned long)seconds;
+  if (total < 3600)
+    snprintf(buffer, size, "%lum%02lus", total / 60, total % 60);
+  else if (total < 100 * 3600)
+    snprintf(buffer, size, "%luh%02lum", total / 3600, total / 60 % 60);
+  else
+    snprintf(buffer, size, "%lud%02luh", total / 86400, total / 3600 % 24);
+}
+
+// Joules to a string of at most 8 characters
+static void format_energy(char *buffer, size_t size, double joules) {
+  double kilojoules = joules / 1000.;
+  if (kilojoules < 1000.)
+    snprintf(buffer, size, "%.1fkJ", kilojoules);
+  else if (kilojoules < 100000.)
+    snprintf(buffer, size, "%.0fkJ", kilojoules);
+  else
+    snprintf(buffer, size, "%.1fMJ", kilojoules / 1000.);
+}
+
+static void draw_device_grid_line(struct gpu_info *device, unsigned dev_id,
+                                  struct nvtop_interface *interface) {
+  WINDOW *win = interface->devices_win[dev_id].grid_line;
+  int rows, cols;
+  getmaxyx(win, rows, cols);
+  (void)rows;
+  werase(win);
+
+  // Layout: id name GPU[...] MEM[...] temp power [energy] sparkline
+  int sparkline_cols = min(max(cols / 6, 4), (int)grid_history_size);
+  bool show_energy = cols >= 80 && device->energy.sampling;
+  int cols_left = cols - 16 - sparkline_cols - (show_energy ? 9 : 0);
+  int name_cols = 0;
+  if (GPUINFO_STATIC_FIELD_VALID(&device->static_info, device_name) &&
+      cols_left - 28 >= 8)
+    name_cols = min(min((int)strlen(device->static_info.device_name),
+                        cols_left - 28),
+                    24);
+  int meter_cols = (cols_left - (name_cols ? name_cols + 1 : 0)) / 2;
+
+  double stranded_time;
+  if (gpuinfo_stranded_duration(&device->stranded, &stranded_time))
+    wattr_set(win, A_BOLD, magenta_color, NULL);
+  else
+    wcolor_set(win, cyan_color, NULL);
+  mvwprintw(win, 0, 0, "%3u", dev_id);
+  wstandend(win);
+  int posX = 4;
+  if (name_cols) {
+    mvwprintw(win, 0, posX, "%.*s", name_cols, device->static_info.device_name);
+    posX += name_cols + 1;
+  }
+
+  char buff[1024];
+  if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate)) {
+    snprintf(buff, 1024, "%u%%", device->dynamic_info.gpu_util_rate);
+    draw_percentage_meter_at(win, posX, meter_cols, "GPU",
+                             device->dynamic_info.gpu_util_rate, buff);
+  } else {
+    draw_percentage_meter_at(win, posX, meter_cols, "GPU", 0, "N/A");
+  }
+  posX += meter_cols + 1;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, total_memory) &&
+      GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, used_memory) &&
+      device->dynamic_info.total_memory > 0) {
+    unsigned mem_percentage = (unsigned)(100. * device->dynamic_info.used_memory /
+                                         device->dynamic_info.total_memory);
+    snprintf(buff, 1024, "%u%%", mem_percentage);
+    draw_percentage_meter_at(win, posX, meter_cols, "MEM", mem_percentage,
+                             buff);
+  } else {
+    draw_percentage_meter_at(win, posX, meter_cols, "MEM", 0, "N/A");
+  }
+  posX += meter_cols + 1;
+
+  if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_temp)) {
+    unsigned temp = device->dynamic_info.gpu_temp;
+    if (GPUINFO_STATIC_FIELD_VALID(&device->static_info,
+                                   temperature_slowdown_threshold) &&
+        temp >= device->static_info.temperature_slowdown_threshold)
+      wcolor_set(win, red_color, NULL);
+    if (interface->options.temperature_in_fahrenheit)
+      mvwprintw(win, 0, posX, "%3uF", (unsigned)(32 + nearbyint(temp * 1.8)));
+    else
+      mvwprintw(win, 0, posX, "%3uC", temp);
+    wstandend(win);
+  } else {
+    mvwprintw(win, 0, posX, " N/A");
+  }
+  posX += 5;
+  if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, power_draw))
+    mvwprintw(win, 0, posX, "%3uW", device->dynamic_info.power_draw / 1000);
+  else
+    mvwprintw(win, 0, posX, " N/A");
+  posX += 5;
+  if (show_energy) {
+    format_energy(buff, sizeof(buff), device->energy.consumed);
+    mvwprintw(win, 0, posX, "%8s", buff);
+    posX += 9;
+  }
+
+  // Most recent utilization sample on the right
+  unsigned data_in_ring =
+      interface_ring_buffer_data_stored(&interface->grid_history, dev_id, 0);
+  wcolor_set(win, green_color, NULL);
+  for (int j = 0; j < sparkline_cols && (unsigned)j < data_in_ring; ++j) {
+    unsigned value = interface_ring_buffer_get(&interface->grid_history, dev_id,
+                                               0, data_in_ring - j - 1);
+    if (value > 100)
+      value = 100;
+    mvwaddch(win, 0, posX + sparkline_cols - 1 - j,
+             sparkline_levels[value * (sizeof(sparkline_levels) - 2) / 100]);
+  }
+  wstandend(win);
+  wnoutrefresh(win);
+}
+
+// Only the devices having a window on screen are drawn
+static void draw_devices_grid(struct list_head *devices,
+                              struct nvtop_interface *interface) {
+  struct gpu_info *device;
+  unsigned dev_id = 0;
+
+  list_for_each_entry(device, devices, list) {
+    if (interface->devices_win[dev_id].grid_line)
+      draw_device_grid_line(device, dev_id, interface);
+    dev_id++;
+  }
+}
+
 static void draw_devices(struct list_head *devices, struct nvtop_interface *interface) {
   struct gpu_info *device;
   unsigned dev_id = 0;
 
+  if (interface->grid_view) {
+    draw_devices_grid(devices, interface);
+    return;
+  }
+
   list_for_each_entry(device, devices, list) {
     struct device_window *dev = &interface->devices_win[dev_id];
 
@@ -690,13 +998,29 @@ static void draw_devices(struct list_head *devices, struct nvtop_interface *inte
       snprintf(buff, 1024, "%u%%", rate);
       draw_percentage_meter(decode_win, "DEC", rate, buff);
     }
-    if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate)) {
-      snprintf(buff, 1024, "%u%%", device->dynamic_info.gpu_util_rate);
-      draw_percentage_meter(gpu_util_win, "GPU",
-                            device->dynamic_info.gpu_util_rate, buff);
-    } else {
-      snprintf(buff, 1024, "N/A");
-      draw_percentage_meter(gpu_util_win, "GPU", 0, buff);
+    unsigned sliced;
+    bool time_shared = device_time_shared(device, &sliced);
+    unsigned rate =
+        GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate) ? device->dynamic_info.gpu_util_rate : 0;
+    char rate_text[64];
+    if (time_shared)
+      snprintf(rate_text, sizeof(rate_text), "sliced %u%% | %u%%", sliced, rate);
+    else if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate))
+      snprintf(rate_text, sizeof(rate_text), "%u%%", rate);
+    else
+      snprintf(rate_text, sizeof(rate_text), "N/A");
+    // The idle gaps only show when the meter is wide enough, "GPU[" and "]"
+    // included
+    char gaps_text[32];
+    if (device_idle_gaps(device, gaps_text, sizeof(gaps_text)) &&
+        strlen(gaps_text) + strlen(rate_text) + 5 <= (size_t)getmaxx(gpu_util_win))
+      snprintf(buff, 1024, "%s%s", gaps_text, rate_text);
+    else
+      snprintf(buff, 1024, "%s", rate_text);
+    draw_percentage_meter(gpu_util_win, "GPU", rate, buff);
+    if (time_shared) {
+      mvwchgat(gpu_util_win, 0, 0, 3, A_BOLD, red_color, NULL);
+      wnoutrefresh(gpu_util_win);
     }
 
     if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, total_memory) &&
@@ -710,11 +1034,66 @@ static void draw_devices(struct list_head *devices, struct nvtop_interface *inte
         total_prefixed /= 1024.;
         used_prefixed /= 1024.;
       }
-      snprintf(buff, 1024, "%.3f%s/%.3f%s", used_prefixed,
+      char usage_text[64];
+      snprintf(usage_text, sizeof(usage_text), "%.3f%s/%.3f%s", used_prefixed,
                memory_prefix[prefix_off], total_prefixed,
                memory_prefix[prefix_off]);
+      // The forecast and the stranded time only show when the meter is wide
+      // enough, the label is flagged regardless
+      double time_left;
+      bool filling_up = gpuinfo_time_to_full_memory(device, &time_left) &&
+                        time_left < memory_full_display_limit;
+      char full_text[32];
+      if (filling_up) {
+        char time_left_text[8];
+        format_time_left(time_left_text, sizeof(time_left_text), time_left);
+        snprintf(full_text, sizeof(full_text), "full in %s | ", time_left_text);
+      }
+      double stranded_time;
+      bool stranded = gpuinfo_stranded_duration(&device->stranded, &stranded_time);
+      size_t meter_text_size = strlen(usage_text) + 5;
+      bool show_full = filling_up && meter_text_size + strlen(full_text) <=
+                                         (size_t)getmaxx(mem_util_win);
+      if (show_full)
+        meter_text_size += strlen(full_text);
+      // From the most to the least detailed, the first that fits is shown
+      char stranded_text[48] = "";
+      if (stranded) {
+        char stranded_time_text[8], idle_energy_text[16];
+        format_stranded_time(stranded_time_text, sizeof(stranded_time_text),
+                             stranded_time);
+        format_energy(idle_energy_text, sizeof(idle_energy_text),
+                      device->stranded.energy);
+        char candidates[3][48];
+        unsigned candidates_count = 0;
+        if (device->energy.sampling)
+          snprintf(candidates[candidates_count++], sizeof(candidates[0]),
+                   "stranded %s %s | ", stranded_time_text, idle_energy_text);
+        snprintf(candidates[candidates_count++], sizeof(candidates[0]),
+                 "stranded %s | ", stranded_time_text);
+        snprintf(candidates[candidates_count++], sizeof(candidates[0]),
+                 "strd %s | ", stranded_time_text);
+        for (unsigned i = 0; i < candidates_count; ++i) {
+          if (meter_text_size + strlen(candidates[i]) <=
+              (size_t)getmaxx(mem_util_win)) {
+            strcpy(stranded_text, candidates[i]);
+            break;
+          }
+        }
+      }
+      snprintf(buff, 1024, "%s%s%s", stranded_text, show_full ? full_text : "",
+               usage_text);
       draw_percentage_meter(mem_util_win, "MEM",
                             (unsigned int)(100. * used_mem / total_mem), buff);
+      if (stranded) {
+        mvwchgat(mem_util_win, 0, 0, 3, A_BOLD, magenta_color, NULL);
+        wnoutrefresh(mem_util_win);
+      }
+      if (filling_up &&
+          time_left < 60. * interface->options.memory_full_horizon) {
+        mvwchgat(mem_util_win, 0, 0, 3, A_BOLD, red_color, NULL);
+        wnoutrefresh(mem_util_win);
+      }
     } else {
       snprintf(buff, 1024, "N/A");
       draw_percentage_meter(mem_util_win, "MEM", 0, buff);
@@ -821,65 +1200,37 @@ static void draw_devices(struct list_head *devices, struct nvtop_interface *inte
   }
 }
 
-typedef struct {
-  unsigned processes_count;
-  struct gpuid_and_process {
-    unsigned gpu_id;
-    struct gpu_process *process;
-  } * processes;
-} all_processes;
+// Sorting goes through the table rows; qsort has no context argument, so the
+// comparators read the table being sorted from here
+static const struct gpuinfo_process_table *sorted_table;
 
-static all_processes all_processes_array(struct list_head *devices) {
-  unsigned total_processes_count = 0;
-  struct gpu_info *device;
-  unsigned dev_id = 0;
-
-  list_for_each_entry(device, devices, list) {
-    total_processes_count += device->processes_count;
-  }
-
-  all_processes merged_devices_processes;
-  merged_devices_processes.processes_count = total_processes_count;
-  if (total_processes_count) {
-    merged_devices_processes.processes = malloc(
-        total_processes_count * sizeof(*merged_devices_processes.processes));
-    if (!merged_devices_processes.processes) {
-      perror("Cannot allocate memory: ");
-      exit(EXIT_FAILURE);
-    }
-  } else {
-    merged_devices_processes.processes = NULL;
-  }
-
-  size_t offset = 0;
-  list_for_each_entry(device, devices, list) {
-    for (unsigned int j = 0; j < device->processes_count; ++j) {
-      merged_devices_processes.processes[offset].gpu_id = dev_id;
-      merged_devices_processes.processes[offset++].process =
-          &device->processes[j];
-    }
-
-    dev_id++;
-  }
-
-  return merged_devices_processes;
-}
+#define SORTED_ROWS(pp1, pp2)                                                  \
+  unsigned p1 = *(const unsigned *)(pp1);                                      \
+  unsigned p2 = *(const unsigned *)(pp2)
+#define ROW_VALID(row, field)                                                  \
+  GPUINFO_PROCESS_TABLE_FIELD_VALID(sorted_table, row, field)
 
 static int compare_pid_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  return p1->process->pid >= p2->process->pid ? -1 : 1;
+  SORTED_ROWS(pp1, pp2);
+  return sorted_table->pid[p1] >= sorted_table->pid[p2] ? -1 : 1;
 }
 
 static int compare_pid_asc(const void *pp1, const void *pp2) {
   return compare_pid_desc(pp2, pp1);
 }
 
+static int compare_interned_strings(unsigned id1, unsigned id2) {
+  if (id1 == id2)
+    return 0;
+  return strcmp(gpuinfo_process_table_string(sorted_table, id1),
+                gpuinfo_process_table_string(sorted_table, id2));
+}
+
 static int compare_username_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, user_name) && GPUINFO_PROCESS_FIELD_VALID(p2->process, user_name))
-    return -strcmp(p1->process->user_name, p2->process->user_name);
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, user_name) && ROW_VALID(p2, user_name))
+    return -compare_interned_strings(sorted_table->user_name[p1],
+                                     sorted_table->user_name[p2]);
   else
     return 0;
 }
@@ -889,10 +1240,10 @@ static int compare_username_asc(const void *pp1, const void *pp2) {
 }
 
 static int compare_process_name_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, cmdline) && GPUINFO_PROCESS_FIELD_VALID(p2->process, cmdline))
-    return -strcmp(p1->process->cmdline, p2->process->cmdline);
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, cmdline) && ROW_VALID(p2, cmdline))
+    return -compare_interned_strings(sorted_table->cmdline[p1],
+                                     sorted_table->cmdline[p2]);
   else
     return 0;
 }
@@ -902,11 +1253,12 @@ static int compare_process_name_asc(const void *pp1, const void *pp2) {
 }
 
 static int compare_mem_usage_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, gpu_memory_usage) &&
-      GPUINFO_PROCESS_FIELD_VALID(p2->process, gpu_memory_usage))
-    return p1->process->gpu_memory_usage >= p2->process->gpu_memory_usage ? -1 : 1;
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, gpu_memory_usage) && ROW_VALID(p2, gpu_memory_usage))
+    return sorted_table->gpu_memory_usage[p1] >=
+                   sorted_table->gpu_memory_usage[p2]
+               ? -1
+               : 1;
   else
     return 0;
 }
@@ -916,10 +1268,9 @@ static int compare_mem_usage_asc(const void *pp1, const void *pp2) {
 }
 
 static int compare_cpu_usage_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, cpu_usage) && GPUINFO_PROCESS_FIELD_VALID(p2->process, cpu_usage))
-    return p1->process->cpu_usage >= p2->process->cpu_usage ? -1 : 1;
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, cpu_usage) && ROW_VALID(p2, cpu_usage))
+    return sorted_table->cpu_usage[p1] >= sorted_table->cpu_usage[p2] ? -1 : 1;
   else
     return 0;
 }
@@ -929,11 +1280,11 @@ static int compare_cpu_usage_asc(const void *pp1, const void *pp2) {
 }
 
 static int compare_cpu_mem_usage_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, cpu_memory_res) &&
-      GPUINFO_PROCESS_FIELD_VALID(p2->process, cpu_memory_res))
-    return p1->process->cpu_memory_res >= p2->process->cpu_memory_res ? -1 : 1;
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, cpu_memory_res) && ROW_VALID(p2, cpu_memory_res))
+    return sorted_table->cpu_memory_res[p1] >= sorted_table->cpu_memory_res[p2]
+               ? -1
+               : 1;
   else
     return 0;
 }
@@ -943,9 +1294,8 @@ static int compare_cpu_mem_usage_asc(const void *pp1, const void *pp2) {
 }
 
 static int compare_gpu_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  return p1->gpu_id >= p2->gpu_id ? -1 : 1;
+  SORTED_ROWS(pp1, pp2);
+  return sorted_table->gpu_id[p1] >= sorted_table->gpu_id[p2] ? -1 : 1;
 }
 
 static int compare_gpu_asc(const void *pp1, const void *pp2) {
@@ -953,51 +1303,49 @@ static int compare_gpu_asc(const void *pp1, const void *pp2) {
 }
 
 static int compare_process_type_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  return (p1->process->type == gpu_process_graphical) !=
-         (p2->process->type == gpu_process_graphical);
+  SORTED_ROWS(pp1, pp2);
+  return (sorted_table->type[p1] == gpu_process_graphical) !=
+         (sorted_table->type[p2] == gpu_process_graphical);
 }
 
 static int compare_process_type_asc(const void *pp1, const void *pp2) {
   return -compare_process_name_desc(pp1, pp2);
 }
 
-static int compare_process_gpu_rate_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, gpu_usage) && GPUINFO_PROCESS_FIELD_VALID(p2->process, gpu_usage)) {
-    return p1->process->gpu_usage > p2->process->gpu_usage ? -1 : 1;
+// Rows with a valid rate come first when only one of them has it
+static int compare_rate_desc(unsigned p1, unsigned p2, bool valid1, bool valid2,
+                             const unsigned rate[], bool strict) {
+  if (valid1 && valid2) {
+    if (strict)
+      return rate[p1] > rate[p2] ? -1 : 1;
+    return rate[p1] >= rate[p2] ? -1 : 1;
   } else {
-    if (GPUINFO_PROCESS_FIELD_VALID(p1->process, gpu_usage)) {
-      return p1->process->gpu_usage > 0 ? -1 : 0;
-    } else if (GPUINFO_PROCESS_FIELD_VALID(p2->process, gpu_usage)) {
-      return p2->process->gpu_usage > 0 ? 1 : 0;
+    if (valid1) {
+      return rate[p1] > 0 ? -1 : 0;
+    } else if (valid2) {
+      return rate[p2] > 0 ? 1 : 0;
     } else {
       return 0;
     }
   }
 }
 
+static int compare_process_gpu_rate_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  return compare_rate_desc(p1, p2, ROW_VALID(p1, gpu_usage),
+                           ROW_VALID(p2, gpu_usage), sorted_table->gpu_usage,
+                           true);
+}
+
 static int compare_process_gpu_rate_asc(const void *pp1, const void *pp2) {
   return -compare_process_gpu_rate_desc(pp1, pp2);
 }
 
 static int compare_process_enc_rate_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, encode_usage) &&
-      GPUINFO_PROCESS_FIELD_VALID(p2->process, encode_usage)) {
-    return p1->process->encode_usage >= p2->process->encode_usage ? -1 : 1;
-  } else {
-    if (GPUINFO_PROCESS_FIELD_VALID(p1->process, encode_usage)) {
-      return p1->process->encode_usage > 0 ? -1 : 0;
-    } else if (GPUINFO_PROCESS_FIELD_VALID(p2->process, encode_usage)) {
-      return p2->process->encode_usage > 0 ? 1 : 0;
-    } else {
-      return 0;
-    }
-  }
+  SORTED_ROWS(pp1, pp2);
+  return compare_rate_desc(p1, p2, ROW_VALID(p1, encode_usage),
+                           ROW_VALID(p2, encode_usage),
+                           sorted_table->encode_usage, false);
 }
 
 static int compare_process_enc_rate_asc(const void *pp1, const void *pp2) {
@@ -1005,28 +1353,251 @@ static int compare_process_enc_rate_asc(const void *pp1, const void *pp2) {
 }
 
 static int compare_process_dec_rate_desc(const void *pp1, const void *pp2) {
-  const struct gpuid_and_process *p1 = (const struct gpuid_and_process *)pp1;
-  const struct gpuid_and_process *p2 = (const struct gpuid_and_process *)pp2;
-  if (GPUINFO_PROCESS_FIELD_VALID(p1->process, decode_usage) &&
-      GPUINFO_PROCESS_FIELD_VALID(p2->process, decode_usage)) {
-    return p1->process->decode_usage >= p2->process->decode_usage ? -1 : 1;
-  } else {
-    if (GPUINFO_PROCESS_FIELD_VALID(p1->process, decode_usage)) {
-      return p1->process->decode_usage > 0 ? -1 : 0;
-    } else if (GPUINFO_PROCESS_FIELD_VALID(p2->process, decode_usage)) {
-      return p2->process->decode_usage > 0 ? 1 : 0;
-    } else {
-      return 0;
-    }
-  }
+  SORTED_ROWS(pp1, pp2);
+  return compare_rate_desc(p1, p2, ROW_VALID(p1, decode_usage),
+                           ROW_VALID(p2, decode_usage),
+                           sorted_table->decode_usage, false);
 }
 static int compare_process_dec_rate_asc(const void *pp1, const void *pp2) {
   return -compare_process_dec_rate_desc(pp1, pp2);
 }
 
-static void sort_process(all_processes all_procs, enum process_field criterion,
-                         bool asc_sort) {
-  if (all_procs.processes_count == 0 || !all_procs.processes)
+static int compare_energy_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, energy_consumed) && ROW_VALID(p2, energy_consumed))
+    return sorted_table->energy_consumed[p1] >=
+                   sorted_table->energy_consumed[p2]
+               ? -1
+               : 1;
+  else
+    return 0;
+}
+
+static int compare_energy_asc(const void *pp1, const void *pp2) {
+  return compare_energy_desc(pp2, pp1);
+}
+
+// GPU utilization per watt of the power attributed to the process
+static bool table_perf_per_watt(const struct gpuinfo_process_table *table,
+                                unsigned row, double *perf_per_watt) {
+  if (!GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, gpu_usage) ||
+      !GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, power_draw) ||
+      table->power_draw[row] == 0)
+    return false;
+  *perf_per_watt = table->gpu_usage[row] * 1000. / table->power_draw[row];
+  return true;
+}
+
+static int compare_perf_per_watt_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  double ppw1, ppw2;
+  bool valid1 = table_perf_per_watt(sorted_table, p1, &ppw1);
+  bool valid2 = table_perf_per_watt(sorted_table, p2, &ppw2);
+  if (valid1 && valid2)
+    return ppw1 >= ppw2 ? -1 : 1;
+  else
+    return valid2 - valid1;
+}
+
+static int compare_perf_per_watt_asc(const void *pp1, const void *pp2) {
+  return compare_perf_per_watt_desc(pp2, pp1);
+}
+
+static int compare_top_threads_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  bool valid1 = ROW_VALID(p1, top_threads) &&
+                sorted_table->top_threads[p1].count > 0;
+  bool valid2 = ROW_VALID(p2, top_threads) &&
+                sorted_table->top_threads[p2].count > 0;
+  if (valid1 && valid2)
+    return sorted_table->top_threads[p1].threads[0].cpu_usage >=
+                   sorted_table->top_threads[p2].threads[0].cpu_usage
+               ? -1
+               : 1;
+  else
+    return valid2 - valid1;
+}
+
+static int compare_top_threads_asc(const void *pp1, const void *pp2) {
+  return compare_top_threads_desc(pp2, pp1);
+}
+
+static int compare_io_read_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, io_read_rate) && ROW_VALID(p2, io_read_rate))
+    return sorted_table->io_read_rate[p1] >= sorted_table->io_read_rate[p2]
+               ? -1
+               : 1;
+  else
+    return 0;
+}
+
+static int compare_io_read_asc(const void *pp1, const void *pp2) {
+  return compare_io_read_desc(pp2, pp1);
+}
+
+static int compare_io_write_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, io_write_rate) && ROW_VALID(p2, io_write_rate))
+    return sorted_table->io_write_rate[p1] >= sorted_table->io_write_rate[p2]
+               ? -1
+               : 1;
+  else
+    return 0;
+}
+
+static int compare_io_write_asc(const void *pp1, const void *pp2) {
+  return compare_io_write_desc(pp2, pp1);
+}
+
+static int compare_cgroup_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, cgroup) && ROW_VALID(p2, cgroup))
+    return -compare_interned_strings(sorted_table->cgroup[p1],
+                                     sorted_table->cgroup[p2]);
+  else
+    return 0;
+}
+
+static int compare_cgroup_asc(const void *pp1, const void *pp2) {
+  return compare_cgroup_desc(pp2, pp1);
+}
+
+// Highest of the CPU, memory and I/O pressures, negative if none is known
+static double row_max_pressure(const struct gpuinfo_process_table *table,
+                               unsigned row) {
+  double pressure = -1.;
+  if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, cpu_pressure))
+    pressure = max(pressure, table->cpu_pressure[row]);
+  if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, memory_pressure))
+    pressure = max(pressure, table->memory_pressure[row]);
+  if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, io_pressure))
+    pressure = max(pressure, table->io_pressure[row]);
+  return pressure;
+}
+
+static int compare_pressure_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  return row_max_pressure(sorted_table, p1) >=
+                 row_max_pressure(sorted_table, p2)
+             ? -1
+             : 1;
+}
+
+static int compare_pressure_asc(const void *pp1, const void *pp2) {
+  return compare_pressure_desc(pp2, pp1);
+}
+
+static int compare_cpu_throttled_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, cpu_throttled) && ROW_VALID(p2, cpu_throttled))
+    return sorted_table->cpu_throttled[p1] >= sorted_table->cpu_throttled[p2]
+               ? -1
+               : 1;
+  else
+    return 0;
+}
+
+static int compare_cpu_throttled_asc(const void *pp1, const void *pp2) {
+  return compare_cpu_throttled_desc(pp2, pp1);
+}
+
+static int compare_numa_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, numa_placement) && ROW_VALID(p2, numa_placement))
+    return sorted_table->numa_placement[p1] >= sorted_table->numa_placement[p2]
+               ? -1
+               : 1;
+  else
+    return 0;
+}
+
+static int compare_numa_asc(const void *pp1, const void *pp2) {
+  return compare_numa_desc(pp2, pp1);
+}
+
+static int compare_time_share_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, gpu_time_share) && ROW_VALID(p2, gpu_time_share))
+    return sorted_table->gpu_time_share[p1] >=
+                   sorted_table->gpu_time_share[p2]
+               ? -1
+               : 1;
+  else
+    return 0;
+}
+
+static int compare_time_share_asc(const void *pp1, const void *pp2) {
+  return compare_time_share_desc(pp2, pp1);
+}
+
+static int compare_idle_gaps_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, idle_gaps) && ROW_VALID(p2, idle_gaps))
+    return sorted_table->idle_gaps[p1].median >=
+                   sorted_table->idle_gaps[p2].median
+               ? -1
+               : 1;
+  else
+    return 0;
+}
+
+static int compare_idle_gaps_asc(const void *pp1, const void *pp2) {
+  return compare_idle_gaps_desc(pp2, pp1);
+}
+
+static int compare_memory_growth_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, gpu_memory_growth) && ROW_VALID(p2, gpu_memory_growth))
+    return sorted_table->gpu_memory_growth[p1] >=
+                   sorted_table->gpu_memory_growth[p2]
+               ? -1
+               : 1;
+  else
+    return 0;
+}
+
+static int compare_memory_growth_asc(const void *pp1, const void *pp2) {
+  return compare_memory_growth_desc(pp2, pp1);
+}
+
+static int compare_bottleneck_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  if (ROW_VALID(p1, bottleneck) && ROW_VALID(p2, bottleneck))
+    return sorted_table->bottleneck[p1] >= sorted_table->bottleneck[p2] ? -1
+                                                                        : 1;
+  else
+    return 0;
+}
+
+static int compare_bottleneck_asc(const void *pp1, const void *pp2) {
+  return compare_bottleneck_desc(pp2, pp1);
+}
+
+// Stranded the longest first, then by idle energy
+static int compare_stranded_desc(const void *pp1, const void *pp2) {
+  SORTED_ROWS(pp1, pp2);
+  double time1 = ROW_VALID(p1, stranded_time) ? sorted_table->stranded_time[p1] : 0.;
+  double time2 = ROW_VALID(p2, stranded_time) ? sorted_table->stranded_time[p2] : 0.;
+  if (time1 > time2)
+    return -1;
+  if (time1 < time2)
+    return 1;
+  double energy1 = ROW_VALID(p1, idle_energy) ? sorted_table->idle_energy[p1] : 0.;
+  double energy2 = ROW_VALID(p2, idle_energy) ? sorted_table->idle_energy[p2] : 0.;
+  if (energy1 > energy2)
+    return -1;
+  return energy1 < energy2;
+}
+
+static int compare_stranded_asc(const void *pp1, const void *pp2) {
+  return compare_stranded_desc(pp2, pp1);
+}
+
+static void sort_process(const struct gpuinfo_process_table *table,
+                         unsigned *sorted_rows, unsigned count,
+                         enum process_field criterion, bool asc_sort) {
+  if (count == 0)
     return;
   int (*sort_fun)(const void *, const void *);
   switch (criterion) {
@@ -1096,18 +1667,248 @@ static void sort_process(all_processes all_procs, enum process_field criterion,
     else
       sort_fun = compare_process_dec_rate_desc;
     break;
+  case process_energy:
+    if (asc_sort)
+      sort_fun = compare_energy_asc;
+    else
+      sort_fun = compare_energy_desc;
+    break;
+  case process_perf_per_watt:
+    if (asc_sort)
+      sort_fun = compare_perf_per_watt_asc;
+    else
+      sort_fun = compare_perf_per_watt_desc;
+    break;
+  case process_top_threads:
+    if (asc_sort)
+      sort_fun = compare_top_threads_asc;
+    else
+      sort_fun = compare_top_threads_desc;
+    break;
+  case process_io_read:
+    if (asc_sort)
+      sort_fun = compare_io_read_asc;
+    else
+      sort_fun = compare_io_read_desc;
+    break;
+  case process_io_write:
+    if (asc_sort)
+      sort_fun = compare_io_write_asc;
+    else
+      sort_fun = compare_io_write_desc;
+    break;
+  case process_cgroup:
+    if (asc_sort)
+      sort_fun = compare_cgroup_asc;
+    else
+      sort_fun = compare_cgroup_desc;
+    break;
+  case process_pressure:
+    if (asc_sort)
+      sort_fun = compare_pressure_asc;
+    else
+      sort_fun = compare_pressure_desc;
+    break;
+  case process_cpu_throttled:
+    if (asc_sort)
+      sort_fun = compare_cpu_throttled_asc;
+    else
+      sort_fun = compare_cpu_throttled_desc;
+    break;
+  case process_numa:
+    if (asc_sort)
+      sort_fun = compare_numa_asc;
+    else
+      sort_fun = compare_numa_desc;
+    break;
+  case process_time_share:
+    if (asc_sort)
+      sort_fun = compare_time_share_asc;
+    else
+      sort_fun = compare_time_share_desc;
+    break;
+  case process_idle_gaps:
+    if (asc_sort)
+      sort_fun = compare_idle_gaps_asc;
+    else
+      sort_fun = compare_idle_gaps_desc;
+    break;
+  case process_memory_growth:
+    if (asc_sort)
+      sort_fun = compare_memory_growth_asc;
+    else
+      sort_fun = compare_memory_growth_desc;
+    break;
+  case process_bottleneck:
+    if (asc_sort)
+      sort_fun = compare_bottleneck_asc;
+    else
+      sort_fun = compare_bottleneck_desc;
+    break;
+  case process_stranded:
+    if (asc_sort)
+      sort_fun = compare_stranded_asc;
+    else
+      sort_fun = compare_stranded_desc;
+    break;
   case process_field_count:
     return;
   }
-  qsort(all_procs.processes, all_procs.processes_count,
-        sizeof(*all_procs.processes), sort_fun);
+  sorted_table = table;
+  qsort(sorted_rows, count, sizeof(*sorted_rows), sort_fun);
+  sorted_table = NULL;
+}
+
+#undef SORTED_ROWS
+#undef ROW_VALID
+
+// Groups are compared on their totals, or on their path for the columns
+// without one
+static const struct process_groups *sorted_groups;
+static enum process_field groups_sort_criterion;
+
+static int compare_group_paths(const struct process_group *g1,
+                               const struct process_group *g2) {
+  unsigned length = min(g1->path_length, g2->path_length);
+  int cmp = strncmp(g1->path, g2->path, length);
+  if (cmp)
+    return cmp;
+  return (g1->path_length > g2->path_length) - (g1->path_length < g2->path_length);
+}
+
+static int compare_groups_desc(const void *pp1, const void *pp2) {
+  const struct process_group *g1 =
+      &sorted_groups->groups[*(const unsigned *)pp1];
+  const struct process_group *g2 =
+      &sorted_groups->groups[*(const unsigned *)pp2];
+  switch (groups_sort_criterion) {
+  case process_gpu_rate:
+    return g1->gpu_usage >= g2->gpu_usage ? -1 : 1;
+  case process_memory:
+    return g1->gpu_memory_usage >= g2->gpu_memory_usage ? -1 : 1;
+  case process_cpu_usage:
+    return g1->cpu_usage >= g2->cpu_usage ? -1 : 1;
+  case process_cpu_mem_usage:
+    return g1->cpu_memory_res >= g2->cpu_memory_res ? -1 : 1;
+  case process_energy:
+    return g1->energy_consumed >= g2->energy_consumed ? -1 : 1;
+  default:
+    return -compare_group_paths(g1, g2);
+  }
+}
+
+static int compare_groups_asc(const void *pp1, const void *pp2) {
+  return compare_groups_desc(pp2, pp1);
+}
+
+// Lists the group headers in sort order, each followed by its members when
+// expanded. The members of collapsed groups are not sorted at all.
+static unsigned order_grouped_lines(const struct gpuinfo_process_table *table,
+                                    unsigned *lines,
+                                    struct process_groups *groups,
+                                    enum process_field criterion,
+                                    bool asc_sort) {
+  for (unsigned i = 0; i < groups->count; ++i)
+    groups->order[i] = i;
+  sorted_groups = groups;
+  groups_sort_criterion = criterion;
+  qsort(groups->order, groups->count, sizeof(*groups->order),
+        asc_sort ? compare_groups_asc : compare_groups_desc);
+  sorted_groups = NULL;
+
+  unsigned count = 0;
+  for (unsigned i = 0; i < groups->count; ++i) {
+    const struct process_group *group = &groups->groups[groups->order[i]];
+    lines[count++] = table->count + groups->order[i];
+    if (group->expanded) {
+      unsigned *members = &groups->members[group->first_member];
+      sort_process(table, members, group->members_count, criterion, asc_sort);
+      memcpy(&lines[count], members, group->members_count * sizeof(*lines));
+      count += group->members_count;
+    }
+  }
+  return count;
 }
 
 static const char *columnName[process_field_count] = {
-    "PID", "USER",    "DEV", "TYPE",     "GPU",     "ENC",
-    "DEC", "GPU MEM", "CPU", "HOST MEM", "Command",
+    "PID", "USER",    "DEV", "TYPE",     "GPU",    "ENC",
+    "DEC", "GPU MEM", "CPU", "HOST MEM", "ENERGY", "GPU%/W",
+    "TOP THREADS", "IO READ", "IO WRITE", "CGROUP", "PSI C/M/I", "THROTL",
+    "NUMA", "SHARE", "IDLE GAPS", "MEM GROWTH", "BOUND", "STRANDED",
+    "Command",
+};
+
+// A single thread near a full CPU while the GPU waits points at an input
+// pipeline bottleneck (data loader, interpreter main thread)
+static const unsigned thread_saturated_usage = 90;
+static const unsigned gpu_starved_usage = 50;
+
+static bool process_cpu_bound_on_thread(const struct gpuinfo_process_table *table,
+                                        unsigned row) {
+  return GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, top_threads) &&
+         GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, gpu_usage) &&
+         table->top_threads[row].count > 0 &&
+         table->top_threads[row].threads[0].cpu_usage >=
+             thread_saturated_usage &&
+         table->gpu_usage[row] < gpu_starved_usage;
+}
+
+static bool process_cross_socket(const struct gpuinfo_process_table *table,
+                                 unsigned row) {
+  return GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, numa_placement) &&
+         table->numa_placement[row] == gpuinfo_numa_remote;
+}
+
+static bool process_straggler(const struct gpuinfo_process_table *table,
+                              unsigned row) {
+  return GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, straggler) &&
+         table->straggler[row];
+}
+
+static const char *numa_placement_names[] = {
+    [gpuinfo_numa_local] = "local",
+    [gpuinfo_numa_spread] = "spread",
+    [gpuinfo_numa_remote] = "remote",
+};
+
+static const char *bottleneck_names[gpuinfo_bottleneck_count] = {
+    [gpuinfo_bottleneck_gpu] = "GPU",
+    [gpuinfo_bottleneck_memory] = "MEMBW",
+    [gpuinfo_bottleneck_cpu] = "CPU",
+    [gpuinfo_bottleneck_io] = "I/O",
+    [gpuinfo_bottleneck_unclear] = "-",
 };
 
+static void format_top_threads(char *buffer, size_t size,
+                               const struct gpuinfo_top_threads *top) {
+  size_t written = 0;
+  buffer[0] = '\0';
+  for (unsigned i = 0; i < top->count && written < size; ++i) {
+    int ret = snprintf(buffer + written, size - written, "%s%.10s:%u%%",
+                       i ? " " : "", top->threads[i].name,
+                       top->threads[i].cpu_usage);
+    if (ret < 0)
+      break;
+    written += ret;
+  }
+}
+
+// Bytes per second to a string of at most 9 characters
+static void format_byte_rate(char *buffer, size_t size,
+                             unsigned long long bytes_per_second) {
+  static const char units[] = {'B', 'K', 'M', 'G', 'T'};
+  double rate = bytes_per_second;
+  unsigned unit = 0;
+  while (rate >= 1024. && unit + 1 < sizeof(units)) {
+    rate /= 1024.;
+    unit++;
+  }
+  if (unit == 0)
+    snprintf(buffer, size, "%.0f%c/s", rate, units[unit]);
+  else
+    snprintf(buffer, size, "%.1f%c/s", rate, units[unit]);
+}
+
 static void update_selected_offset_with_window_size(
     unsigned int *selected_row, unsigned int *offset,
     unsigned int row_available_to_draw, unsigned int num_to_draw) {
@@ -1131,15 +1932,83 @@ static void update_selected_offset_with_window_size(
 #define process_buffer_line_size 8192
 static char process_print_buffer[process_buffer_line_size];
 
+static void print_process_line(WINDOW *win, unsigned write_at, unsigned cols,
+                               unsigned offset_column) {
+  mvwprintw(win, write_at, 0, "%.*s", cols,
+            &process_print_buffer[offset_column]);
+  unsigned row, col;
+  getyx(win, row, col);
+  (void)col;
+  if (row == write_at)
+    wclrtoeol(win);
+}
+
+// Group headers show the totals of their members in the matching columns
+static void format_group_line(const struct process_group *group,
+                              process_field_displayed fields_to_display) {
+  char value[32];
+  int printed = 0;
+  for (enum process_field field = process_pid; field < process_command;
+       ++field) {
+    if (!process_is_field_displayed(field, fields_to_display))
+      continue;
+    value[0] = '\0';
+    switch (field) {
+    case process_pid:
+      snprintf(value, sizeof(value), "%s", group->expanded ? "[-]" : "[+]");
+      break;
+    case process_gpu_rate:
+      snprintf(value, sizeof(value), "%u%%", group->gpu_usage);
+      break;
+    case process_memory:
+      snprintf(value, sizeof(value), "%6uMiB",
+               (unsigned)(group->gpu_memory_usage / 1048576));
+      break;
+    case process_cpu_usage:
+      snprintf(value, sizeof(value), "%u%%", group->cpu_usage);
+      break;
+    case process_cpu_mem_usage:
+      snprintf(value, sizeof(value), "%lluMiB",
+               group->cpu_memory_res / 1048576);
+      break;
+    case process_energy:
+      format_energy(value, sizeof(value), group->energy_consumed);
+      break;
+    default:
+      break;
+    }
+    if (strlen(value) > sizeof_process_field[field])
+      value[sizeof_process_field[field]] = '\0';
+    printed += snprintf(&process_print_buffer[printed],
+                        process_buffer_line_size - printed, "%*s ",
+                        sizeof_process_field[field], value);
+  }
+  if (process_is_field_displayed(process_command, fields_to_display)) {
+    if (group->path_length)
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%.*s",
+                          (int)group->path_length, group->path);
+    else
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed,
+                          "(unknown cgroup)");
+    snprintf(&process_print_buffer[printed], process_buffer_line_size - printed,
+             " (%u processes, %.1fs GPU time)", group->members_count,
+             group->engine_used / 1e9);
+  }
+}
+
 static void
-print_processes_on_screen(all_processes all_procs,
+print_processes_on_screen(const struct gpuinfo_process_table *table,
+                          const unsigned *sorted_rows, unsigned lines_count,
+                          const struct process_groups *groups,
                           struct process_window *process,
                           enum process_field sort_criterion,
-                          process_field_displayed fields_to_display) {
+                          process_field_displayed fields_to_display,
+                          bool highlight_cross_socket) {
   WINDOW *win = process->option_window.state == nvtop_option_state_hidden
                     ? process->process_win
                     : process->process_with_option_win;
-  struct gpuid_and_process *processes = all_procs.processes;
 
   unsigned int rows, cols;
   getmaxyx(win, rows, cols);
@@ -1147,7 +2016,7 @@ print_processes_on_screen(all_processes all_procs,
 
   update_selected_offset_with_window_size(&process->selected_row,
                                           &process->offset, rows,
-                                          all_procs.processes_count);
+                                          lines_count);
   if (process->offset_column + cols >= process_buffer_line_size)
     process->offset_column = process_buffer_line_size - cols - 1;
 
@@ -1158,6 +2027,14 @@ print_processes_on_screen(all_processes all_procs,
   char memory[sizeof_process_field[process_memory] + 1];
   char cpu_percent[sizeof_process_field[process_cpu_usage] + 1];
   char cpu_mem[sizeof_process_field[process_cpu_mem_usage] + 1];
+  char energy[sizeof_process_field[process_energy] + 1];
+  char perf_per_watt[sizeof_process_field[process_perf_per_watt] + 1];
+  char top_threads[sizeof_process_field[process_top_threads] + 1];
+  char io_rate[max(sizeof_process_field[process_io_read],
+                   sizeof_process_field[process_io_write]) +
+               1];
+  char pressure[sizeof_process_field[process_pressure] + 1];
+  char throttled[sizeof_process_field[process_cpu_throttled] + 1];
 
   unsigned int start_at_process = process->offset;
   unsigned int end_at_process = start_at_process + rows;
@@ -1197,13 +2074,25 @@ print_processes_on_screen(all_processes all_procs,
   static unsigned printed_last_call = 0;
   unsigned last_line_printed = 0;
   for (unsigned int i = start_at_process;
-       i < end_at_process && i < all_procs.processes_count; ++i) {
+       i < end_at_process && i < lines_count; ++i) {
     memset(process_print_buffer, 0, sizeof(process_print_buffer));
+    unsigned entry = sorted_rows[i];
+
+    if (entry >= table->count) {
+      format_group_line(&groups->groups[entry - table->count],
+                        fields_to_display);
+      unsigned int write_at = i - start_at_process + 1;
+      print_process_line(win, write_at, cols, process->offset_column);
+      last_line_printed = write_at;
+      mvwchgat(win, write_at, 0, -1, i == special_row ? A_STANDOUT : A_BOLD,
+               cyan_color, NULL);
+      continue;
+    }
 
     printed = 0;
     if (process_is_field_displayed(process_pid, fields_to_display)) {
       size_t size = snprintf(pid_str, sizeof_process_field[process_pid] + 1,
-                             "%" PRIdMAX, (intmax_t)processes[i].process->pid);
+                             "%" PRIdMAX, (intmax_t)table->pid[entry]);
       if (size == sizeof_process_field[process_pid] + 1)
         pid_str[sizeof_process_field[process_pid]] = '\0';
       printed +=
@@ -1213,8 +2102,8 @@ print_processes_on_screen(all_processes all_procs,
 
     if (process_is_field_displayed(process_user, fields_to_display)) {
       const char *username;
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, user_name)) {
-        username = processes[i].process->user_name;
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, user_name)) {
+        username = gpuinfo_process_table_string(table, table->user_name[entry]);
       } else {
         username = "N/A";
       }
@@ -1226,7 +2115,7 @@ print_processes_on_screen(all_processes all_procs,
 
     if (process_is_field_displayed(process_gpu_id, fields_to_display)) {
       size_t size = snprintf(guid_str, sizeof_process_field[process_gpu_id] + 1,
-                             "%u", processes[i].gpu_id);
+                             "%u", table->gpu_id[entry]);
       if (size >= sizeof_process_field[process_gpu_id] + 1)
         pid_str[sizeof_process_field[process_gpu_id]] = '\0';
       printed += snprintf(&process_print_buffer[printed],
@@ -1235,7 +2124,7 @@ print_processes_on_screen(all_processes all_procs,
     }
 
     if (process_is_field_displayed(process_type, fields_to_display)) {
-      if (processes[i].process->type == gpu_process_graphical) {
+      if (table->type[entry] == gpu_process_graphical) {
         printed += snprintf(&process_print_buffer[printed],
                             process_buffer_line_size - printed, "%*s ",
                             sizeof_process_field[process_type], "Graphic");
@@ -1246,10 +2135,11 @@ print_processes_on_screen(all_processes all_procs,
       }
     }
 
+    int start_col_gpu_rate = printed;
     if (process_is_field_displayed(process_gpu_rate, fields_to_display)) {
       unsigned gpu_usage = 0;
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, gpu_usage)) {
-        gpu_usage = processes[i].process->gpu_usage;
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, gpu_usage)) {
+        gpu_usage = table->gpu_usage[entry];
       }
       printed +=
           snprintf(&process_print_buffer[printed],
@@ -1258,8 +2148,8 @@ print_processes_on_screen(all_processes all_procs,
 
     if (process_is_field_displayed(process_enc_rate, fields_to_display)) {
       unsigned encoder_rate = 0;
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, encode_usage)) {
-        encoder_rate = processes[i].process->encode_usage;
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, encode_usage)) {
+        encoder_rate = table->encode_usage[entry];
       }
       printed +=
           snprintf(&process_print_buffer[printed],
@@ -1268,8 +2158,8 @@ print_processes_on_screen(all_processes all_procs,
 
     if (process_is_field_displayed(process_dec_rate, fields_to_display)) {
       unsigned decode_rate = 0;
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, decode_usage)) {
-        decode_rate = processes[i].process->decode_usage;
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, decode_usage)) {
+        decode_rate = table->decode_usage[entry];
       }
       printed +=
           snprintf(&process_print_buffer[printed],
@@ -1277,17 +2167,17 @@ print_processes_on_screen(all_processes all_procs,
     }
 
     if (process_is_field_displayed(process_memory, fields_to_display)) {
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, gpu_memory_usage)) {
-        if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, gpu_memory_percentage)) {
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, gpu_memory_usage)) {
+        if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, gpu_memory_percentage)) {
           snprintf(
               memory, 9 + 1, "%6uMiB",
-              (unsigned)(processes[i].process->gpu_memory_usage / 1048576));
+              (unsigned)(table->gpu_memory_usage[entry] / 1048576));
           snprintf(memory + 9, sizeof_process_field[process_memory] - 9 + 1,
-                   " %3u%%", processes[i].process->gpu_memory_percentage);
+                   " %3u%%", table->gpu_memory_percentage[entry]);
         } else {
           snprintf(
               memory, sizeof_process_field[process_memory], "%6uMiB",
-              (unsigned)(processes[i].process->gpu_memory_usage / 1048576));
+              (unsigned)(table->gpu_memory_usage[entry] / 1048576));
         }
       } else {
         memory[0] = '\0';
@@ -1298,9 +2188,9 @@ print_processes_on_screen(all_processes all_procs,
     }
 
     if (process_is_field_displayed(process_cpu_usage, fields_to_display)) {
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, cpu_usage))
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, cpu_usage))
         snprintf(cpu_percent, sizeof_process_field[process_cpu_usage] + 1,
-                 "%u%%", processes[i].process->cpu_usage);
+                 "%u%%", table->cpu_usage[entry]);
       else
         snprintf(cpu_percent, sizeof_process_field[process_cpu_usage] + 1,
                  "   N/A");
@@ -1310,9 +2200,9 @@ print_processes_on_screen(all_processes all_procs,
     }
 
     if (process_is_field_displayed(process_cpu_mem_usage, fields_to_display)) {
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, cpu_memory_res))
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, cpu_memory_res))
         snprintf(cpu_mem, sizeof_process_field[process_cpu_mem_usage] + 1,
-                 "%zuMiB", processes[i].process->cpu_memory_res / 1048576);
+                 "%zuMiB", table->cpu_memory_res[entry] / 1048576);
       else
         snprintf(cpu_mem, sizeof_process_field[process_cpu_mem_usage] + 1,
                  "N/A");
@@ -1321,28 +2211,239 @@ print_processes_on_screen(all_processes all_procs,
                           sizeof_process_field[process_cpu_mem_usage], cpu_mem);
     }
 
+    if (process_is_field_displayed(process_energy, fields_to_display)) {
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, energy_consumed))
+        format_energy(energy, sizeof(energy), table->energy_consumed[entry]);
+      else
+        snprintf(energy, sizeof_process_field[process_energy] + 1, "N/A");
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%*s ",
+                          sizeof_process_field[process_energy], energy);
+    }
+
+    if (process_is_field_displayed(process_perf_per_watt, fields_to_display)) {
+      double ppw;
+      if (table_perf_per_watt(table, entry, &ppw))
+        snprintf(perf_per_watt, sizeof_process_field[process_perf_per_watt] + 1,
+                 "%.2f", ppw);
+      else
+        snprintf(perf_per_watt, sizeof_process_field[process_perf_per_watt] + 1,
+                 "N/A");
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%*s ",
+                          sizeof_process_field[process_perf_per_watt],
+                          perf_per_watt);
+    }
+
+    int start_col_top_threads = printed;
+    if (process_is_field_displayed(process_top_threads, fields_to_display)) {
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, top_threads))
+        format_top_threads(top_threads, sizeof(top_threads),
+                           &table->top_threads[entry]);
+      else
+        top_threads[0] = '\0';
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%-*s ",
+                          sizeof_process_field[process_top_threads],
+                          top_threads);
+    }
+
+    if (process_is_field_displayed(process_io_read, fields_to_display)) {
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, io_read_rate))
+        format_byte_rate(io_rate, sizeof(io_rate), table->io_read_rate[entry]);
+      else
+        snprintf(io_rate, sizeof(io_rate), "N/A");
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%*s ",
+                          sizeof_process_field[process_io_read], io_rate);
+    }
+
+    if (process_is_field_displayed(process_io_write, fields_to_display)) {
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, io_write_rate))
+        format_byte_rate(io_rate, sizeof(io_rate),
+                         table->io_write_rate[entry]);
+      else
+        snprintf(io_rate, sizeof(io_rate), "N/A");
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%*s ",
+                          sizeof_process_field[process_io_write], io_rate);
+    }
+
+    if (process_is_field_displayed(process_cgroup, fields_to_display)) {
+      const char *cgroup = "N/A";
+      int cgroup_width = sizeof_process_field[process_cgroup];
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, cgroup)) {
+        cgroup = gpuinfo_process_table_string(table, table->cgroup[entry]);
+        // The leaf of the hierarchy is the most telling part
+        size_t length = strlen(cgroup);
+        if (length > (size_t)cgroup_width)
+          cgroup += length - cgroup_width;
+      }
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%-*s ",
+                          cgroup_width, cgroup);
+    }
+
+    if (process_is_field_displayed(process_pressure, fields_to_display)) {
+      char *pos = pressure;
+      size_t left = sizeof(pressure);
+      bool pressure_valid[] = {
+          GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, cpu_pressure),
+          GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, memory_pressure),
+          GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, io_pressure)};
+      double pressure_value[] = {table->cpu_pressure[entry],
+                                 table->memory_pressure[entry],
+                                 table->io_pressure[entry]};
+      for (unsigned k = 0; k < ARRAY_SIZE(pressure_value); ++k) {
+        int ret;
+        if (pressure_valid[k])
+          ret = snprintf(pos, left, "%s%3.0f", k ? "/" : "",
+                         pressure_value[k]);
+        else
+          ret = snprintf(pos, left, "%s  -", k ? "/" : "");
+        if (ret < 0 || (size_t)ret >= left)
+          break;
+        pos += ret;
+        left -= ret;
+      }
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%*s ",
+                          sizeof_process_field[process_pressure], pressure);
+    }
+
+    if (process_is_field_displayed(process_cpu_throttled, fields_to_display)) {
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, cpu_throttled))
+        snprintf(throttled, sizeof(throttled), "%.0f%%",
+                 table->cpu_throttled[entry]);
+      else
+        snprintf(throttled, sizeof(throttled), "N/A");
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%*s ",
+                          sizeof_process_field[process_cpu_throttled],
+                          throttled);
+    }
+
+    int start_col_numa = printed;
+    if (process_is_field_displayed(process_numa, fields_to_display)) {
+      printed += snprintf(
+          &process_print_buffer[printed], process_buffer_line_size - printed,
+          "%*s ", sizeof_process_field[process_numa],
+          GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, numa_placement)
+              ? numa_placement_names[table->numa_placement[entry]]
+              : "N/A");
+    }
+
+    if (process_is_field_displayed(process_time_share, fields_to_display)) {
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, gpu_time_share))
+        printed += snprintf(&process_print_buffer[printed],
+                            process_buffer_line_size - printed, "%4u%% ",
+                            table->gpu_time_share[entry]);
+      else
+        printed += snprintf(&process_print_buffer[printed],
+                            process_buffer_line_size - printed, "%*s ",
+                            sizeof_process_field[process_time_share], "N/A");
+    }
+
+    if (process_is_field_displayed(process_idle_gaps, fields_to_display)) {
+      char gaps[16] = "N/A";
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, idle_gaps)) {
+        char median[8], p95[8];
+        format_gap_length(median, sizeof(median), table->idle_gaps[entry].median);
+        format_gap_length(p95, sizeof(p95), table->idle_gaps[entry].p95);
+        snprintf(gaps, sizeof(gaps), "%s/%s", median, p95);
+      }
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%*s ",
+                          sizeof_process_field[process_idle_gaps], gaps);
+    }
+
+    if (process_is_field_displayed(process_memory_growth, fields_to_display)) {
+      char growth[16] = "N/A";
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, gpu_memory_growth))
+        format_memory_growth(growth, sizeof(growth),
+                             table->gpu_memory_growth[entry]);
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%*s ",
+                          sizeof_process_field[process_memory_growth], growth);
+    }
+
+    if (process_is_field_displayed(process_bottleneck, fields_to_display)) {
+      printed += snprintf(
+          &process_print_buffer[printed], process_buffer_line_size - printed,
+          "%*s ", sizeof_process_field[process_bottleneck],
+          GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, bottleneck)
+              ? bottleneck_names[table->bottleneck[entry]]
+              : "N/A");
+    }
+
+    if (process_is_field_displayed(process_stranded, fields_to_display)) {
+      char stranded[24], idle_energy[16];
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, stranded_time))
+        format_stranded_time(stranded, sizeof(stranded),
+                             table->stranded_time[entry]);
+      else
+        strcpy(stranded, "-");
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, idle_energy)) {
+        format_energy(idle_energy, sizeof(idle_energy),
+                      table->idle_energy[entry]);
+        strcat(stranded, " ");
+        strcat(stranded, idle_energy);
+      }
+      printed += snprintf(&process_print_buffer[printed],
+                          process_buffer_line_size - printed, "%*s ",
+                          sizeof_process_field[process_stranded], stranded);
+    }
+
     if (process_is_field_displayed(process_command, fields_to_display)) {
-      if (GPUINFO_PROCESS_FIELD_VALID(processes[i].process, cmdline))
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, descendants) &&
+          table->descendants[entry])
+        printed += snprintf(&process_print_buffer[printed],
+                            process_buffer_line_size - printed, "[+%u] ",
+                            table->descendants[entry]);
+      if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, entry, cmdline))
         printed += snprintf(&process_print_buffer[printed],
                             process_buffer_line_size - printed, "%.*s",
                             process_buffer_line_size - printed,
-                            processes[i].process->cmdline);
+                            gpuinfo_process_table_string(table,
+                                                         table->cmdline[entry]));
     }
 
     unsigned int write_at = i - start_at_process + 1;
-    mvwprintw(win, write_at, 0, "%.*s", cols,
-              &process_print_buffer[process->offset_column]);
-    unsigned row, col;
-    getyx(win, row, col);
-    (void)col;
-    if (row == write_at)
-      wclrtoeol(win);
+    print_process_line(win, write_at, cols, process->offset_column);
     last_line_printed = write_at;
     if (i == special_row) {
       mvwchgat(win, write_at, 0, -1, A_STANDOUT, cyan_color, NULL);
     } else {
+      if (process_is_field_displayed(process_top_threads, fields_to_display) &&
+          process_cpu_bound_on_thread(table, entry))
+        set_attribute_between(
+            win, write_at, start_col_top_threads - (int)process->offset_column,
+            start_col_top_threads + sizeof_process_field[process_top_threads] -
+                (int)process->offset_column,
+            A_BOLD, red_color);
+      if (process_cross_socket(table, entry)) {
+        if (process_is_field_displayed(process_numa, fields_to_display))
+          set_attribute_between(
+              win, write_at, start_col_numa - (int)process->offset_column,
+              start_col_numa + sizeof_process_field[process_numa] -
+                  (int)process->offset_column,
+              A_BOLD, red_color);
+        if (highlight_cross_socket &&
+            process_is_field_displayed(process_pid, fields_to_display))
+          set_attribute_between(
+              win, write_at, -(int)process->offset_column,
+              sizeof_process_field[process_pid] - (int)process->offset_column,
+              A_BOLD, red_color);
+      }
+      if (process_straggler(table, entry) &&
+          process_is_field_displayed(process_gpu_rate, fields_to_display))
+        set_attribute_between(
+            win, write_at, start_col_gpu_rate - (int)process->offset_column,
+            start_col_gpu_rate + sizeof_process_field[process_gpu_rate] -
+                (int)process->offset_column,
+            A_BOLD, yellow_color);
       if (process_is_field_displayed(process_type, fields_to_display)) {
-        if (processes[i].process->type == gpu_process_graphical) {
+        if (table->type[entry] == gpu_process_graphical) {
           set_attribute_between(
               win, write_at,
               start_col_process_type - (int)process->offset_column,
@@ -1370,9 +2471,10 @@ print_processes_on_screen(all_processes all_procs,
 }
 
 static void update_process_option_win(struct nvtop_interface *interface);
+static void apply_pending_action(struct list_head *devices,
+                                 struct nvtop_interface *interface);
 
-static void draw_processes(struct list_head *devices,
-                           struct nvtop_interface *interface) {
+static void draw_processes(struct nvtop_interface *interface) {
   if (interface->process.process_win == NULL)
     return;
 
@@ -1386,34 +2488,109 @@ static void draw_processes(struct list_head *devices,
   if (interface->process.option_window.state != nvtop_option_state_hidden)
     update_process_option_win(interface);
 
-  all_processes all_procs = all_processes_array(devices);
-  sort_process(all_procs, interface->options.sort_processes_by,
-               !interface->options.sort_descending_order);
+  const struct gpuinfo_process_table *table = gpuinfo_get_process_table();
+  struct process_window *process = &interface->process;
+  bool grouped = interface->options.group_by_cgroup;
+  if (grouped)
+    process_groups_build(&process->groups, table,
+                         interface->options.cgroup_group_depth);
+  unsigned lines_capacity =
+      table->count + (grouped ? process->groups.count : 0);
+  if (lines_capacity > process->sorted_rows_capacity) {
+    unsigned *sorted_rows = reallocarray(process->sorted_rows, lines_capacity,
+                                         sizeof(*process->sorted_rows));
+    if (!sorted_rows) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    process->sorted_rows = sorted_rows;
+    process->sorted_rows_capacity = lines_capacity;
+  }
+  unsigned lines_count;
+  if (grouped) {
+    lines_count = order_grouped_lines(
+        table, process->sorted_rows, &process->groups,
+        interface->options.sort_processes_by,
+        !interface->options.sort_descending_order);
+  } else {
+    for (unsigned i = 0; i < table->count; ++i)
+      process->sorted_rows[i] = i;
+    sort_process(table, process->sorted_rows, table->count,
+                 interface->options.sort_processes_by,
+                 !interface->options.sort_descending_order);
+    lines_count = table->count;
+  }
 
-  if (all_procs.processes_count > 0) {
-    if (interface->process.selected_row >= all_procs.processes_count)
-      interface->process.selected_row = all_procs.processes_count - 1;
-    interface->process.selected_pid =
-        all_procs.processes[interface->process.selected_row].process->pid;
+  process->selected_group = -1;
+  if (lines_count > 0) {
+    if (process->selected_row >= lines_count)
+      process->selected_row = lines_count - 1;
+    unsigned selected_line = process->sorted_rows[process->selected_row];
+    if (selected_line < table->count) {
+      process->selected_pid = table->pid[selected_line];
+    } else {
+      process->selected_pid = -1;
+      process->selected_group = selected_line - table->count;
+    }
   } else {
-    interface->process.selected_row = 0;
-    interface->process.selected_pid = -1;
+    process->selected_row = 0;
+    process->selected_pid = -1;
   }
+  // Picked up at the next process refresh
+  if (process_is_field_displayed(process_top_threads,
+                                 interface->options.process_fields_displayed))
+    gpuinfo_set_thread_breakdown(process->selected_pid,
+                                 interface->options.thread_breakdown_all);
+  else
+    gpuinfo_set_thread_breakdown(-1, false);
+  gpuinfo_set_time_share_window(interface->options.time_share_window);
+  gpuinfo_set_stranded_threshold(interface->options.stranded_threshold);
+  unsigned optional_info = 0;
+  if (process_is_field_displayed(process_io_read,
+                                 interface->options.process_fields_displayed) ||
+      process_is_field_displayed(process_io_write,
+                                 interface->options.process_fields_displayed))
+    optional_info |= gpuinfo_optional_io;
+  if (process_is_field_displayed(process_cgroup,
+                                 interface->options.process_fields_displayed) ||
+      process_is_field_displayed(process_pressure,
+                                 interface->options.process_fields_displayed) ||
+      process_is_field_displayed(process_cpu_throttled,
+                                 interface->options.process_fields_displayed))
+    optional_info |= gpuinfo_optional_cgroup;
+  if (grouped)
+    optional_info |= gpuinfo_optional_cgroup;
+  if (interface->options.highlight_cross_socket ||
+      process_is_field_displayed(process_numa,
+                                 interface->options.process_fields_displayed))
+    optional_info |= gpuinfo_optional_numa;
+  if (interface->options.roll_up_descendants)
+    optional_info |= gpuinfo_optional_descendants;
+  // The I/O pressure is the one of the cgroup
+  if (process_is_field_displayed(process_bottleneck,
+                                 interface->options.process_fields_displayed))
+    optional_info |= gpuinfo_optional_bottleneck | gpuinfo_optional_cgroup;
+  // The ranks of a job are told apart from other processes by their cgroup
+  if (interface->options.detect_stragglers)
+    optional_info |= gpuinfo_optional_stragglers | gpuinfo_optional_cgroup;
+  gpuinfo_set_optional_process_info(optional_info);
 
   unsigned largest_username = 4;
-  for (unsigned i = 0; i < all_procs.processes_count; ++i) {
-    if (GPUINFO_PROCESS_FIELD_VALID(all_procs.processes[i].process, user_name)) {
-      unsigned length = strlen(all_procs.processes[i].process->user_name);
+  for (unsigned i = 0; i < table->count; ++i) {
+    if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, i, user_name)) {
+      unsigned length =
+          strlen(gpuinfo_process_table_string(table, table->user_name[i]));
       if (length > largest_username)
         largest_username = length;
     }
   }
   sizeof_process_field[process_user] = largest_username;
 
-  print_processes_on_screen(all_procs, &interface->process,
+  print_processes_on_screen(table, process->sorted_rows, lines_count,
+                            &process->groups, process,
                             interface->options.sort_processes_by,
-                            interface->options.process_fields_displayed);
-  free(all_procs.processes);
+                            interface->options.process_fields_displayed,
+                            interface->options.highlight_cross_socket);
 }
 
 static const char *signalNames[] = {
@@ -1469,6 +2646,65 @@ static void draw_kill_option(struct nvtop_interface *interface) {
   wnoutrefresh(win);
 }
 
+enum process_option_action {
+  process_option_cancel,
+  process_option_nice_up,
+  process_option_nice_down,
+  process_option_io_idle,
+  process_option_io_best_effort,
+  process_option_pin_local_cpus,
+  process_option_pin_all_cpus,
+  process_option_quota_1,
+  process_option_quota_2,
+  process_option_quota_4,
+  process_option_quota_none,
+  process_option_action_count,
+};
+
+static const char *process_action_names[process_option_action_count] = {
+    "Cancel",     "Nice +5",      "Nice -5",     "I/O idle",
+    "I/O normal", "Pin GPU CPUs", "Unpin CPUs",  "Quota 1 CPU",
+    "Quota 2 CPUs", "Quota 4 CPUs", "No quota",
+};
+
+static void draw_action_option(struct nvtop_interface *interface) {
+  WINDOW *win = interface->process.option_window.option_win;
+  if (interface->process.action_message[0]) {
+    wattr_set(win, A_REVERSE, yellow_color, NULL);
+    mvwprintw(win, 0, 0, "%-*.*s", option_window_size - 1,
+              option_window_size - 1, interface->process.action_message);
+  } else {
+    wattr_set(win, A_REVERSE, green_color, NULL);
+    mvwprintw(win, 0, 0, "%-*s", option_window_size - 1,
+              interface->process.selected_group >= 0 ? "Act on group"
+                                                     : "Act on:");
+  }
+  wstandend(win);
+  wprintw(win, " ");
+  int rows, cols;
+  getmaxyx(win, rows, cols);
+
+  size_t start_at_option = interface->process.option_window.offset;
+  size_t end_at_option = start_at_option + rows - 1;
+
+  for (size_t i = start_at_option;
+       i < end_at_option && i < process_option_action_count; ++i) {
+    if (i == interface->process.option_window.selected_row) {
+      wattr_set(win, A_STANDOUT, cyan_color, NULL);
+    }
+    wprintw(win, "%s", process_action_names[i]);
+    getyx(win, rows, cols);
+
+    for (unsigned int j = cols; j < option_window_size; ++j)
+      wprintw(win, " ");
+    if (i == interface->process.option_window.selected_row) {
+      wstandend(win);
+      mvwprintw(win, rows, option_window_size - 1, " ");
+    }
+  }
+  wnoutrefresh(win);
+}
+
 static void draw_sort_option(struct nvtop_interface *interface) {
   WINDOW *win = interface->process.option_window.option_win;
   wattr_set(win, A_REVERSE, green_color, NULL);
@@ -1533,6 +2769,9 @@ static void update_process_option_win(struct nvtop_interface *interface) {
   case nvtop_option_state_kill:
     num_options = nvtop_num_signals + 1; // Option + Cancel
     break;
+  case nvtop_option_state_actions:
+    num_options = process_option_action_count;
+    break;
   case nvtop_option_state_sort_by:
     num_options = process_field_displayed_count(
                       interface->options.process_fields_displayed) +
@@ -1551,6 +2790,9 @@ static void update_process_option_win(struct nvtop_interface *interface) {
   case nvtop_option_state_kill:
     draw_kill_option(interface);
     break;
+  case nvtop_option_state_actions:
+    draw_action_option(interface);
+    break;
   case nvtop_option_state_sort_by:
     draw_sort_option(interface);
     break;
@@ -1561,10 +2803,10 @@ static void update_process_option_win(struct nvtop_interface *interface) {
 }
 
 static const char *option_selection_hidden[] = {
-    "Setup", "Sort", "Kill", "Quit", "Save Config",
+    "Setup", "Group", "Sort", "Tune", "Act", "Kill", "Quit", "Save Config",
 };
 static const char *option_selection_hidden_num[] = {
-    "2", "6", "9", "10", "12",
+    "2", "5", "6", "7", "8", "9", "10", "12",
 };
 
 static const char *option_selection_sort[][2] = {
@@ -1579,12 +2821,26 @@ static const char *option_selection_kill[][2] = {
     {"ESC", "Cancel"},
 };
 
+static const char *option_selection_actions[][2] = {
+    {"Enter", "Apply"},
+    {"ESC", "Close"},
+};
+
+static const char *option_selection_tune[][2] = {
+    {"Enter", "Apply"},
+    {"+/-", "Value"},
+    {"Left/Right", "Device"},
+    {"ESC", "Close"},
+};
+
 static const unsigned int option_selection_width = 8;
 
 static void draw_process_shortcuts(struct nvtop_interface *interface) {
   if (interface->process.option_window.state ==
-      interface->process.option_window.previous_state)
+          interface->process.option_window.previous_state &&
+      !interface->shortcuts_stale)
     return;
+  interface->shortcuts_stale = false;
   WINDOW *win = interface->shortcut_window;
   enum nvtop_option_window_state current_state =
       interface->process.option_window.state;
@@ -1594,7 +2850,7 @@ static void draw_process_shortcuts(struct nvtop_interface *interface) {
     for (size_t i = 0; i < ARRAY_SIZE(option_selection_hidden); ++i) {
       if (process_field_displayed_count(
               interface->options.process_fields_displayed) > 0 ||
-          (i != 1 && i != 2)) {
+          (i != 1 && i != 2 && i != 4 && i != 5)) {
         wprintw(win, "F%s", option_selection_hidden_num[i]);
         wattr_set(win, A_STANDOUT, cyan_color, NULL);
         wprintw(win, "%-*s", option_selection_width,
@@ -1619,6 +2875,23 @@ static void draw_process_shortcuts(struct nvtop_interface *interface) {
       wstandend(win);
     }
     break;
+  case nvtop_option_state_actions:
+    for (size_t i = 0; i < ARRAY_SIZE(option_selection_actions); ++i) {
+      wprintw(win, "%s", option_selection_actions[i][0]);
+      wattr_set(win, A_STANDOUT, cyan_color, NULL);
+      wprintw(win, "%-*s", option_selection_width,
+              option_selection_actions[i][1]);
+      wstandend(win);
+    }
+    break;
+  case nvtop_option_state_tune:
+    for (size_t i = 0; i < ARRAY_SIZE(option_selection_tune); ++i) {
+      wprintw(win, "%s", option_selection_tune[i][0]);
+      wattr_set(win, A_STANDOUT, cyan_color, NULL);
+      wprintw(win, "%-*s", option_selection_width, option_selection_tune[i][1]);
+      wstandend(win);
+    }
+    break;
   default:
     break;
   }
@@ -1644,7 +2917,15 @@ void save_current_data_to_ring(struct list_head *devices,
   struct gpu_info *device;
   unsigned dev_id = 0;
 
+  interface->tuning_win.stale = true;
+
   list_for_each_entry(device, devices, list) {
+    unsigned utilization = 0;
+    if (GPUINFO_DYNAMIC_FIELD_VALID(&device->dynamic_info, gpu_util_rate))
+      utilization = device->dynamic_info.gpu_util_rate;
+    interface_ring_buffer_push(&interface->grid_history, dev_id, 0,
+                               utilization);
+
     unsigned data_index = 0;
     for (enum plot_information info = plot_gpu_rate;
          info < plot_information_count; ++info) {
@@ -1830,18 +3111,83 @@ static void draw_plots(struct nvtop_interface *interface) {
   }
 }
 
+// Drop the colors once everything else has been given up to stay within the
+// bandwidth budget, and bring them back as soon as there is room again
+static void update_bandwidth_color_usage(struct nvtop_interface *interface) {
+  struct interface_bandwidth *bw = &interface->bandwidth;
+  bool monochrome =
+      bandwidth_limited(bw) && bw->level >= bandwidth_monochrome;
+  if (monochrome == bw->monochrome_applied)
+    return;
+  if (interface->options.use_color && has_colors() == TRUE)
+    init_color_pairs(monochrome);
+  bw->monochrome_applied = monochrome;
+}
+
+void interface_show_message(struct nvtop_interface *interface,
+                            const char *message) {
+  snprintf(interface->message, sizeof(interface->message), "%s", message);
+}
+
+static void draw_message(struct nvtop_interface *interface) {
+  if (!interface->message[0])
+    return;
+  int rows, cols;
+  getmaxyx(interface->shortcut_window, rows, cols);
+  (void)rows;
+  wattr_set(interface->shortcut_window, A_STANDOUT, yellow_color, NULL);
+  mvwprintw(interface->shortcut_window, 0, 0, "%-*.*s", cols, cols,
+            interface->message);
+  wstandend(interface->shortcut_window);
+  wnoutrefresh(interface->shortcut_window);
+}
+
+static void draw_bandwidth_status(struct nvtop_interface *interface) {
+  if (!bandwidth_limited(&interface->bandwidth))
+    return;
+  char status[32];
+  int length;
+  if (interface->bandwidth.round_trip_ms >= 0.)
+    length = snprintf(status, sizeof(status), " %.1fKiB/s rtt %.0fms ",
+                      interface->bandwidth.throughput / 1024.,
+                      interface->bandwidth.round_trip_ms);
+  else
+    length = snprintf(status, sizeof(status), " %.1fKiB/s ",
+                      interface->bandwidth.throughput / 1024.);
+  int rows, cols;
+  getmaxyx(interface->shortcut_window, rows, cols);
+  (void)rows;
+  if (length >= (int)sizeof(status) || length > cols)
+    return;
+  wattr_set(interface->shortcut_window, A_STANDOUT, cyan_color, NULL);
+  mvwprintw(interface->shortcut_window, 0, cols - length, "%s", status);
+  wstandend(interface->shortcut_window);
+  wnoutrefresh(interface->shortcut_window);
+}
+
 void draw_gpu_info_ncurses(unsigned devices_count, struct list_head *devices,
                            struct nvtop_interface *interface) {
 
+  apply_pending_action(devices, interface);
+  if (!bandwidth_frame_begin(&interface->bandwidth))
+    return;
+  update_bandwidth_color_usage(interface);
   draw_devices(devices, interface);
   if (!interface->setup_win.visible) {
-    draw_plots(interface);
-    draw_processes(devices, interface);
+    if (bandwidth_plots_due(&interface->bandwidth))
+      draw_plots(interface);
+    if (interface->process.option_window.state == nvtop_option_state_tune)
+      draw_tuning_window(devices, interface);
+    else if (bandwidth_processes_due(&interface->bandwidth))
+      draw_processes(interface);
   } else {
     draw_setup_window(devices_count, devices, interface);
   }
   draw_shortcuts(interface);
+  draw_message(interface);
+  draw_bandwidth_status(interface);
   doupdate();
+  bandwidth_frame_end(&interface->bandwidth);
 }
 
 void update_window_size_to_terminal_size(struct nvtop_interface *inter) {
@@ -1871,6 +3217,139 @@ static void option_do_kill(struct nvtop_interface *interface) {
   }
 }
 
+static void add_action_target(struct process_window *process, pid_t pid,
+                              unsigned gpu_id) {
+  for (unsigned i = 0; i < process->action_targets_count; ++i) {
+    if (process->action_targets[i].pid == pid)
+      return;
+  }
+  if (process->action_targets_count == process->action_targets_capacity) {
+    unsigned capacity = COMMON_PROCESS_GROWN_SIZE(process->action_targets_capacity);
+    struct process_action_target *targets = reallocarray(
+        process->action_targets, capacity, sizeof(*process->action_targets));
+    if (!targets) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    process->action_targets = targets;
+    process->action_targets_capacity = capacity;
+  }
+  process->action_targets[process->action_targets_count].pid = pid;
+  process->action_targets[process->action_targets_count].gpu_id = gpu_id;
+  process->action_targets_count++;
+}
+
+// The rows are resolved now, while the table and the groups are those on
+// screen, the action itself is applied at the next draw which knows the GPUs
+static void option_queue_action(struct nvtop_interface *interface) {
+  struct process_window *process = &interface->process;
+  process->action_message[0] = '\0';
+  if (process->option_window.selected_row == process_option_cancel ||
+      process->option_window.selected_row >= process_option_action_count)
+    return;
+  const struct gpuinfo_process_table *table = gpuinfo_get_process_table();
+  process->action_targets_count = 0;
+  bool whole_group = interface->options.group_by_cgroup &&
+                     process->selected_group >= 0 &&
+                     (unsigned)process->selected_group < process->groups.count;
+  if (whole_group) {
+    const struct process_group *group =
+        &process->groups.groups[process->selected_group];
+    for (unsigned i = 0; i < group->members_count; ++i) {
+      unsigned row = process->groups.members[group->first_member + i];
+      add_action_target(process, table->pid[row], table->gpu_id[row]);
+    }
+  } else if (process->selected_pid > 0) {
+    for (unsigned row = 0; row < table->count; ++row) {
+      if (table->pid[row] == process->selected_pid) {
+        add_action_target(process, table->pid[row], table->gpu_id[row]);
+        break;
+      }
+    }
+  }
+  if (!process->action_targets_count)
+    return;
+  // A whole group is only acted on once Enter is pressed again
+  if (whole_group &&
+      process->confirm_action != process->option_window.selected_row) {
+    process->confirm_action = process->option_window.selected_row;
+    snprintf(process->action_message, sizeof(process->action_message),
+             "Confirm %u", process->action_targets_count);
+    return;
+  }
+  process->confirm_action = 0;
+  process->pending_action = process->option_window.selected_row;
+}
+
+static int apply_action_to_process(enum process_option_action action,
+                                   const struct process_action_target *target,
+                                   struct list_head *devices) {
+  switch (action) {
+  case process_option_nice_up:
+    return process_renice(target->pid, 5);
+  case process_option_nice_down:
+    return process_renice(target->pid, -5);
+  case process_option_io_idle:
+    return process_set_io_class(target->pid, process_io_idle);
+  case process_option_io_best_effort:
+    return process_set_io_class(target->pid, process_io_best_effort);
+  case process_option_pin_local_cpus: {
+    unsigned index = 0;
+    struct gpu_info *device;
+    list_for_each_entry(device, devices, list) {
+      if (index++ == target->gpu_id) {
+        if (!GPUINFO_STATIC_FIELD_VALID(&device->static_info, local_cpus))
+          break;
+        return process_set_affinity(target->pid,
+                                    &device->static_info.local_cpus);
+      }
+    }
+    return ENODATA;
+  }
+  case process_option_pin_all_cpus:
+    return process_set_affinity(target->pid, NULL);
+  case process_option_quota_1:
+    return cgroupinfo_set_cpu_quota(target->pid, 1);
+  case process_option_quota_2:
+    return cgroupinfo_set_cpu_quota(target->pid, 2);
+  case process_option_quota_4:
+    return cgroupinfo_set_cpu_quota(target->pid, 4);
+  case process_option_quota_none:
+    return cgroupinfo_set_cpu_quota(target->pid, 0);
+  default:
+    return EINVAL;
+  }
+}
+
+static void apply_pending_action(struct list_head *devices,
+                                 struct nvtop_interface *interface) {
+  struct process_window *process = &interface->process;
+  if (!process->pending_action)
+    return;
+  unsigned failed = 0;
+  int error = 0;
+  for (unsigned i = 0; i < process->action_targets_count; ++i) {
+    int retval = apply_action_to_process(process->pending_action,
+                                         &process->action_targets[i], devices);
+    if (retval) {
+      failed++;
+      if (!error)
+        error = retval;
+    }
+  }
+  unsigned count = process->action_targets_count;
+  if (!failed)
+    snprintf(process->action_message, sizeof(process->action_message),
+             "Done (%u)", count);
+  else if (error == EPERM || error == EACCES)
+    snprintf(process->action_message, sizeof(process->action_message),
+             "Denied %u/%u", failed, count);
+  else
+    snprintf(process->action_message, sizeof(process->action_message),
+             "Failed %u/%u", failed, count);
+  process->pending_action = 0;
+}
+
 static void option_change_sort(struct nvtop_interface *interface) {
   if (interface->process.option_window.selected_row == 0)
     return;
@@ -1888,10 +3367,20 @@ static void option_change_sort(struct nvtop_interface *interface) {
 }
 
 void interface_key(int keyId, struct nvtop_interface *interface) {
+  // Keep the selection responsive even when the process list is throttled
+  interface->bandwidth.redraw_processes = true;
+  if (interface->message[0]) {
+    interface->message[0] = '\0';
+    interface->shortcuts_stale = true;
+  }
   if (interface->setup_win.visible) {
     handle_setup_win_keypress(keyId, interface);
     return;
   }
+  if (interface->process.option_window.state == nvtop_option_state_tune) {
+    handle_tuning_win_keypress(keyId, interface);
+    return;
+  }
   switch (keyId) {
   case KEY_F(2):
     if (interface->process.option_window.state == nvtop_option_state_hidden &&
@@ -1903,6 +3392,21 @@ void interface_key(int keyId, struct nvtop_interface *interface) {
     save_interface_options_to_config_file(interface->devices_count,
                                           &interface->options);
     break;
+  case KEY_F(7):
+    if (interface->devices_count > 0 &&
+        interface->process.option_window.state == nvtop_option_state_hidden)
+      show_tuning_window(interface);
+    break;
+  case KEY_F(8):
+    if (process_field_displayed_count(
+            interface->options.process_fields_displayed) > 0 &&
+        interface->process.option_window.state == nvtop_option_state_hidden) {
+      interface->process.option_window.state = nvtop_option_state_actions;
+      interface->process.option_window.selected_row = 0;
+      interface->process.action_message[0] = '\0';
+      interface->process.confirm_action = 0;
+    }
+    break;
   case KEY_F(9):
     if (process_field_displayed_count(
             interface->options.process_fields_displayed) > 0 &&
@@ -1919,6 +3423,12 @@ void interface_key(int keyId, struct nvtop_interface *interface) {
       interface->process.option_window.selected_row = 0;
     }
     break;
+  case KEY_F(5):
+    if (process_field_displayed_count(
+            interface->options.process_fields_displayed) > 0 &&
+        interface->process.option_window.state == nvtop_option_state_hidden)
+      interface->options.group_by_cgroup = !interface->options.group_by_cgroup;
+    break;
   case KEY_RIGHT:
     if (interface->process.option_window.state == nvtop_option_state_hidden)
       interface->process.offset_column += 4;
@@ -1932,8 +3442,10 @@ void interface_key(int keyId, struct nvtop_interface *interface) {
     switch (interface->process.option_window.state) {
     case nvtop_option_state_kill:
     case nvtop_option_state_sort_by:
+    case nvtop_option_state_actions:
       if (interface->process.option_window.selected_row != 0)
         interface->process.option_window.selected_row--;
+      interface->process.confirm_action = 0;
       break;
     case nvtop_option_state_hidden:
       if (interface->process.selected_row != 0)
@@ -1947,7 +3459,9 @@ void interface_key(int keyId, struct nvtop_interface *interface) {
     switch (interface->process.option_window.state) {
     case nvtop_option_state_kill:
     case nvtop_option_state_sort_by:
+    case nvtop_option_state_actions:
       interface->process.option_window.selected_row++;
+      interface->process.confirm_action = 0;
       break;
     case nvtop_option_state_hidden:
       interface->process.selected_row++;
@@ -1973,7 +3487,19 @@ void interface_key(int keyId, struct nvtop_interface *interface) {
       option_change_sort(interface);
       interface->process.option_window.state = nvtop_option_state_hidden;
       break;
+    case nvtop_option_state_actions:
+      // Stays open to repeat the action or try another
+      if (interface->process.option_window.selected_row == process_option_cancel)
+        interface->process.option_window.state = nvtop_option_state_hidden;
+      else
+        option_queue_action(interface);
+      break;
     case nvtop_option_state_hidden:
+      if (interface->options.group_by_cgroup &&
+          interface->process.selected_group >= 0)
+        process_groups_toggle_expanded(&interface->process.groups,
+                                       interface->process.selected_group);
+      break;
     default:
       break;
     }
@@ -1987,7 +3513,8 @@ void interface_key(int keyId, struct nvtop_interface *interface) {
 }
 
 bool interface_freeze_processes(struct nvtop_interface *interface) {
-  return interface->process.option_window.state == nvtop_option_state_kill;
+  return interface->process.option_window.state == nvtop_option_state_kill ||
+         interface->process.option_window.state == nvtop_option_state_actions;
 }
 
 extern inline void set_attribute_between(WINDOW *win, int startY, int startX,
@@ -0,0 +1,260 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/interface_bandwidth.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <ncurses.h>
+#include <poll.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// Plots (resp. the process list) are only redrawn one frame out of
+// degraded_redraw_stride once the budget is exceeded
+static const unsigned degraded_redraw_stride = 4;
+// Number of frames under budget before stepping back one degradation level
+static const unsigned frames_before_recovery = 5;
+
+// The kernel accounts for every byte handed to write(2) by the thread. The
+// counter is only sampled around the drawing of a frame, during which the
+// interface thread writes nothing but terminal output: the files written by
+// the flight recorder, the tuning log or the configuration are not charged.
+static bool bandwidth_bytes_written(struct interface_bandwidth *bw,
+                                    uint64_t *written) {
+  char io_counters[512];
+  ssize_t length = pread(bw->self_io, io_counters, sizeof(io_counters) - 1, 0);
+  if (length <= 0)
+    return false;
+  io_counters[length] = '\0';
+  return sscanf(io_counters, "rchar: %*s wchar: %" SCNu64, written) == 1;
+}
+
+void bandwidth_init(struct interface_bandwidth *bw, unsigned budget_kib) {
+  bw->self_io = -1;
+  bw->throughput = 0.;
+  bw->round_trip_ms = -1.;
+  bw->monochrome_applied = false;
+  bandwidth_set_budget(bw, budget_kib);
+}
+
+void bandwidth_set_budget(struct interface_bandwidth *bw, unsigned budget_kib) {
+  bw->budget = (uint64_t)budget_kib * 1024;
+  bw->credit = bw->budget;
+  bw->throughput_window_bytes = 0;
+  bw->level = bandwidth_full_rendering;
+  bw->frames_under_budget = 0;
+  bw->frame_count = 0;
+  bw->redraw_plots = true;
+  bw->redraw_processes = true;
+  nvtop_get_current_time(&bw->last_frame);
+  bw->throughput_window = bw->last_frame;
+  if (!bw->budget) {
+    bandwidth_free(bw);
+    return;
+  }
+  if (bw->self_io < 0)
+    bw->self_io = open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+  uint64_t bytes_written;
+  if (bw->self_io >= 0 && !bandwidth_bytes_written(bw, &bytes_written))
+    bandwidth_free(bw);
+}
+
+void bandwidth_free(struct interface_bandwidth *bw) {
+  if (bw->self_io >= 0)
+    close(bw->self_io);
+  bw->self_io = -1;
+}
+
+// Hands the bytes read ahead of the answer back to ncurses, in their order of
+// arrival since ungetch stacks them
+static void return_input(const char *bytes, size_t count) {
+  while (count)
+    ungetch((unsigned char)bytes[--count]);
+}
+
+// Time a Device Status Report (cursor position) request. Only a complete
+// ESC [ rows ; columns R reply is consumed: the keystrokes typed meanwhile,
+// escape sequences included, are returned to ncurses.
+double bandwidth_measure_round_trip(struct interface_bandwidth *bw,
+                                    int input_fd, int output_fd,
+                                    int timeout_ms) {
+  static const char cursor_position_query[] = "\033[6n";
+  nvtop_time start, now;
+  nvtop_get_current_time(&start);
+  ssize_t written =
+      write(output_fd, cursor_position_query, sizeof(cursor_position_query) - 1);
+  if (written != sizeof(cursor_position_query) - 1)
+    return bw->round_trip_ms;
+
+  // Bytes read so far, the candidate reply being the last reply_length ones.
+  // Sized under the ncurses input queue.
+  char input[128];
+  size_t input_length = 0, reply_length = 0;
+  enum {
+    expect_escape,
+    expect_bracket,
+    expect_row,
+    in_row,
+    expect_column,
+    in_column,
+  } state = expect_escape;
+  while (true) {
+    nvtop_get_current_time(&now);
+    int remaining = timeout_ms - (int)(nvtop_difftime(start, now) * 1000.);
+    if (remaining <= 0 || input_length == sizeof(input))
+      break;
+    struct pollfd poll_input = {.fd = input_fd, .events = POLLIN};
+    int ready = poll(&poll_input, 1, remaining);
+    if (ready < 0 && errno == EINTR)
+      continue;
+    if (ready <= 0)
+      break;
+    char byte;
+    if (read(input_fd, &byte, 1) != 1)
+      break;
+    input[input_length++] = byte;
+    reply_length++;
+    bool digit = byte >= '0' && byte <= '9';
+    switch (state) {
+    case expect_escape:
+      break;
+    case expect_bracket:
+      state = byte == '[' ? expect_row : expect_escape;
+      break;
+    case expect_row:
+    case in_row:
+      if (digit)
+        state = in_row;
+      else if (state == in_row && byte == ';')
+        state = expect_column;
+      else
+        state = expect_escape;
+      break;
+    case expect_column:
+      state = digit ? in_column : expect_escape;
+      break;
+    case in_column:
+      if (byte == 'R') {
+        nvtop_get_current_time(&now);
+        bw->round_trip_ms = nvtop_difftime(start, now) * 1000.;
+        return_input(input, input_length - reply_length);
+        return bw->round_trip_ms;
+      }
+      state = digit ? in_column : expect_escape;
+      break;
+    }
+    // Not a reply, or a new one starting on this escape
+    if (state == expect_escape) {
+      if (byte == '\033') {
+        state = expect_bracket;
+        reply_length = 1;
+      } else {
+        reply_length = 0;
+      }
+    }
+  }
+  return_input(input, input_length);
+  return bw->round_trip_ms;
+}
+
+// Refill the token bucket and decide whether this frame is drawn at all.
+// Frames are dropped while more than one second worth of output is owed,
+// which lowers the redraw rate without delaying the data collection.
+bool bandwidth_frame_begin(struct interface_bandwidth *bw) {
+  if (!bandwidth_limited(bw))
+    return true;
+  nvtop_time now;
+  nvtop_get_current_time(&now);
+  bw->credit += nvtop_difftime(bw->last_frame, now) * bw->budget;
+  if (bw->credit > bw->budget)
+    bw->credit = bw->budget;
+  bw->last_frame = now;
+  if (bw->credit < -(double)bw->budget && !bw->redraw_processes &&
+      !bw->redraw_plots)
+    return false;
+  bw->frame_count++;
+  if (!bandwidth_bytes_written(bw, &bw->frame_start_bytes))
+    bw->frame_start_bytes = UINT64_MAX;
+  return true;
+}
+
+bool bandwidth_plots_due(const struct interface_bandwidth *bw) {
+  if (!bandwidth_limited(bw) || bw->redraw_plots)
+    return true;
+  switch (bw->level) {
+  case bandwidth_full_rendering:
+    return true;
+  case bandwidth_sparse_plots:
+    return bw->frame_count % degraded_redraw_stride == 0;
+  default:
+    return false;
+  }
+}
+
+bool bandwidth_processes_due(const struct interface_bandwidth *bw) {
+  if (!bandwidth_limited(bw) || bw->redraw_processes)
+    return true;
+  if (bw->level < bandwidth_frozen_plots)
+    return true;
+  return bw->frame_count % degraded_redraw_stride == 0;
+}
+
+// Charge the bytes sent while drawing the frame and move one degradation step
+// up when in debt, or one step down after a few frames with spare credit.
+void bandwidth_frame_end(struct interface_bandwidth *bw) {
+  if (!bandwidth_limited(bw))
+    return;
+  bw->redraw_plots = false;
+  bw->redraw_processes = false;
+  uint64_t bytes_written;
+  if (bw->frame_start_bytes == UINT64_MAX ||
+      !bandwidth_bytes_written(bw, &bytes_written))
+    return;
+  uint64_t frame_bytes = bytes_written - bw->frame_start_bytes;
+  bw->credit -= frame_bytes;
+
+  bw->throughput_window_bytes += frame_bytes;
+  double window_length = nvtop_difftime(bw->throughput_window, bw->last_frame);
+  if (window_length >= 1.) {
+    bw->throughput = bw->throughput_window_bytes / window_length;
+    bw->throughput_window_bytes = 0;
+    bw->throughput_window = bw->last_frame;
+  }
+
+  if (bw->credit < 0.) {
+    bw->frames_under_budget = 0;
+    if (bw->level + 1 < bandwidth_degradation_count)
+      bw->level++;
+  } else if (bw->credit > bw->budget / 2.) {
+    bw->frames_under_budget++;
+    if (bw->frames_under_budget >= frames_before_recovery &&
+        bw->level > bandwidth_full_rendering) {
+      bw->level--;
+      bw->frames_under_budget = 0;
+      bw->redraw_plots = true;
+      bw->redraw_processes = true;
+    }
+  }
+}
+
+extern inline bool bandwidth_limited(const struct interface_bandwidth *bw);
@@ -50,27 +50,6 @@ static bool who_to_merge(unsigned max_merge_size, unsigned plot_count, unsigned
   return smallest_merge != UINT_MAX;
 }
 
-static bool move_plot_to_stack(unsigned stack_max_cols, unsigned plot_id,
-                               unsigned destination_stack, unsigned plot_count,
-                               unsigned stack_count,
-                               const unsigned num_info_per_plot[plot_count],
-                               unsigned cols_allocated_in_stacks[stack_count],
-                               unsigned plot_in_stack[plot_count]) {
-  if (plot_in_stack[plot_id] == destination_stack)
-    return false;
-  unsigned cols_used_by_plot_id = min_plot_cols(num_info_per_plot[plot_id]);
-  unsigned cols_after_merge =
-      cols_allocated_in_stacks[destination_stack] + cols_used_by_plot_id;
-  if (cols_after_merge > stack_max_cols) {
-    return false;
-  } else {
-    cols_allocated_in_stacks[plot_in_stack[plot_id]] -= cols_used_by_plot_id;
-    cols_allocated_in_stacks[destination_stack] += cols_used_by_plot_id;
-    plot_in_stack[plot_id] = destination_stack;
-    return true;
-  }
-}
-
 static unsigned info_in_plot(unsigned plot_id, unsigned devices_count,
                              const unsigned map_device_to_plot[devices_count],
                              const plot_info_to_draw to_draw[devices_count]) {
@@ -83,41 +62,34 @@ static unsigned info_in_plot(unsigned plot_id, unsigned devices_count,
   return sum;
 }
 
-static unsigned cols_used_by_stack(unsigned stack_id, unsigned plot_count,
-                                   const unsigned num_info_per_plot[plot_count],
-                                   const unsigned plot_in_stack[plot_count]) {
-  unsigned sum = 0;
-  for (unsigned plot_id = 0; plot_id < plot_count; ++plot_id) {
-    if (plot_in_stack[plot_id] == stack_id)
-      sum += min_plot_cols(num_info_per_plot[plot_id]);
-  }
-  return sum;
-}
-
-static unsigned
-size_differences_between_stacks(unsigned plot_count, unsigned stack_count,
-                                unsigned cols_allocated_in_stacks[plot_count]) {
-  unsigned sum = 0;
-  for (unsigned i = 0; i < stack_count; ++i) {
-    for (unsigned j = i + 1; j < stack_count; ++j) {
-      if (cols_allocated_in_stacks[i] > cols_allocated_in_stacks[j]) {
-        sum += cols_allocated_in_stacks[i] - cols_allocated_in_stacks[j];
-      } else {
-        sum += cols_allocated_in_stacks[j] - cols_allocated_in_stacks[i];
-      }
-    }
+// Merge two charts, returns false if no merge is possible
+static bool merge_one_more_plot(unsigned devices_count, unsigned num_info_per_plot[devices_count],
+                                unsigned map_device_to_plot[devices_count]) {
+  unsigned to_merge[2];
+  if (!who_to_merge(MAX_LINES_PER_PLOT, devices_count, num_info_per_plot, to_merge))
+    return false;
+  num_info_per_plot[to_merge[0]] += num_info_per_plot[to_merge[1]];
+  num_info_per_plot[to_merge[1]] = 0;
+  unsigned oldLocation = map_device_to_plot[to_merge[1]];
+  for (unsigned devId = 0; devId < devices_count; ++devId) {
+    if (map_device_to_plot[devId] == oldLocation)
+      map_device_to_plot[devId] = map_device_to_plot[to_merge[0]];
   }
-  return sum;
+  return true;
 }
 
 static void preliminary_plot_positioning(unsigned rows_for_plots, unsigned plot_total_cols, unsigned devices_count,
                                          const plot_info_to_draw to_draw[devices_count],
                                          unsigned map_device_to_plot[devices_count],
-                                         unsigned plot_in_stack[devices_count], unsigned *num_plots,
+                                         unsigned plot_in_stack[MAX_CHARTS], unsigned *num_plots,
                                          unsigned *plot_stack_count) {
 
   // Used to handle the merging process
-  unsigned num_info_per_plot[MAX_CHARTS];
+  unsigned *num_info_per_plot = malloc(max(1, devices_count) * sizeof(*num_info_per_plot));
+  if (!num_info_per_plot) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
 
   bool plot_anything = false;
   for (unsigned i = 0; i < devices_count; ++i) {
@@ -144,6 +116,15 @@ static void preliminary_plot_positioning(unsigned rows_for_plots, unsigned plot_
       if (num_info_for_this_plot == 0)
         continue;
 
+      // More charts than windows available: retry and merge one more
+      if (plot_id == MAX_CHARTS) {
+        if (merge_one_more_plot(devices_count, num_info_per_plot, map_device_to_plot))
+          search_a_window_configuration = true;
+        else
+          num_plot_stacks = 0;
+        break;
+      }
+
       unsigned cols_this_plot = min_plot_cols(num_info_for_this_plot);
       // If there is enough horizontal space left, allocate side by side
       if (plot_total_cols >= cols_this_plot + cols_used_in_stack) {
@@ -163,15 +144,7 @@ static void preliminary_plot_positioning(unsigned rows_for_plots, unsigned plot_
           cols_used_in_stack = 0;
           i--;
         } else { // Not enough space for a stack: retry and merge one more
-          unsigned to_merge[2];
-          if (who_to_merge(MAX_LINES_PER_PLOT, devices_count, num_info_per_plot, to_merge)) {
-            num_info_per_plot[to_merge[0]] += num_info_per_plot[to_merge[1]];
-            num_info_per_plot[to_merge[1]] = 0;
-            unsigned oldLocation = map_device_to_plot[to_merge[1]];
-            for (unsigned devId = 0; devId < devices_count; ++devId) {
-              if (map_device_to_plot[devId] == oldLocation)
-                map_device_to_plot[devId] = map_device_to_plot[to_merge[0]];
-            }
+          if (merge_one_more_plot(devices_count, num_info_per_plot, map_device_to_plot)) {
             search_a_window_configuration = true;
           } else { // No merge left
             num_plot_stacks = 0;
@@ -207,48 +180,65 @@ static void preliminary_plot_positioning(unsigned rows_for_plots, unsigned plot_
       }
     }
   }
+  free(num_info_per_plot);
 }
 
-static void balance_info_on_stacks_preserving_plot_order(
-    unsigned stack_max_cols, unsigned stack_count, unsigned plot_count,
-    unsigned num_info_per_plot[plot_count],
-    unsigned cols_allocated_in_stacks[stack_count],
-    unsigned plot_in_stack[plot_count]) {
+// Split the plots, in order, into stack_count non-empty stacks such that the
+// widest stack is as narrow as possible (linear partition dynamic program).
+// The current assignment is kept if no split fits in stack_max_cols.
+static void balance_info_on_stacks_preserving_plot_order(unsigned stack_max_cols, unsigned stack_count,
+                                                         unsigned plot_count,
+                                                         const unsigned num_info_per_plot[plot_count],
+                                                         unsigned plot_in_stack[plot_count]) {
   if (stack_count > plot_count) {
     stack_count = plot_count;
   }
-  unsigned moving_plot_id = plot_count - 1;
-  while (moving_plot_id < plot_count) {
-    unsigned to_stack = plot_in_stack[moving_plot_id] + 1;
-    if (to_stack < stack_count) {
-      unsigned diff_sum_before = size_differences_between_stacks(
-          plot_count, stack_count, cols_allocated_in_stacks);
-      unsigned stack_before = plot_in_stack[moving_plot_id];
-      if (move_plot_to_stack(stack_max_cols, moving_plot_id, to_stack,
-                             plot_count, stack_count, num_info_per_plot,
-                             cols_allocated_in_stacks, plot_in_stack)) {
-        unsigned diff_sum_after = size_differences_between_stacks(
-            plot_count, stack_count, cols_allocated_in_stacks);
-        if (diff_sum_after <= diff_sum_before) {
-          moving_plot_id = plot_count;
-        } else {
-          // Move back
-          move_plot_to_stack(stack_max_cols, moving_plot_id, stack_before,
-                             plot_count, stack_count, num_info_per_plot,
-                             cols_allocated_in_stacks, plot_in_stack);
+  if (stack_count < 2)
+    return;
+  unsigned prefix_cols[plot_count + 1];
+  prefix_cols[0] = 0;
+  for (unsigned i = 0; i < plot_count; ++i)
+    prefix_cols[i + 1] = prefix_cols[i] + min_plot_cols(num_info_per_plot[i]);
+
+  // widest[k][i]: narrowest widest stack when the first i plots use k + 1
+  // stacks; split[k][i]: first plot of the last of these stacks
+  unsigned widest[stack_count][plot_count + 1];
+  unsigned split[stack_count][plot_count + 1];
+  for (unsigned i = 1; i <= plot_count; ++i) {
+    widest[0][i] = prefix_cols[i];
+    split[0][i] = 0;
+  }
+  for (unsigned k = 1; k < stack_count; ++k) {
+    for (unsigned i = k + 1; i <= plot_count; ++i) {
+      widest[k][i] = UINT_MAX;
+      // Ties go to the latest split to fill the top stacks first
+      for (unsigned j = k; j < i; ++j) {
+        unsigned candidate = max(widest[k - 1][j], prefix_cols[i] - prefix_cols[j]);
+        if (candidate <= widest[k][i]) {
+          widest[k][i] = candidate;
+          split[k][i] = j;
         }
       }
     }
-    moving_plot_id--;
+  }
+  if (widest[stack_count - 1][plot_count] > stack_max_cols)
+    return;
+
+  unsigned end = plot_count;
+  for (unsigned k = stack_count - 1; k < stack_count; --k) {
+    unsigned start = k ? split[k][end] : 0;
+    for (unsigned plot_id = start; plot_id < end; ++plot_id)
+      plot_in_stack[plot_id] = k;
+    end = start;
   }
 }
 
-void compute_sizes_from_layout(unsigned devices_count, unsigned device_header_rows, unsigned device_header_cols,
-                               unsigned rows, unsigned cols, const plot_info_to_draw *to_draw,
-                               process_field_displayed process_displayed, struct window_position *device_positions,
-                               unsigned *num_plots, struct window_position plot_positions[MAX_CHARTS],
-                               unsigned *map_device_to_plot, struct window_position *process_position,
-                               struct window_position *setup_position) {
+static void solve_layout(unsigned devices_count, unsigned device_header_rows, unsigned device_header_cols,
+                         unsigned rows, unsigned cols, const plot_info_to_draw *to_draw,
+                         process_field_displayed process_displayed, struct window_position *device_positions,
+                         unsigned *num_plots, struct window_position plot_positions[MAX_CHARTS],
+                         unsigned *map_device_to_plot, struct window_position *process_position,
+                         struct window_position *setup_position) {
 
   unsigned min_rows_for_header = 0, header_stacks = 0, num_device_per_row = 0;
   num_device_per_row = max(1, cols / device_header_cols);
@@ -307,16 +297,9 @@ void compute_sizes_from_layout(unsigned devices_count, unsigned device_header_ro
     num_info_per_plot[i] =
         info_in_plot(i, devices_count, map_device_to_plot, to_draw);
   }
-  unsigned cols_allocated_in_stacks[MAX_CHARTS];
-  for (unsigned i = 0; i < num_plot_stacks; ++i) {
-    cols_allocated_in_stacks[i] =
-        cols_used_by_stack(i, *num_plots, num_info_per_plot, plot_in_stack);
-  }
 
   // Keep the plot order of apparition, but spread the plot on different stacks
-  balance_info_on_stacks_preserving_plot_order(
-      cols, num_plot_stacks, *num_plots, num_info_per_plot,
-      cols_allocated_in_stacks, plot_in_stack);
+  balance_info_on_stacks_preserving_plot_order(cols, num_plot_stacks, *num_plots, num_info_per_plot, plot_in_stack);
 
   // Device Information Header
   unsigned cols_header_left = cols - num_device_per_row * device_header_cols;
@@ -402,3 +385,103 @@ void compute_sizes_from_layout(unsigned devices_count, unsigned device_header_ro
   setup_position->sizeY = rows - rows_for_header;
   setup_position->sizeX = cols;
 }
+
+// The layout is computed again on every resize and option change, and the same
+// configurations tend to come back (e.g., toggling an option back and forth).
+#define LAYOUT_CACHE_SIZE 16
+
+struct layout_cache_entry {
+  bool valid;
+  unsigned long long last_use;
+  // Key
+  unsigned devices_count, device_header_rows, device_header_cols, rows, cols;
+  process_field_displayed process_displayed;
+  plot_info_to_draw *to_draw;
+  // Solution
+  struct window_position *device_positions;
+  unsigned *map_device_to_plot;
+  unsigned num_plots;
+  struct window_position plot_positions[MAX_CHARTS];
+  struct window_position process_position, setup_position;
+};
+
+static struct layout_cache_entry layout_cache[LAYOUT_CACHE_SIZE];
+static unsigned long long layout_cache_clock;
+
+static bool layout_cache_entry_matches(const struct layout_cache_entry *entry, unsigned devices_count,
+                                       unsigned device_header_rows, unsigned device_header_cols, unsigned rows,
+                                       unsigned cols, const plot_info_to_draw *to_draw,
+                                       process_field_displayed process_displayed) {
+  return entry->valid && entry->devices_count == devices_count && entry->device_header_rows == device_header_rows &&
+         entry->device_header_cols == device_header_cols && entry->rows == rows && entry->cols == cols &&
+         entry->process_displayed == process_displayed &&
+         !memcmp(entry->to_draw, to_draw, devices_count * sizeof(*to_draw));
+}
+
+static void layout_cache_entry_free(struct layout_cache_entry *entry) {
+  free(entry->to_draw);
+  free(entry->device_positions);
+  free(entry->map_device_to_plot);
+  entry->to_draw = NULL;
+  entry->device_positions = NULL;
+  entry->map_device_to_plot = NULL;
+  entry->valid = false;
+}
+
+void layout_selection_clear_cache(void) {
+  for (unsigned i = 0; i < LAYOUT_CACHE_SIZE; ++i)
+    layout_cache_entry_free(&layout_cache[i]);
+}
+
+void compute_sizes_from_layout(unsigned devices_count, unsigned device_header_rows, unsigned device_header_cols,
+                               unsigned rows, unsigned cols, const plot_info_to_draw *to_draw,
+                               process_field_displayed process_displayed, struct window_position *device_positions,
+                               unsigned *num_plots, struct window_position plot_positions[MAX_CHARTS],
+                               unsigned *map_device_to_plot, struct window_position *process_position,
+                               struct window_position *setup_position) {
+  struct layout_cache_entry *entry = &layout_cache[0];
+  for (unsigned i = 0; i < LAYOUT_CACHE_SIZE; ++i) {
+    if (layout_cache_entry_matches(&layout_cache[i], devices_count, device_header_rows, device_header_cols, rows,
+                                   cols, to_draw, process_displayed)) {
+      entry = &layout_cache[i];
+      entry->last_use = ++layout_cache_clock;
+      memcpy(device_positions, entry->device_positions, devices_count * sizeof(*device_positions));
+      memcpy(map_device_to_plot, entry->map_device_to_plot, devices_count * sizeof(*map_device_to_plot));
+      *num_plots = entry->num_plots;
+      memcpy(plot_positions, entry->plot_positions, entry->num_plots * sizeof(*plot_positions));
+      *process_position = entry->process_position;
+      *setup_position = entry->setup_position;
+      return;
+    }
+    // Least recently used (or free) entry gets replaced
+    if (!layout_cache[i].valid || (entry->valid && layout_cache[i].last_use < entry->last_use))
+      entry = &layout_cache[i];
+  }
+
+  solve_layout(devices_count, device_header_rows, device_header_cols, rows, cols, to_draw, process_displayed,
+               device_positions, num_plots, plot_positions, map_device_to_plot, process_position, setup_position);
+
+  layout_cache_entry_free(entry);
+  entry->to_draw = malloc(max(1, devices_count) * sizeof(*entry->to_draw));
+  entry->device_positions = malloc(max(1, devices_count) * sizeof(*entry->device_positions));
+  entry->map_device_to_plot = malloc(max(1, devices_count) * sizeof(*entry->map_device_to_plot));
+  if (!entry->to_draw || !entry->device_positions || !entry->map_device_to_plot) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  entry->valid = true;
+  entry->last_use = ++layout_cache_clock;
+  entry->devices_count = devices_count;
+  entry->device_header_rows = device_header_rows;
+  entry->device_header_cols = device_header_cols;
+  entry->rows = rows;
+  entry->cols = cols;
+  entry->process_displayed = process_displayed;
+  memcpy(entry->to_draw, to_draw, devices_count * sizeof(*to_draw));
+  memcpy(entry->device_positions, device_positions, devices_count * sizeof(*device_positions));
+  memcpy(entry->map_device_to_plot, map_device_to_plot, devices_count * sizeof(*map_device_to_plot));
+  entry->num_plots = *num_plots;
+  memcpy(entry->plot_positions, plot_positions, *num_plots * sizeof(*plot_positions));
+  entry->process_position = *process_position;
+  entry->setup_position = *setup_position;
+}
@@ -74,11 +74,25 @@ void alloc_interface_options_internals(char *config_location,
   options->use_color = true;
   options->encode_decode_hiding_timer = 30.;
   options->temperature_in_fahrenheit = false;
+  options->device_grid_view = false;
+  options->memory_full_horizon = 30;
   options->config_file_location = NULL;
+  options->flight_recorder_triggers = NULL;
+  options->flight_recorder_trace_file = NULL;
+  options->flight_recorder_seconds = 30;
   options->sort_processes_by = process_memory;
   options->sort_descending_order = true;
   options->update_interval = 1000;
   options->process_fields_displayed = 0;
+  options->bandwidth_budget = 0;
+  options->thread_breakdown_all = false;
+  options->highlight_cross_socket = false;
+  options->roll_up_descendants = false;
+  options->detect_stragglers = false;
+  options->group_by_cgroup = false;
+  options->cgroup_group_depth = 0;
+  options->time_share_window = 10;
+  options->stranded_threshold = 5;
   if (config_location) {
     options->config_file_location = malloc(strlen(config_location) + 1);
     if (!options->config_file_location) {
@@ -113,10 +127,13 @@ static const char do_not_modify_notice[] =
 static const char general_section[] = "GeneralOption";
 static const char general_value_use_color[] = "UseColor";
 static const char general_value_update_interval[] = "UpdateInterval";
+static const char general_value_bandwidth_budget[] = "BandwidthBudget";
 
 static const char header_section[] = "HeaderOption";
 static const char header_value_use_fahrenheit[] = "UseFahrenheit";
 static const char header_value_encode_decode_timer[] = "EncodeHideTimer";
+static const char header_value_grid_view[] = "GridView";
+static const char header_value_memory_full_horizon[] = "MemoryFullHorizon";
 
 static const char chart_section[] = "ChartOption";
 static const char chart_value_reverse[] = "ReverseChart";
@@ -126,10 +143,27 @@ static const char process_value_sortby[] = "SortBy";
 static const char process_value_display_field[] = "DisplayField";
 static const char *process_sortby_vals[process_field_count + 1] = {
     "pId",     "user",   "gpuId",    "type",   "gpuRate", "encRate",
-    "decRate", "memory", "cpuUsage", "cpuMem", "cmdline", "none"};
+    "decRate", "memory", "cpuUsage", "cpuMem", "energy",  "perfPerWatt",
+    "topThreads", "ioRead", "ioWrite", "cgroup", "pressure", "cpuThrottled",
+    "numa", "timeShare", "idleGaps", "memoryGrowth", "bottleneck", "stranded",
+    "cmdline", "none"};
 static const char process_value_sort_order[] = "SortOrder";
 static const char process_sort_descending[] = "descending";
 static const char process_sort_ascending[] = "ascending";
+static const char process_value_thread_breakdown_all[] = "ThreadBreakdownAll";
+static const char process_value_highlight_cross_socket[] =
+    "HighlightCrossSocket";
+static const char process_value_roll_up_descendants[] = "RollUpDescendants";
+static const char process_value_detect_stragglers[] = "DetectStragglers";
+static const char process_value_group_by_cgroup[] = "GroupByCgroup";
+static const char process_value_cgroup_group_depth[] = "CgroupGroupDepth";
+static const char process_value_time_share_window[] = "TimeShareWindow";
+static const char process_value_stranded_threshold[] = "StrandedThreshold";
+
+static const char flight_recorder_section[] = "FlightRecorder";
+static const char flight_recorder_value_triggers[] = "Triggers";
+static const char flight_recorder_value_trace_file[] = "TraceFile";
+static const char flight_recorder_value_seconds[] = "Seconds";
 
 static const char device_section[] = "DeviceDrawOption";
 static const char device_shown_value[] = "ShownInfo";
@@ -156,6 +190,11 @@ static int nvtop_option_ini_handler(void *user, const char *section,
       if (sscanf(value, "%d", &update_interval) == 1)
         ini_data->options->update_interval = update_interval;
     }
+    if (strcmp(name, general_value_bandwidth_budget) == 0) {
+      unsigned bandwidth_budget;
+      if (sscanf(value, "%u", &bandwidth_budget) == 1)
+        ini_data->options->bandwidth_budget = bandwidth_budget;
+    }
   }
   // Header Options
   if (strcmp(section, header_section) == 0) {
@@ -172,6 +211,19 @@ static int nvtop_option_ini_handler(void *user, const char *section,
       if (sscanf(value, "%le", &value_double) == 1)
         ini_data->options->encode_decode_hiding_timer = value_double;
     }
+    if (strcmp(name, header_value_grid_view) == 0) {
+      if (strcmp(value, "true") == 0) {
+        ini_data->options->device_grid_view = true;
+      }
+      if (strcmp(value, "false") == 0) {
+        ini_data->options->device_grid_view = false;
+      }
+    }
+    if (strcmp(name, header_value_memory_full_horizon) == 0) {
+      unsigned horizon;
+      if (sscanf(value, "%u", &horizon) == 1 && horizon > 0)
+        ini_data->options->memory_full_horizon = horizon;
+    }
   }
   // Chart Options
   if (strcmp(section, chart_section) == 0) {
@@ -215,6 +267,85 @@ static int nvtop_option_ini_handler(void *user, const char *section,
         ini_data->options->sort_descending_order = false;
       }
     }
+    if (strcmp(name, process_value_thread_breakdown_all) == 0) {
+      if (strcmp(value, "true") == 0) {
+        ini_data->options->thread_breakdown_all = true;
+      }
+      if (strcmp(value, "false") == 0) {
+        ini_data->options->thread_breakdown_all = false;
+      }
+    }
+    if (strcmp(name, process_value_highlight_cross_socket) == 0) {
+      if (strcmp(value, "true") == 0) {
+        ini_data->options->highlight_cross_socket = true;
+      }
+      if (strcmp(value, "false") == 0) {
+        ini_data->options->highlight_cross_socket = false;
+      }
+    }
+    if (strcmp(name, process_value_roll_up_descendants) == 0) {
+      if (strcmp(value, "true") == 0) {
+        ini_data->options->roll_up_descendants = true;
+      }
+      if (strcmp(value, "false") == 0) {
+        ini_data->options->roll_up_descendants = false;
+      }
+    }
+    if (strcmp(name, process_value_detect_stragglers) == 0) {
+      if (strcmp(value, "true") == 0) {
+        ini_data->options->detect_stragglers = true;
+      }
+      if (strcmp(value, "false") == 0) {
+        ini_data->options->detect_stragglers = false;
+      }
+    }
+    if (strcmp(name, process_value_group_by_cgroup) == 0) {
+      if (strcmp(value, "true") == 0) {
+        ini_data->options->group_by_cgroup = true;
+      }
+      if (strcmp(value, "false") == 0) {
+        ini_data->options->group_by_cgroup = false;
+      }
+    }
+    if (strcmp(name, process_value_cgroup_group_depth) == 0) {
+      unsigned depth;
+      if (sscanf(value, "%u", &depth) == 1)
+        ini_data->options->cgroup_group_depth = depth;
+    }
+    if (strcmp(name, process_value_time_share_window) == 0) {
+      unsigned window;
+      if (sscanf(value, "%u", &window) == 1 && window > 0)
+        ini_data->options->time_share_window = window;
+    }
+    if (strcmp(name, process_value_stranded_threshold) == 0) {
+      unsigned threshold;
+      if (sscanf(value, "%u", &threshold) == 1 && threshold <= 100)
+        ini_data->options->stranded_threshold = threshold;
+    }
+  }
+  // Flight Recorder Options
+  if (strcmp(section, flight_recorder_section) == 0) {
+    if (strcmp(name, flight_recorder_value_triggers) == 0) {
+      free(ini_data->options->flight_recorder_triggers);
+      ini_data->options->flight_recorder_triggers = strdup(value);
+      if (!ini_data->options->flight_recorder_triggers) {
+        perror("Cannot allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+    }
+    if (strcmp(name, flight_recorder_value_trace_file) == 0) {
+      free(ini_data->options->flight_recorder_trace_file);
+      ini_data->options->flight_recorder_trace_file = strdup(value);
+      if (!ini_data->options->flight_recorder_trace_file) {
+        perror("Cannot allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+    }
+    if (strcmp(name, flight_recorder_value_seconds) == 0) {
+      unsigned seconds;
+      if (sscanf(value, "%u", &seconds) == 1 && seconds > 0)
+        ini_data->options->flight_recorder_seconds = seconds;
+    }
   }
   // Per-Device Sections
   assert(ini_data->num_devices < 1000 && "Not enough room for 1000 devices");
@@ -312,6 +443,8 @@ bool save_interface_options_to_config_file(
           boolean_string(options->use_color));
   fprintf(config_file, "%s = %d\n", general_value_update_interval,
           options->update_interval);
+  fprintf(config_file, "%s = %u\n", general_value_bandwidth_budget,
+          options->bandwidth_budget);
 
   // Header Options
   fprintf(config_file, "[%s]\n", header_section);
@@ -319,6 +452,10 @@ bool save_interface_options_to_config_file(
           boolean_string(options->temperature_in_fahrenheit));
   fprintf(config_file, "%s = %e\n", header_value_encode_decode_timer,
           options->encode_decode_hiding_timer);
+  fprintf(config_file, "%s = %s\n", header_value_grid_view,
+          boolean_string(options->device_grid_view));
+  fprintf(config_file, "%s = %u\n", header_value_memory_full_horizon,
+          options->memory_full_horizon);
   fprintf(config_file, "\n");
 
   // Chart Options
@@ -346,6 +483,34 @@ bool save_interface_options_to_config_file(
   if (!display_any_field)
     fprintf(config_file, "%s = %s\n", process_value_display_field,
             process_sortby_vals[process_field_count]);
+  fprintf(config_file, "%s = %s\n", process_value_thread_breakdown_all,
+          boolean_string(options->thread_breakdown_all));
+  fprintf(config_file, "%s = %s\n", process_value_highlight_cross_socket,
+          boolean_string(options->highlight_cross_socket));
+  fprintf(config_file, "%s = %s\n", process_value_roll_up_descendants,
+          boolean_string(options->roll_up_descendants));
+  fprintf(config_file, "%s = %s\n", process_value_detect_stragglers,
+          boolean_string(options->detect_stragglers));
+  fprintf(config_file, "%s = %s\n", process_value_group_by_cgroup,
+          boolean_string(options->group_by_cgroup));
+  fprintf(config_file, "%s = %u\n", process_value_cgroup_group_depth,
+          options->cgroup_group_depth);
+  fprintf(config_file, "%s = %u\n", process_value_time_share_window,
+          options->time_share_window);
+  fprintf(config_file, "%s = %u\n", process_value_stranded_threshold,
+          options->stranded_threshold);
+  fprintf(config_file, "\n");
+
+  // Flight Recorder Options
+  fprintf(config_file, "[%s]\n", flight_recorder_section);
+  if (options->flight_recorder_triggers)
+    fprintf(config_file, "%s = %s\n", flight_recorder_value_triggers,
+            options->flight_recorder_triggers);
+  if (options->flight_recorder_trace_file)
+    fprintf(config_file, "%s = %s\n", flight_recorder_value_trace_file,
+            options->flight_recorder_trace_file);
+  fprintf(config_file, "%s = %u\n", flight_recorder_value_seconds,
+          options->flight_recorder_seconds);
   fprintf(config_file, "\n");
 
   // Per-Device Sections
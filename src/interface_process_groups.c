@@ -0,0 +1,197 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/interface_process_groups.h"
+#include "nvtop/common.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const unsigned no_group = UINT_MAX;
+
+void process_groups_init(struct process_groups *groups) {
+  memset(groups, 0, sizeof(*groups));
+}
+
+void process_groups_free(struct process_groups *groups) {
+  HASH_CLEAR(hh, groups->lookup);
+  free(groups->groups);
+  free(groups->order);
+  free(groups->group_of_string);
+  free(groups->members);
+  free(groups->group_of_row);
+  for (unsigned i = 0; i < groups->expanded_count; ++i)
+    free(groups->expanded[i]);
+  free(groups->expanded);
+  memset(groups, 0, sizeof(*groups));
+}
+
+static void *grow_array(void *array, unsigned count, size_t element_size) {
+  void *grown = reallocarray(array, count, element_size);
+  if (!grown) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  return grown;
+}
+
+// Length of the first depth components of a path such as "/a/b/c"
+static unsigned path_prefix_length(const char *path, unsigned depth) {
+  unsigned length = 0;
+  if (path[length] == '/')
+    length++;
+  for (unsigned component = 0; path[length]; ++length) {
+    if (path[length] == '/' && depth && ++component == depth)
+      break;
+  }
+  return length;
+}
+
+static bool group_expanded(const struct process_groups *groups,
+                           const char *path, unsigned path_length) {
+  for (unsigned i = 0; i < groups->expanded_count; ++i)
+    if (strlen(groups->expanded[i]) == path_length &&
+        !strncmp(groups->expanded[i], path, path_length))
+      return true;
+  return false;
+}
+
+static unsigned find_or_add_group(struct process_groups *groups,
+                                  const char *path, unsigned path_length) {
+  struct process_group *group;
+  HASH_FIND(hh, groups->lookup, path, path_length, group);
+  if (group)
+    return group - groups->groups;
+  // The array was sized for one group per row and never moves while hashed
+  group = &groups->groups[groups->count];
+  memset(group, 0, sizeof(*group));
+  group->path = path;
+  group->path_length = path_length;
+  group->expanded = group_expanded(groups, path, path_length);
+  HASH_ADD_KEYPTR(hh, groups->lookup, group->path, group->path_length, group);
+  return groups->count++;
+}
+
+void process_groups_build(struct process_groups *groups,
+                          const struct gpuinfo_process_table *table,
+                          unsigned depth) {
+  HASH_CLEAR(hh, groups->lookup);
+  groups->count = 0;
+  if (table->count + 1 > groups->capacity) {
+    groups->capacity = table->count + 1;
+    groups->groups =
+        grow_array(groups->groups, groups->capacity, sizeof(*groups->groups));
+    groups->order =
+        grow_array(groups->order, groups->capacity, sizeof(*groups->order));
+  }
+  if (table->count > groups->members_capacity) {
+    groups->members_capacity = table->count;
+    groups->members = grow_array(groups->members, groups->members_capacity,
+                                 sizeof(*groups->members));
+    groups->group_of_row =
+        grow_array(groups->group_of_row, groups->members_capacity,
+                   sizeof(*groups->group_of_row));
+  }
+  unsigned strings_count = table->strings.entries_count;
+  if (strings_count > groups->group_of_string_capacity) {
+    groups->group_of_string_capacity = strings_count;
+    groups->group_of_string =
+        grow_array(groups->group_of_string, strings_count,
+                   sizeof(*groups->group_of_string));
+  }
+  for (unsigned i = 0; i < strings_count; ++i)
+    groups->group_of_string[i] = no_group;
+
+  // Rows of the same cgroup share the interned path, hence only the first one
+  // goes through the prefix lookup.
+  for (unsigned row = 0; row < table->count; ++row) {
+    unsigned group_id;
+    if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, cgroup)) {
+      unsigned string_id = table->cgroup[row];
+      group_id = groups->group_of_string[string_id];
+      if (group_id == no_group) {
+        const char *path = gpuinfo_process_table_string(table, string_id);
+        group_id = find_or_add_group(groups, path,
+                                     path_prefix_length(path, depth));
+        groups->group_of_string[string_id] = group_id;
+      }
+    } else {
+      group_id = find_or_add_group(groups, "", 0);
+    }
+    groups->group_of_row[row] = group_id;
+
+    struct process_group *group = &groups->groups[group_id];
+    group->members_count++;
+    if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, gpu_usage))
+      group->gpu_usage += table->gpu_usage[row];
+    if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, gpu_memory_usage))
+      group->gpu_memory_usage += table->gpu_memory_usage[row];
+    if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, cpu_usage))
+      group->cpu_usage += table->cpu_usage[row];
+    if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, cpu_memory_res))
+      group->cpu_memory_res += table->cpu_memory_res[row];
+    if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, energy_consumed))
+      group->energy_consumed += table->energy_consumed[row];
+    if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, gfx_engine_used))
+      group->engine_used += table->gfx_engine_used[row];
+    if (GPUINFO_PROCESS_TABLE_FIELD_VALID(table, row, compute_engine_used))
+      group->engine_used += table->compute_engine_used[row];
+  }
+
+  // Counting sort of the rows by group
+  unsigned first_member = 0;
+  for (unsigned i = 0; i < groups->count; ++i) {
+    groups->groups[i].first_member = first_member;
+    first_member += groups->groups[i].members_count;
+    groups->groups[i].members_count = 0;
+  }
+  for (unsigned row = 0; row < table->count; ++row) {
+    struct process_group *group = &groups->groups[groups->group_of_row[row]];
+    groups->members[group->first_member + group->members_count++] = row;
+  }
+}
+
+void process_groups_toggle_expanded(struct process_groups *groups,
+                                    unsigned group_id) {
+  struct process_group *group = &groups->groups[group_id];
+  group->expanded = !group->expanded;
+  if (group->expanded) {
+    char *path = strndup(group->path, group->path_length);
+    groups->expanded = grow_array(groups->expanded, groups->expanded_count + 1,
+                                  sizeof(*groups->expanded));
+    if (!path) {
+      perror("Cannot allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    groups->expanded[groups->expanded_count++] = path;
+    return;
+  }
+  for (unsigned i = 0; i < groups->expanded_count; ++i) {
+    if (strlen(groups->expanded[i]) == group->path_length &&
+        !strncmp(groups->expanded[i], group->path, group->path_length)) {
+      free(groups->expanded[i]);
+      groups->expanded[i] = groups->expanded[--groups->expanded_count];
+      return;
+    }
+  }
+}
@@ -44,26 +44,42 @@ enum setup_window_type {
 enum setup_general_options {
   setup_general_color,
   setup_general_update_interval,
+  setup_general_bandwidth_budget,
   setup_general_options_count
 };
 
 static const char
     *setup_general_option_description[setup_general_options_count] = {
         "Disable color (requires save and restart)",
-        "Update interval (seconds)"};
+        "Update interval (seconds)",
+        "Terminal output budget for slow links (KiB/s)"};
+
+// Step used by +/- on the terminal output budget
+static const unsigned setup_bandwidth_budget_step = 4;
+static const unsigned setup_bandwidth_budget_max = 4096;
+static const unsigned setup_cgroup_group_depth_max = 16;
+static const unsigned setup_time_share_window_max = GPU_TIME_SHARE_MAX_WINDOW;
+static const unsigned setup_stranded_threshold_max = 50;
+// Step and bounds used by +/- on the memory full horizon (minutes)
+static const unsigned setup_memory_full_horizon_step = 5;
+static const unsigned setup_memory_full_horizon_max = 1440;
 
 // Header Options
 
 enum setup_header_options {
   setup_header_toggle_fahrenheit,
   setup_header_enc_dec_timer,
+  setup_header_grid_view,
+  setup_header_memory_full_horizon,
   setup_header_options_count
 };
 
 static const char
     *setup_header_option_descriptions[setup_header_options_count] = {
         "Temperature in fahrenheit",
-        "Keep displaying Encoder/Decoder rate (after reaching an idle state)"};
+        "Keep displaying Encoder/Decoder rate (after reaching an idle state)",
+        "Compact grid view (one line per device, replaces the charts)",
+        "Flag the devices whose memory will be full within"};
 
 // Chart Options
 
@@ -92,6 +108,14 @@ static const char *setup_chart_gpu_value_descriptions[plot_information_count] =
 
 enum setup_proc_list_options {
   setup_proc_list_sort_ascending,
+  setup_proc_list_thread_breakdown_all,
+  setup_proc_list_highlight_cross_socket,
+  setup_proc_list_roll_up_descendants,
+  setup_proc_list_detect_stragglers,
+  setup_proc_list_group_by_cgroup,
+  setup_proc_list_cgroup_group_depth,
+  setup_proc_list_time_share_window,
+  setup_proc_list_stranded_threshold,
   setup_proc_list_sort_by,
   setup_proc_list_display,
   setup_proc_list_options_count
@@ -99,12 +123,25 @@ enum setup_proc_list_options {
 
 static const char
     *setup_proc_list_option_description[setup_proc_list_options_count] = {
-        "Sort Ascending", "Sort by", "Field Displayed"};
+        "Sort Ascending", "Top threads of every process",
+        "Highlight processes away from their GPU NUMA node",
+        "Add the CPU, memory and I/O of child processes",
+        "Highlight the ranks slowing down their distributed job",
+        "Group by cgroup", "cgroup path depth of the groups",
+        "GPU time share window (seconds)",
+        "Stranded under GPU usage (%, 0 = off)", "Sort by",
+        "Field Displayed"};
 
 static const char *setup_proc_list_value_descriptions[process_field_count] = {
     "Process Id", "User name",        "Device Id",     "Workload type",
     "GPU usage",  "Encoder usage",    "Decoder usage", "GPU memory usage",
-    "CPU usage",  "CPU memory usage", "Command"};
+    "CPU usage",  "CPU memory usage", "Energy consumed", "GPU usage per watt",
+    "Top CPU threads", "I/O read rate", "I/O write rate", "Control group",
+    "cgroup pressure stall (CPU/memory/IO)", "cgroup CPU throttling",
+    "NUMA placement", "Share of the device GPU time",
+    "Median/p95 length of the GPU idle gaps", "GPU memory growth per minute",
+    "Bottleneck (GPU, memory bandwidth, CPU thread, I/O)",
+    "Time holding idle GPU memory, idle energy", "Command"};
 
 static unsigned int sizeof_setup_windows[setup_window_type_count] = {
     [setup_window_type_setup] = 11,
@@ -259,14 +296,30 @@ static void draw_setup_window_general(struct nvtop_interface *interface) {
     mvwchgat(interface->setup_win.single, setup_general_update_interval + 1, 0,
              6, A_STANDOUT, cyan_color, NULL);
   }
+
+  if (interface->options.bandwidth_budget)
+    mvwprintw(interface->setup_win.single, setup_general_bandwidth_budget + 1, 0,
+              "[%4u] %s", interface->options.bandwidth_budget,
+              setup_general_option_description[setup_general_bandwidth_budget]);
+  else
+    mvwprintw(interface->setup_win.single, setup_general_bandwidth_budget + 1, 0,
+              "[ off] %s",
+              setup_general_option_description[setup_general_bandwidth_budget]);
+  wclrtoeol(interface->setup_win.single);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] ==
+          setup_general_bandwidth_budget) {
+    mvwchgat(interface->setup_win.single, setup_general_bandwidth_budget + 1, 0,
+             6, A_STANDOUT, cyan_color, NULL);
+  }
   wnoutrefresh(interface->setup_win.single);
 }
 
 static void draw_setup_window_header(struct nvtop_interface *interface) {
   if (interface->setup_win.indentation_level > 1)
     interface->setup_win.indentation_level = 1;
-  if (interface->setup_win.options_selected[0] > setup_header_enc_dec_timer)
-    interface->setup_win.options_selected[0] = setup_header_enc_dec_timer;
+  if (interface->setup_win.options_selected[0] > setup_header_memory_full_horizon)
+    interface->setup_win.options_selected[0] = setup_header_memory_full_horizon;
 
   WINDOW *options_win = interface->setup_win.single;
 
@@ -309,6 +362,29 @@ static void draw_setup_window_header(struct nvtop_interface *interface) {
     mvwchgat(options_win, setup_header_enc_dec_timer + 1, 0, 8, A_STANDOUT,
              cyan_color, NULL);
   }
+
+  // Grid view
+  option_state = interface->options.device_grid_view;
+  mvwprintw(options_win, setup_header_grid_view + 1, 0, "[%c] %s",
+            option_state_char(option_state),
+            setup_header_option_descriptions[setup_header_grid_view]);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] == setup_header_grid_view) {
+    mvwchgat(options_win, setup_header_grid_view + 1, 0, 3, A_STANDOUT,
+             cyan_color, NULL);
+  }
+
+  // Memory full horizon
+  mvwprintw(options_win, setup_header_memory_full_horizon + 1, 0,
+            "[%4umin] %s", interface->options.memory_full_horizon,
+            setup_header_option_descriptions[setup_header_memory_full_horizon]);
+  wclrtoeol(options_win);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] ==
+          setup_header_memory_full_horizon) {
+    mvwchgat(options_win, setup_header_memory_full_horizon + 1, 0, 9,
+             A_STANDOUT, cyan_color, NULL);
+  }
   wnoutrefresh(options_win);
 }
 
@@ -454,6 +530,17 @@ static void draw_setup_window_chart(unsigned devices_count, struct list_head *de
   }
 }
 
+// First value shown under the header line, scrolled to keep the selected value
+// in the window
+static unsigned value_list_first_row(struct nvtop_interface *interface,
+                                     WINDOW *value_list_win) {
+  unsigned rows = getmaxy(value_list_win) > 1 ? getmaxy(value_list_win) - 1 : 1;
+  if (interface->setup_win.indentation_level < 2 ||
+      interface->setup_win.options_selected[1] < rows)
+    return 0;
+  return interface->setup_win.options_selected[1] - rows + 1;
+}
+
 static void draw_setup_window_proc_list(struct nvtop_interface *interface) {
   WINDOW *option_list_win;
   if (interface->setup_win.options_selected[0] >= setup_proc_list_options_count)
@@ -490,7 +577,7 @@ static void draw_setup_window_proc_list(struct nvtop_interface *interface) {
   wattr_set(option_list_win, A_STANDOUT, green_color, NULL);
   mvwprintw(option_list_win, 0, 0, "Process List Options");
   wstandend(option_list_win);
-  unsigned int cur_col, maxcols, tmp;
+  unsigned int cur_col, maxcols, maxrows, tmp;
   (void)tmp;
   getmaxyx(option_list_win, tmp, maxcols);
   getyx(option_list_win, tmp, cur_col);
@@ -509,6 +596,112 @@ static void draw_setup_window_proc_list(struct nvtop_interface *interface) {
              A_STANDOUT, cyan_color, NULL);
   }
 
+  // Thread breakdown of every process
+  option_state = interface->options.thread_breakdown_all;
+  mvwprintw(
+      option_list_win, setup_proc_list_thread_breakdown_all + 1, 0, "[%c] %s",
+      option_state_char(option_state),
+      setup_proc_list_option_description[setup_proc_list_thread_breakdown_all]);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] ==
+          setup_proc_list_thread_breakdown_all) {
+    mvwchgat(option_list_win, setup_proc_list_thread_breakdown_all + 1, 0, 3,
+             A_STANDOUT, cyan_color, NULL);
+  }
+
+  // Cross-socket highlighting
+  option_state = interface->options.highlight_cross_socket;
+  mvwprintw(option_list_win, setup_proc_list_highlight_cross_socket + 1, 0,
+            "[%c] %s", option_state_char(option_state),
+            setup_proc_list_option_description
+                [setup_proc_list_highlight_cross_socket]);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] ==
+          setup_proc_list_highlight_cross_socket) {
+    mvwchgat(option_list_win, setup_proc_list_highlight_cross_socket + 1, 0, 3,
+             A_STANDOUT, cyan_color, NULL);
+  }
+
+  // Roll up of the child processes
+  option_state = interface->options.roll_up_descendants;
+  mvwprintw(option_list_win, setup_proc_list_roll_up_descendants + 1, 0,
+            "[%c] %s", option_state_char(option_state),
+            setup_proc_list_option_description
+                [setup_proc_list_roll_up_descendants]);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] ==
+          setup_proc_list_roll_up_descendants) {
+    mvwchgat(option_list_win, setup_proc_list_roll_up_descendants + 1, 0, 3,
+             A_STANDOUT, cyan_color, NULL);
+  }
+
+  // Straggler detection
+  option_state = interface->options.detect_stragglers;
+  mvwprintw(option_list_win, setup_proc_list_detect_stragglers + 1, 0,
+            "[%c] %s", option_state_char(option_state),
+            setup_proc_list_option_description
+                [setup_proc_list_detect_stragglers]);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] ==
+          setup_proc_list_detect_stragglers) {
+    mvwchgat(option_list_win, setup_proc_list_detect_stragglers + 1, 0, 3,
+             A_STANDOUT, cyan_color, NULL);
+  }
+
+  // cgroup grouping
+  option_state = interface->options.group_by_cgroup;
+  mvwprintw(option_list_win, setup_proc_list_group_by_cgroup + 1, 0, "[%c] %s",
+            option_state_char(option_state),
+            setup_proc_list_option_description[setup_proc_list_group_by_cgroup]);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] ==
+          setup_proc_list_group_by_cgroup) {
+    mvwchgat(option_list_win, setup_proc_list_group_by_cgroup + 1, 0, 3,
+             A_STANDOUT, cyan_color, NULL);
+  }
+
+  if (interface->options.cgroup_group_depth)
+    mvwprintw(option_list_win, setup_proc_list_cgroup_group_depth + 1, 0,
+              "[%3u] %s", interface->options.cgroup_group_depth,
+              setup_proc_list_option_description
+                  [setup_proc_list_cgroup_group_depth]);
+  else
+    mvwprintw(option_list_win, setup_proc_list_cgroup_group_depth + 1, 0,
+              "[all] %s",
+              setup_proc_list_option_description
+                  [setup_proc_list_cgroup_group_depth]);
+  wclrtoeol(option_list_win);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] ==
+          setup_proc_list_cgroup_group_depth) {
+    mvwchgat(option_list_win, setup_proc_list_cgroup_group_depth + 1, 0, 5,
+             A_STANDOUT, cyan_color, NULL);
+  }
+
+  mvwprintw(option_list_win, setup_proc_list_time_share_window + 1, 0,
+            "[%3u] %s", interface->options.time_share_window,
+            setup_proc_list_option_description
+                [setup_proc_list_time_share_window]);
+  wclrtoeol(option_list_win);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] ==
+          setup_proc_list_time_share_window) {
+    mvwchgat(option_list_win, setup_proc_list_time_share_window + 1, 0, 5,
+             A_STANDOUT, cyan_color, NULL);
+  }
+
+  mvwprintw(option_list_win, setup_proc_list_stranded_threshold + 1, 0,
+            "[%3u] %s", interface->options.stranded_threshold,
+            setup_proc_list_option_description
+                [setup_proc_list_stranded_threshold]);
+  wclrtoeol(option_list_win);
+  if (interface->setup_win.indentation_level == 1 &&
+      interface->setup_win.options_selected[0] ==
+          setup_proc_list_stranded_threshold) {
+    mvwchgat(option_list_win, setup_proc_list_stranded_threshold + 1, 0, 5,
+             A_STANDOUT, cyan_color, NULL);
+  }
+
   for (enum setup_proc_list_options i = setup_proc_list_sort_by;
        i < setup_proc_list_options_count; ++i) {
     if (interface->setup_win.options_selected[0] == i) {
@@ -532,25 +725,29 @@ static void draw_setup_window_proc_list(struct nvtop_interface *interface) {
       mvwprintw(value_list_win, 0, 0, "Processes are sorted by:");
       wstandend(value_list_win);
       wclrtoeol(value_list_win);
-      getmaxyx(value_list_win, tmp, maxcols);
+      getmaxyx(value_list_win, maxrows, maxcols);
       getyx(value_list_win, tmp, cur_col);
       mvwchgat(value_list_win, 0, cur_col, maxcols - cur_col, A_STANDOUT,
                green_color, NULL);
       unsigned index = 0;
+      unsigned first_row = value_list_first_row(interface, value_list_win);
       for (enum process_field field = process_pid; field < process_field_count;
            ++field) {
         if (process_is_field_displayed(
                 field, interface->options.process_fields_displayed)) {
-          option_state = interface->options.sort_processes_by == field;
-          mvwprintw(value_list_win, index + 1, 0, "[%c] %s",
-                    option_state_char(option_state),
-                    setup_proc_list_value_descriptions[field]);
-          wclrtoeol(value_list_win);
-          if (interface->setup_win.indentation_level == 2 &&
-              interface->setup_win.options_selected[1] == index) {
-            mvwchgat(value_list_win, index + 1, 0, 3, A_STANDOUT, cyan_color,
-                     NULL);
-            wmove(value_list_win, field + 2, 0);
+          if (index >= first_row && index - first_row + 1 < maxrows) {
+            unsigned row = index - first_row + 1;
+            option_state = interface->options.sort_processes_by == field;
+            mvwprintw(value_list_win, row, 0, "[%c] %s",
+                      option_state_char(option_state),
+                      setup_proc_list_value_descriptions[field]);
+            wclrtoeol(value_list_win);
+            if (interface->setup_win.indentation_level == 2 &&
+                interface->setup_win.options_selected[1] == index) {
+              mvwchgat(value_list_win, row, 0, 3, A_STANDOUT, cyan_color,
+                       NULL);
+              wmove(value_list_win, row + 1, 0);
+            }
           }
           index++;
         }
@@ -569,23 +766,26 @@ static void draw_setup_window_proc_list(struct nvtop_interface *interface) {
       mvwprintw(value_list_win, 0, 0, "Process Field Displayed:");
       wstandend(value_list_win);
       wclrtoeol(value_list_win);
-      getmaxyx(value_list_win, tmp, maxcols);
+      getmaxyx(value_list_win, maxrows, maxcols);
       getyx(value_list_win, tmp, cur_col);
       mvwchgat(value_list_win, 0, cur_col, maxcols - cur_col, A_STANDOUT,
                green_color, NULL);
-      for (enum process_field field = process_pid; field < process_field_count;
+      unsigned first_row = value_list_first_row(interface, value_list_win);
+      for (enum process_field field = first_row;
+           field < process_field_count && field - first_row + 1 < maxrows;
            ++field) {
+        unsigned row = field - first_row + 1;
         option_state = process_is_field_displayed(
             field, interface->options.process_fields_displayed);
-        mvwprintw(value_list_win, field + 1, 0, "[%c] %s",
+        mvwprintw(value_list_win, row, 0, "[%c] %s",
                   option_state_char(option_state),
                   setup_proc_list_value_descriptions[field]);
         wclrtoeol(value_list_win);
         if (interface->setup_win.indentation_level == 2 &&
             interface->setup_win.options_selected[1] == field) {
-          mvwchgat(value_list_win, field + 1, 0, 3, A_STANDOUT, cyan_color,
+          mvwchgat(value_list_win, row, 0, 3, A_STANDOUT, cyan_color,
                    NULL);
-          wmove(value_list_win, field + 2, 0);
+          wmove(value_list_win, row + 1, 0);
         }
       }
     }
@@ -705,6 +905,14 @@ void handle_setup_win_keypress(int keyId, struct nvtop_interface *interface) {
           if (interface->options.update_interval <= 99800)
             interface->options.update_interval += 100;
         }
+        if (interface->setup_win.options_selected[0] ==
+            setup_general_bandwidth_budget) {
+          if (interface->options.bandwidth_budget + setup_bandwidth_budget_step <=
+              setup_bandwidth_budget_max)
+            interface->options.bandwidth_budget += setup_bandwidth_budget_step;
+          bandwidth_set_budget(&interface->bandwidth,
+                               interface->options.bandwidth_budget);
+        }
       }
       // Header options
       if (interface->setup_win.selected_section == setup_header_selected) {
@@ -713,8 +921,37 @@ void handle_setup_win_keypress(int keyId, struct nvtop_interface *interface) {
               setup_header_enc_dec_timer) {
             interface->options.encode_decode_hiding_timer += 5.;
           }
+          if (interface->setup_win.options_selected[0] ==
+                  setup_header_memory_full_horizon &&
+              interface->options.memory_full_horizon +
+                      setup_memory_full_horizon_step <=
+                  setup_memory_full_horizon_max)
+            interface->options.memory_full_horizon +=
+                setup_memory_full_horizon_step;
         }
       }
+      // Process List Options
+      if (interface->setup_win.selected_section ==
+              setup_process_list_selected &&
+          interface->setup_win.indentation_level == 1 &&
+          interface->setup_win.options_selected[0] ==
+              setup_proc_list_cgroup_group_depth &&
+          interface->options.cgroup_group_depth < setup_cgroup_group_depth_max)
+        interface->options.cgroup_group_depth++;
+      if (interface->setup_win.selected_section ==
+              setup_process_list_selected &&
+          interface->setup_win.indentation_level == 1 &&
+          interface->setup_win.options_selected[0] ==
+              setup_proc_list_time_share_window &&
+          interface->options.time_share_window < setup_time_share_window_max)
+        interface->options.time_share_window++;
+      if (interface->setup_win.selected_section ==
+              setup_process_list_selected &&
+          interface->setup_win.indentation_level == 1 &&
+          interface->setup_win.options_selected[0] ==
+              setup_proc_list_stranded_threshold &&
+          interface->options.stranded_threshold < setup_stranded_threshold_max)
+        interface->options.stranded_threshold++;
       break;
     case '-':
       // General Options
@@ -724,6 +961,15 @@ void handle_setup_win_keypress(int keyId, struct nvtop_interface *interface) {
           if (interface->options.update_interval >= 200)
             interface->options.update_interval -= 100;
         }
+        if (interface->setup_win.options_selected[0] ==
+            setup_general_bandwidth_budget) {
+          if (interface->options.bandwidth_budget >= setup_bandwidth_budget_step)
+            interface->options.bandwidth_budget -= setup_bandwidth_budget_step;
+          else
+            interface->options.bandwidth_budget = 0;
+          bandwidth_set_budget(&interface->bandwidth,
+                               interface->options.bandwidth_budget);
+        }
       }
       // Header options
       if (interface->setup_win.selected_section == setup_header_selected) {
@@ -735,8 +981,36 @@ void handle_setup_win_keypress(int keyId, struct nvtop_interface *interface) {
               interface->options.encode_decode_hiding_timer = 0.;
             }
           }
+          if (interface->setup_win.options_selected[0] ==
+                  setup_header_memory_full_horizon &&
+              interface->options.memory_full_horizon >
+                  setup_memory_full_horizon_step)
+            interface->options.memory_full_horizon -=
+                setup_memory_full_horizon_step;
         }
       }
+      // Process List Options
+      if (interface->setup_win.selected_section ==
+              setup_process_list_selected &&
+          interface->setup_win.indentation_level == 1 &&
+          interface->setup_win.options_selected[0] ==
+              setup_proc_list_cgroup_group_depth &&
+          interface->options.cgroup_group_depth > 0)
+        interface->options.cgroup_group_depth--;
+      if (interface->setup_win.selected_section ==
+              setup_process_list_selected &&
+          interface->setup_win.indentation_level == 1 &&
+          interface->setup_win.options_selected[0] ==
+              setup_proc_list_time_share_window &&
+          interface->options.time_share_window > 1)
+        interface->options.time_share_window--;
+      if (interface->setup_win.selected_section ==
+              setup_process_list_selected &&
+          interface->setup_win.indentation_level == 1 &&
+          interface->setup_win.options_selected[0] ==
+              setup_proc_list_stranded_threshold &&
+          interface->options.stranded_threshold > 0)
+        interface->options.stranded_threshold--;
       break;
     case '\n':
     case KEY_ENTER:
@@ -769,6 +1043,11 @@ void handle_setup_win_keypress(int keyId, struct nvtop_interface *interface) {
               interface->options.encode_decode_hiding_timer = 30.;
             }
           }
+          if (interface->setup_win.options_selected[0] ==
+              setup_header_grid_view) {
+            interface->options.device_grid_view =
+                !interface->options.device_grid_view;
+          }
         }
       }
       // Chart Options
@@ -837,6 +1116,26 @@ void handle_setup_win_keypress(int keyId, struct nvtop_interface *interface) {
               setup_proc_list_sort_ascending) {
             interface->options.sort_descending_order =
                 !interface->options.sort_descending_order;
+          } else if (interface->setup_win.options_selected[0] ==
+                     setup_proc_list_thread_breakdown_all) {
+            interface->options.thread_breakdown_all =
+                !interface->options.thread_breakdown_all;
+          } else if (interface->setup_win.options_selected[0] ==
+                     setup_proc_list_highlight_cross_socket) {
+            interface->options.highlight_cross_socket =
+                !interface->options.highlight_cross_socket;
+          } else if (interface->setup_win.options_selected[0] ==
+                     setup_proc_list_roll_up_descendants) {
+            interface->options.roll_up_descendants =
+                !interface->options.roll_up_descendants;
+          } else if (interface->setup_win.options_selected[0] ==
+                     setup_proc_list_detect_stragglers) {
+            interface->options.detect_stragglers =
+                !interface->options.detect_stragglers;
+          } else if (interface->setup_win.options_selected[0] ==
+                     setup_proc_list_group_by_cgroup) {
+            interface->options.group_by_cgroup =
+                !interface->options.group_by_cgroup;
           } else if (interface->setup_win.options_selected[0] ==
                      setup_proc_list_sort_by) {
             handle_setup_win_keypress(KEY_RIGHT, interface);
@@ -0,0 +1,233 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/interface_tuning_win.h"
+#include "nvtop/device_tuning.h"
+
+#include <ncurses.h>
+#include <stdio.h>
+#include <string.h>
+
+static const unsigned tuning_name_width = 20;
+
+// The rows are the knobs the device has, followed by the undo row
+static unsigned tuning_rows(const struct tuning_window *tuning_win,
+                            enum gpuinfo_tuning_knob_id rows[gpuinfo_tuning_knob_count + 1]) {
+  unsigned count = 0;
+  for (enum gpuinfo_tuning_knob_id knob = gpuinfo_tuning_power_limit; knob < gpuinfo_tuning_knob_count; ++knob) {
+    if (tuning_win->tuning.knobs[knob].available)
+      rows[count++] = knob;
+  }
+  rows[count++] = gpuinfo_tuning_knob_count;
+  return count;
+}
+
+static void reset_tuning_selection(struct tuning_window *tuning_win) {
+  tuning_win->stale = true;
+  tuning_win->selected_row = 0;
+  tuning_win->confirming = false;
+  memset(tuning_win->pending_set, 0, sizeof(tuning_win->pending_set));
+}
+
+void show_tuning_window(struct nvtop_interface *interface) {
+  struct tuning_window *tuning_win = &interface->tuning_win;
+  if (tuning_win->device_index >= interface->devices_count)
+    tuning_win->device_index = 0;
+  reset_tuning_selection(tuning_win);
+  tuning_win->message[0] = '\0';
+  interface->process.option_window.state = nvtop_option_state_tune;
+}
+
+static int pending_value(const struct tuning_window *tuning_win, enum gpuinfo_tuning_knob_id knob) {
+  return tuning_win->pending_set[knob] ? tuning_win->pending[knob] : tuning_win->tuning.knobs[knob].value;
+}
+
+void draw_tuning_window(struct list_head *devices, struct nvtop_interface *interface) {
+  WINDOW *win = interface->process.process_win;
+  if (!win)
+    return;
+  struct tuning_window *tuning_win = &interface->tuning_win;
+  const struct gpu_info *previous_device = tuning_win->device;
+  tuning_win->device = NULL;
+  unsigned index = 0;
+  struct gpu_info *device;
+  list_for_each_entry(device, devices, list) {
+    if (index++ == tuning_win->device_index) {
+      tuning_win->device = device;
+      break;
+    }
+  }
+  // The driver is only queried once per refresh, not at every key press
+  if (tuning_win->stale || tuning_win->device != previous_device) {
+    tuning_win->stale = false;
+    if (tuning_win->device && !gpuinfo_is_placeholder_device(tuning_win->device))
+      tuning_read(tuning_win->device, &tuning_win->tuning);
+    else
+      memset(&tuning_win->tuning, 0, sizeof(tuning_win->tuning));
+  }
+
+  enum gpuinfo_tuning_knob_id rows[gpuinfo_tuning_knob_count + 1];
+  unsigned rows_count = tuning_rows(tuning_win, rows);
+  if (tuning_win->selected_row >= rows_count)
+    tuning_win->selected_row = rows_count - 1;
+
+  werase(win);
+  wattr_set(win, A_STANDOUT, green_color, NULL);
+  mvwprintw(win, 0, 0, "Tune GPU %u", tuning_win->device_index);
+  if (tuning_win->device && IS_VALID(gpuinfo_device_name_valid, tuning_win->device->static_info.valid))
+    wprintw(win, " %s", tuning_win->device->static_info.device_name);
+  wstandend(win);
+
+  int win_rows, cols;
+  getmaxyx(win, win_rows, cols);
+  (void)cols;
+  if (rows_count == 1)
+    mvwprintw(win, 1, 0, "No tuning knob available for this device");
+  char current[GPUINFO_TUNING_CHOICE_NAME_SIZE], pending[GPUINFO_TUNING_CHOICE_NAME_SIZE];
+  for (unsigned i = 0; i < rows_count && (int)i + 2 < win_rows; ++i) {
+    int row = rows_count == 1 ? 2 : (int)i + 1;
+    if (i == tuning_win->selected_row)
+      wattr_set(win, A_STANDOUT, cyan_color, NULL);
+    if (rows[i] == gpuinfo_tuning_knob_count) {
+      mvwprintw(win, row, 0, "%-*s%u change%s", tuning_name_width, "Undo last change", tuning_changes_count(),
+                tuning_changes_count() == 1 ? "" : "s");
+    } else {
+      const struct gpuinfo_tuning_knob *knob = &tuning_win->tuning.knobs[rows[i]];
+      tuning_format_value(knob, rows[i], knob->value, current, sizeof(current));
+      mvwprintw(win, row, 0, "%-*s%s", tuning_name_width, tuning_knob_name(rows[i]), current);
+      int value = pending_value(tuning_win, rows[i]);
+      if (value != knob->value) {
+        tuning_format_value(knob, rows[i], value, pending, sizeof(pending));
+        wprintw(win, " -> %s", pending);
+      }
+    }
+    if (i == tuning_win->selected_row)
+      wstandend(win);
+  }
+  if (tuning_win->message[0]) {
+    wattr_set(win, A_BOLD, tuning_win->confirming ? yellow_color : cyan_color, NULL);
+    mvwprintw(win, win_rows - 1, 0, "%s", tuning_win->message);
+    wstandend(win);
+  }
+  wnoutrefresh(win);
+}
+
+static void apply_selected_row(struct nvtop_interface *interface, enum gpuinfo_tuning_knob_id knob) {
+  struct tuning_window *tuning_win = &interface->tuning_win;
+  const char *error = NULL;
+  bool success;
+  char value[GPUINFO_TUNING_CHOICE_NAME_SIZE];
+  if (knob == gpuinfo_tuning_knob_count) {
+    success = tuning_undo(&error);
+    snprintf(tuning_win->message, sizeof(tuning_win->message), "Undo: %s", success ? "done" : error);
+  } else {
+    int pending = pending_value(tuning_win, knob);
+    tuning_format_value(&tuning_win->tuning.knobs[knob], knob, pending, value, sizeof(value));
+    success = tuning_apply(tuning_win->device, tuning_win->device_index, knob, pending, &error);
+    if (success)
+      tuning_win->pending_set[knob] = false;
+    snprintf(tuning_win->message, sizeof(tuning_win->message), "%s %s: %s", tuning_knob_name(knob), value,
+             success ? "done" : error);
+  }
+  tuning_win->stale = true;
+  // Strip the newline some vendors end their errors with
+  tuning_win->message[strcspn(tuning_win->message, "\n")] = '\0';
+}
+
+static void request_confirmation(struct nvtop_interface *interface, enum gpuinfo_tuning_knob_id knob) {
+  struct tuning_window *tuning_win = &interface->tuning_win;
+  if (knob == gpuinfo_tuning_knob_count) {
+    if (!tuning_changes_count()) {
+      snprintf(tuning_win->message, sizeof(tuning_win->message), "Nothing to undo");
+      return;
+    }
+    snprintf(tuning_win->message, sizeof(tuning_win->message), "Press Enter again to undo the last change");
+  } else {
+    const struct gpuinfo_tuning_knob *state = &tuning_win->tuning.knobs[knob];
+    int pending = pending_value(tuning_win, knob);
+    if (pending == state->value) {
+      snprintf(tuning_win->message, sizeof(tuning_win->message), "Pick a new value with + and -");
+      return;
+    }
+    char current[GPUINFO_TUNING_CHOICE_NAME_SIZE], value[GPUINFO_TUNING_CHOICE_NAME_SIZE];
+    tuning_format_value(state, knob, state->value, current, sizeof(current));
+    tuning_format_value(state, knob, pending, value, sizeof(value));
+    snprintf(tuning_win->message, sizeof(tuning_win->message),
+             "Press Enter again to change the %s of GPU %u from %s to %s", tuning_knob_name(knob),
+             tuning_win->device_index, current, value);
+  }
+  tuning_win->confirming = true;
+}
+
+void handle_tuning_win_keypress(int keyId, struct nvtop_interface *interface) {
+  struct tuning_window *tuning_win = &interface->tuning_win;
+  enum gpuinfo_tuning_knob_id rows[gpuinfo_tuning_knob_count + 1];
+  unsigned rows_count = tuning_rows(tuning_win, rows);
+  enum gpuinfo_tuning_knob_id selected = rows[min(tuning_win->selected_row, rows_count - 1)];
+  bool confirming = tuning_win->confirming;
+  tuning_win->confirming = false;
+  switch (keyId) {
+  case KEY_UP:
+    if (tuning_win->selected_row > 0)
+      tuning_win->selected_row--;
+    tuning_win->message[0] = '\0';
+    break;
+  case KEY_DOWN:
+    if (tuning_win->selected_row + 1 < rows_count)
+      tuning_win->selected_row++;
+    tuning_win->message[0] = '\0';
+    break;
+  case KEY_LEFT:
+  case KEY_RIGHT:
+    if (keyId == KEY_RIGHT && tuning_win->device_index + 1 < interface->devices_count)
+      tuning_win->device_index++;
+    if (keyId == KEY_LEFT && tuning_win->device_index > 0)
+      tuning_win->device_index--;
+    reset_tuning_selection(tuning_win);
+    tuning_win->message[0] = '\0';
+    break;
+  case '+':
+  case '-':
+    if (selected != gpuinfo_tuning_knob_count) {
+      tuning_win->pending[selected] =
+          tuning_knob_step(&tuning_win->tuning.knobs[selected], pending_value(tuning_win, selected), keyId == '+');
+      tuning_win->pending_set[selected] = true;
+    }
+    tuning_win->message[0] = '\0';
+    break;
+  case '\n':
+  case KEY_ENTER:
+    if (!tuning_win->device)
+      break;
+    if (confirming)
+      apply_selected_row(interface, selected);
+    else
+      request_confirmation(interface, selected);
+    break;
+  case 27:
+    interface->process.option_window.state = nvtop_option_state_hidden;
+    break;
+  default:
+    tuning_win->message[0] = '\0';
+    break;
+  }
+}
@@ -0,0 +1,164 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/libnvtop.h"
+#include "nvtop/extract_gpuinfo.h"
+
+#include <string.h>
+
+static bool initialized = false;
+static unsigned devices_count;
+static LIST_HEAD(devices);
+static struct gpuinfo_device_mask devices_mask;
+
+#define COPY_FIELD(dst, dst_field, src, src_field, field_id, prefix)                                                   \
+  do {                                                                                                                 \
+    if (VALUE_IS_VALID(src, src_field, prefix)) {                                                                      \
+      (dst)->dst_field = (src)->src_field;                                                                             \
+      (dst)->valid |= 1u << (field_id);                                                                                \
+    }                                                                                                                  \
+  } while (0)
+
+static void copy_device(unsigned index, const struct gpu_info *gpu, struct libnvtop_device *device) {
+  const struct gpuinfo_dynamic_info *dynamic_info = &gpu->dynamic_info;
+
+  memset(device, 0, sizeof(*device));
+  device->index = index;
+  if (GPUINFO_STATIC_FIELD_VALID(&gpu->static_info, device_name)) {
+    strncpy(device->name, gpu->static_info.device_name, sizeof(device->name) - 1);
+  }
+  COPY_FIELD(device, gpu_util, dynamic_info, gpu_util_rate, libnvtop_device_gpu_util, gpuinfo_);
+  COPY_FIELD(device, mem_util, dynamic_info, mem_util_rate, libnvtop_device_mem_util, gpuinfo_);
+  COPY_FIELD(device, mem_bandwidth_util, dynamic_info, mem_bandwidth_rate, libnvtop_device_mem_bandwidth_util,
+             gpuinfo_);
+  COPY_FIELD(device, total_memory, dynamic_info, total_memory, libnvtop_device_total_memory, gpuinfo_);
+  COPY_FIELD(device, used_memory, dynamic_info, used_memory, libnvtop_device_used_memory, gpuinfo_);
+  COPY_FIELD(device, temperature, dynamic_info, gpu_temp, libnvtop_device_temperature, gpuinfo_);
+  COPY_FIELD(device, power_draw, dynamic_info, power_draw, libnvtop_device_power_draw, gpuinfo_);
+  COPY_FIELD(device, power_limit, dynamic_info, power_draw_max, libnvtop_device_power_limit, gpuinfo_);
+  COPY_FIELD(device, gpu_clock, dynamic_info, gpu_clock_speed, libnvtop_device_gpu_clock, gpuinfo_);
+  COPY_FIELD(device, mem_clock, dynamic_info, mem_clock_speed, libnvtop_device_mem_clock, gpuinfo_);
+  COPY_FIELD(device, fan_speed, dynamic_info, fan_speed, libnvtop_device_fan_speed, gpuinfo_);
+  COPY_FIELD(device, encoder_util, dynamic_info, encoder_rate, libnvtop_device_encoder_util, gpuinfo_);
+  COPY_FIELD(device, decoder_util, dynamic_info, decoder_rate, libnvtop_device_decoder_util, gpuinfo_);
+  COPY_FIELD(device, pcie_rx, dynamic_info, pcie_rx, libnvtop_device_pcie_rx, gpuinfo_);
+  COPY_FIELD(device, pcie_tx, dynamic_info, pcie_tx, libnvtop_device_pcie_tx, gpuinfo_);
+  device->processes_count = gpu->processes_count;
+}
+
+static void copy_process(unsigned device_index, const struct gpu_process *gpu_process,
+                         struct libnvtop_process *process) {
+  memset(process, 0, sizeof(*process));
+  process->pid = gpu_process->pid;
+  process->device_index = device_index;
+  process->type =
+      gpu_process->type == gpu_process_compute ? libnvtop_process_compute : libnvtop_process_graphical;
+  COPY_FIELD(process, gpu_util, gpu_process, gpu_usage, libnvtop_process_gpu_util, gpuinfo_process_);
+  COPY_FIELD(process, encoder_util, gpu_process, encode_usage, libnvtop_process_encoder_util, gpuinfo_process_);
+  COPY_FIELD(process, decoder_util, gpu_process, decode_usage, libnvtop_process_decoder_util, gpuinfo_process_);
+  COPY_FIELD(process, gpu_memory, gpu_process, gpu_memory_usage, libnvtop_process_gpu_memory, gpuinfo_process_);
+  COPY_FIELD(process, cpu_util, gpu_process, cpu_usage, libnvtop_process_cpu_util, gpuinfo_process_);
+  COPY_FIELD(process, cpu_memory, gpu_process, cpu_memory_res, libnvtop_process_cpu_memory, gpuinfo_process_);
+}
+
+bool libnvtop_init(unsigned api_version) {
+  if (api_version != LIBNVTOP_API_VERSION || initialized)
+    return false;
+  gpuinfo_device_mask_init(&devices_mask, true);
+  devices_count = 0;
+  gpuinfo_init_info_extraction(&devices_mask, &devices_count, &devices);
+  gpuinfo_device_mask_free(&devices_mask);
+  if (devices_count == 0) {
+    gpuinfo_shutdown_info_extraction(&devices);
+    return false;
+  }
+  initialized = true;
+  return true;
+}
+
+unsigned libnvtop_device_count(void) { return initialized ? devices_count : 0; }
+
+bool libnvtop_snapshot(struct libnvtop_device *devices_out, size_t devices_capacity, size_t *devices_out_count,
+                       struct libnvtop_process *processes_out, size_t processes_capacity,
+                       size_t *processes_out_count) {
+  size_t device_idx = 0, process_idx = 0;
+
+  if (initialized) {
+    gpuinfo_refresh_dynamic_info(&devices);
+    gpuinfo_refresh_processes(&devices);
+    gpuinfo_fix_dynamic_info_from_process_info(&devices);
+
+    struct gpu_info *gpu;
+    list_for_each_entry(gpu, &devices, list) {
+      if (device_idx < devices_capacity)
+        copy_device(device_idx, gpu, &devices_out[device_idx]);
+      for (unsigned i = 0; i < gpu->processes_count; ++i, ++process_idx) {
+        if (process_idx < processes_capacity)
+          copy_process(device_idx, &gpu->processes[i], &processes_out[process_idx]);
+      }
+      device_idx++;
+    }
+  }
+  if (devices_out_count)
+    *devices_out_count = device_idx;
+  if (processes_out_count)
+    *processes_out_count = process_idx;
+  return initialized;
+}
+
+void libnvtop_foreach_device(libnvtop_device_visitor visitor, void *data) {
+  if (!initialized)
+    return;
+  struct libnvtop_device device;
+  unsigned device_idx = 0;
+  struct gpu_info *gpu;
+  list_for_each_entry(gpu, &devices, list) {
+    copy_device(device_idx++, gpu, &device);
+    if (!visitor(&device, data))
+      return;
+  }
+}
+
+void libnvtop_foreach_process(libnvtop_process_visitor visitor, void *data) {
+  if (!initialized)
+    return;
+  struct libnvtop_process process;
+  unsigned device_idx = 0;
+  struct gpu_info *gpu;
+  list_for_each_entry(gpu, &devices, list) {
+    for (unsigned i = 0; i < gpu->processes_count; ++i) {
+      copy_process(device_idx, &gpu->processes[i], &process);
+      if (!visitor(&process, data))
+        return;
+    }
+    device_idx++;
+  }
+}
+
+void libnvtop_shutdown(void) {
+  if (!initialized)
+    return;
+  gpuinfo_shutdown_info_extraction(&devices);
+  INIT_LIST_HEAD(&devices);
+  devices_count = 0;
+  initialized = false;
+}
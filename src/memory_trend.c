@@ -0,0 +1,83 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/memory_trend.h"
+
+static const double min_window_span = 60.;
+
+static void add_to_sums(struct memory_trend *trend, double t, double v, double sign) {
+  trend->sum_t += sign * t;
+  trend->sum_v += sign * v;
+  trend->sum_tt += sign * t * t;
+  trend->sum_tv += sign * t * v;
+}
+
+// Moves the origin to the oldest sample and sums again from scratch, once per
+// window, so that the rounding errors of the updates do not pile up
+static void rebase(struct memory_trend *trend) {
+  unsigned oldest = trend->count < MEMORY_TREND_SAMPLES ? 0 : trend->next;
+  double shift = trend->times[oldest];
+  trend->origin += (uint64_t)(shift * 1e9);
+  trend->sum_t = trend->sum_v = trend->sum_tt = trend->sum_tv = 0.;
+  for (unsigned i = 0; i < trend->count; ++i) {
+    trend->times[i] -= shift;
+    add_to_sums(trend, trend->times[i], trend->values[i], 1.);
+  }
+}
+
+void memory_trend_add_sample(struct memory_trend *trend, uint64_t timestamp, double value) {
+  if (!trend->started || timestamp < trend->last_sample) {
+    trend->started = true;
+    trend->origin = timestamp;
+    trend->count = trend->next = 0;
+    trend->sum_t = trend->sum_v = trend->sum_tt = trend->sum_tv = 0.;
+  } else if ((timestamp - trend->last_sample) / 1e9 < MEMORY_TREND_SAMPLE_PERIOD) {
+    return;
+  }
+  trend->last_sample = timestamp;
+  double t = (timestamp - trend->origin) / 1e9;
+  if (trend->count == MEMORY_TREND_SAMPLES)
+    add_to_sums(trend, trend->times[trend->next], trend->values[trend->next], -1.);
+  else
+    trend->count++;
+  trend->times[trend->next] = t;
+  trend->values[trend->next] = value;
+  add_to_sums(trend, t, value, 1.);
+  trend->next = (trend->next + 1) % MEMORY_TREND_SAMPLES;
+  if (trend->next == 0)
+    rebase(trend);
+}
+
+bool memory_trend_slope(const struct memory_trend *trend, double *slope) {
+  if (trend->count < 2)
+    return false;
+  unsigned oldest = trend->count < MEMORY_TREND_SAMPLES ? 0 : trend->next;
+  unsigned newest = (trend->next + MEMORY_TREND_SAMPLES - 1) % MEMORY_TREND_SAMPLES;
+  if (trend->times[newest] - trend->times[oldest] < min_window_span)
+    return false;
+  double n = trend->count;
+  double denominator = n * trend->sum_tt - trend->sum_t * trend->sum_t;
+  if (denominator <= 0.)
+    return false;
+  *slope = (n * trend->sum_tv - trend->sum_t * trend->sum_v) / denominator;
+  return true;
+}
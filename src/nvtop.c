@@ -19,6 +19,7 @@
  *
  */
 
+#include <errno.h>
 #include <getopt.h>
 #include <ncurses.h>
 #include <signal.h>
@@ -29,7 +30,12 @@
 
 #include <locale.h>
 
+#include "nvtop/device_topology_cache.h"
+#include "nvtop/device_tuning.h"
 #include "nvtop/extract_gpuinfo.h"
+#include "nvtop/extract_process_scope.h"
+#include "nvtop/extract_session_summary.h"
+#include "nvtop/flight_recorder.h"
 #include "nvtop/interface.h"
 #include "nvtop/interface_common.h"
 #include "nvtop/interface_options.h"
@@ -65,6 +71,15 @@ static const char helpstring[] =
     "  -f --freedom-unit : Use fahrenheit\n"
     "  -E --encode-hide  : Set encode/decode auto hide time in seconds "
     "(default 30s, negative = always on screen)\n"
+    "  -b --bandwidth-budget\n"
+    "                    : Limit the terminal output to the given KiB/s "
+    "for slow remote links (0 = unlimited)\n"
+    "  -g --grid         : Compact view with one line per GPU\n"
+    "  -G --cgroup       : Only monitor the processes of this cgroup v2 "
+    "and of its descendants\n"
+    "  -P --pid-tree     : Only monitor this process and its descendants\n"
+    "  -S --summary      : Print a summary of the session on exit, to "
+    "the file given as --summary=FILE if any\n"
     "  -h --help         : Print help and exit\n";
 
 static const char versionString[] = "nvtop version " NVTOP_VERSION_STRING;
@@ -94,56 +109,189 @@ static const struct option long_opts[] = {
      .val = 'E'},
     {.name = "no-plot", .has_arg = no_argument, .flag = NULL, .val = 'p'},
     {.name = "reverse-abs", .has_arg = no_argument, .flag = NULL, .val = 'r'},
+    {.name = "grid", .has_arg = no_argument, .flag = NULL, .val = 'g'},
+    {.name = "bandwidth-budget",
+     .has_arg = required_argument,
+     .flag = NULL,
+     .val = 'b'},
+    {.name = "cgroup", .has_arg = required_argument, .flag = NULL, .val = 'G'},
+    {.name = "pid-tree",
+     .has_arg = required_argument,
+     .flag = NULL,
+     .val = 'P'},
+    {.name = "summary", .has_arg = optional_argument, .flag = NULL, .val = 'S'},
     {0, 0, 0, 0},
 };
 
-static const char opts[] = "hvd:s:i:c:CfE:pr";
+static const char opts[] = "hvd:s:i:c:CfE:prgb:G:P:S::";
+
+// Keeps the -s/-i device IDs to a sensible range for the mask allocation
+static const unsigned max_gpu_id = 1u << 16;
+
+// Time given to the drivers before the interface shows placeholder devices
+static const int startup_grace_period_ms = 50;
+static const int initialization_poll_interval_ms = 100;
+
+static unsigned placeholder_devices_count(struct list_head *devices) {
+  unsigned count = 0;
+  struct gpu_info *device;
+  list_for_each_entry(device, devices, list) {
+    if (gpuinfo_is_placeholder_device(device))
+      count++;
+  }
+  return count;
+}
 
-static size_t update_mask_value(const char *str, size_t entry_mask,
-                                bool addTo) {
+// Options given on the command line, applied on top of the configuration file
+struct command_line_options {
+  bool update_interval_option_set;
+  int update_interval_option;
+  bool no_color_option;
+  bool use_fahrenheit_option;
+  bool hide_plot_option;
+  bool reverse_plot_direction_option;
+  bool grid_view_option;
+  bool encode_decode_timer_option_set;
+  double encode_decode_hide_time;
+  bool bandwidth_budget_option_set;
+  unsigned bandwidth_budget_option;
+  char *custom_config_file_path;
+};
+
+static void update_mask_value(const char *str,
+                              struct gpuinfo_device_mask *mask, bool addTo) {
   char *saveptr;
   char *option_copy = malloc((strlen(str) + 1) * sizeof(*option_copy));
   strcpy(option_copy, str);
   char *gpu_num = strtok_r(option_copy, ":", &saveptr);
   while (gpu_num != NULL) {
     char *endptr;
-    unsigned num_used = strtoul(gpu_num, &endptr, 0);
+    unsigned long num_used = strtoul(gpu_num, &endptr, 0);
     if (endptr == gpu_num) {
       fprintf(stderr, "Use GPU IDs (unsigned integer) to select GPU with "
                       "option 's' or 'i'\n");
       exit(EXIT_FAILURE);
     }
-    if (num_used >= CHAR_BIT * sizeof(entry_mask)) {
+    if (num_used >= max_gpu_id) {
       fprintf(stderr,
-              "Select GPU X with option 's' or 'i' where 0 <= X < %zu\n",
-              CHAR_BIT * sizeof(entry_mask));
+              "Select GPU X with option 's' or 'i' where 0 <= X < %u\n",
+              max_gpu_id);
       exit(EXIT_FAILURE);
     }
-    if (addTo)
-      entry_mask |= 1 << num_used;
-    else
-      entry_mask &= ~(1 << num_used);
+    gpuinfo_device_mask_set(mask, (unsigned)num_used, addTo);
     gpu_num = strtok_r(NULL, ":", &saveptr);
   }
   free(option_copy);
-  return entry_mask;
+}
+
+// Loads the configuration for the current devices and applies the command
+// line options
+static void load_interface_options(const struct command_line_options *cli,
+                                   unsigned devices_count,
+                                   nvtop_interface_option *options) {
+  nvtop_interface_option interface_options;
+  alloc_interface_options_internals(cli->custom_config_file_path, devices_count,
+                                    &interface_options);
+  load_interface_options_from_config_file(devices_count, &interface_options);
+  for (unsigned i = 0; i < devices_count; ++i) {
+    // Nothing specified in the file
+    if (!plot_isset_draw_info(plot_information_count,
+                              interface_options.device_information_drawn[i])) {
+      interface_options.device_information_drawn[i] = plot_default_draw_info();
+    } else {
+      interface_options.device_information_drawn[i] =
+          plot_remove_draw_info(plot_information_count,
+                                interface_options.device_information_drawn[i]);
+    }
+  }
+  if (!process_is_field_displayed(process_field_count,
+                                  interface_options.process_fields_displayed)) {
+    interface_options.process_fields_displayed =
+        process_default_displayed_field();
+  } else {
+    interface_options.process_fields_displayed =
+        process_remove_field_to_display(
+            process_field_count, interface_options.process_fields_displayed);
+  }
+  if (cli->no_color_option)
+    interface_options.use_color = false;
+  if (cli->hide_plot_option) {
+    for (unsigned i = 0; i < devices_count; ++i) {
+      interface_options.device_information_drawn[i] = 0;
+    }
+  }
+  if (cli->encode_decode_timer_option_set) {
+    interface_options.encode_decode_hiding_timer = cli->encode_decode_hide_time;
+    if (interface_options.encode_decode_hiding_timer < 0.)
+      interface_options.encode_decode_hiding_timer = 0.;
+  }
+  if (cli->reverse_plot_direction_option)
+    interface_options.plot_left_to_right = true;
+  if (cli->use_fahrenheit_option)
+    interface_options.temperature_in_fahrenheit = true;
+  if (cli->grid_view_option)
+    interface_options.device_grid_view = true;
+  if (cli->update_interval_option_set)
+    interface_options.update_interval = cli->update_interval_option;
+  if (cli->bandwidth_budget_option_set)
+    interface_options.bandwidth_budget = cli->bandwidth_budget_option;
+  *options = interface_options;
+}
+
+// The options of the previous interface are kept when the device count
+// changes; the devices that appeared get the default charts
+static void resize_interface_options(const struct command_line_options *cli,
+                                     unsigned previous_count,
+                                     unsigned devices_count,
+                                     nvtop_interface_option *options) {
+  plot_info_to_draw *drawn = reallocarray(
+      options->device_information_drawn, devices_count ? devices_count : 1,
+      sizeof(*options->device_information_drawn));
+  if (!drawn) {
+    perror("Cannot allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  for (unsigned i = previous_count; i < devices_count; ++i)
+    drawn[i] = cli->hide_plot_option ? 0 : plot_default_draw_info();
+  options->device_information_drawn = drawn;
+}
+
+// Shows the interface for the current devices, with the problem found while
+// starting up if any
+static struct nvtop_interface *
+create_interface(unsigned devices_count, struct list_head *devices,
+                 nvtop_interface_option interface_options,
+                 const char *startup_message) {
+  flight_recorder_set_devices_count(devices_count);
+
+  size_t biggest_name = 0;
+  struct gpu_info *device;
+  list_for_each_entry(device, devices, list) {
+    size_t device_name_size;
+    if (IS_VALID(gpuinfo_device_name_valid, device->static_info.valid))
+      device_name_size = strlen(device->static_info.device_name);
+    else
+      device_name_size = 4;
+    if (device_name_size > biggest_name) {
+      biggest_name = device_name_size;
+    }
+  }
+  struct nvtop_interface *interface =
+      initialize_curses(devices_count, biggest_name, interface_options);
+  timeout(interface_update_interval(interface));
+  if (startup_message[0])
+    interface_show_message(interface, startup_message);
+  return interface;
 }
 
 int main(int argc, char **argv) {
   (void)setlocale(LC_CTYPE, "");
 
   opterr = 0;
-  bool update_interval_option_set = false;
-  int update_interval_option;
   char *selectedGPU = NULL;
   char *ignoredGPU = NULL;
-  bool no_color_option = false;
-  bool use_fahrenheit_option = false;
-  bool hide_plot_option = false;
-  bool reverse_plot_direction_option = false;
-  bool encode_decode_timer_option_set = false;
-  double encode_decode_hide_time = -1.;
-  char *custom_config_file_path = NULL;
+  FILE *summary_output = NULL;
+  struct command_line_options cli = {.encode_decode_hide_time = -1.};
   while (true) {
     int optchar = getopt_long(argc, argv, opts, long_opts, NULL);
     if (optchar == -1)
@@ -161,12 +309,12 @@ int main(int argc, char **argv) {
         fprintf(stderr, "Error: A negative delay requires a time machine!\n");
         exit(EXIT_FAILURE);
       }
-      update_interval_option_set = true;
-      update_interval_option = (int)delay_val * 100u;
-      if (update_interval_option > 99900)
-        update_interval_option = 99900;
-      if (update_interval_option < 100)
-        update_interval_option = 100;
+      cli.update_interval_option_set = true;
+      cli.update_interval_option = (int)delay_val * 100u;
+      if (cli.update_interval_option > 99900)
+        cli.update_interval_option = 99900;
+      if (cli.update_interval_option < 100)
+        cli.update_interval_option = 100;
     } break;
     case 's':
       selectedGPU = optarg;
@@ -181,27 +329,82 @@ int main(int argc, char **argv) {
       printf("%s\n%s", versionString, helpstring);
       exit(EXIT_SUCCESS);
     case 'c':
-      custom_config_file_path = optarg;
+      cli.custom_config_file_path = optarg;
       break;
     case 'C':
-      no_color_option = true;
+      cli.no_color_option = true;
       break;
     case 'f':
-      use_fahrenheit_option = true;
+      cli.use_fahrenheit_option = true;
       break;
     case 'E': {
-      if (sscanf(optarg, "%lf", &encode_decode_hide_time) == EOF) {
+      if (sscanf(optarg, "%lf", &cli.encode_decode_hide_time) == EOF) {
         fprintf(stderr, "Invalid format for encode/decode hide time: %s\n",
                 optarg);
         exit(EXIT_FAILURE);
       }
-      encode_decode_timer_option_set = true;
+      cli.encode_decode_timer_option_set = true;
     } break;
     case 'p':
-      hide_plot_option = true;
+      cli.hide_plot_option = true;
       break;
     case 'r':
-      reverse_plot_direction_option = true;
+      cli.reverse_plot_direction_option = true;
+      break;
+    case 'g':
+      cli.grid_view_option = true;
+      break;
+    case 'b': {
+      char *endptr = NULL;
+      long int budget_val = strtol(optarg, &endptr, 0);
+      if (endptr == optarg || budget_val < 0) {
+        fprintf(stderr, "Error: The bandwidth budget must be a positive value "
+                        "in KiB/s\n");
+        exit(EXIT_FAILURE);
+      }
+      cli.bandwidth_budget_option_set = true;
+      cli.bandwidth_budget_option = (unsigned)budget_val;
+    } break;
+    case 'G':
+      if (process_scope_active()) {
+        fprintf(stderr, "Error: Only one of --cgroup and --pid-tree can be "
+                        "given\n");
+        exit(EXIT_FAILURE);
+      }
+      if (!process_scope_set_cgroup(optarg)) {
+        fprintf(stderr, "Error: %s is not a cgroup v2 directory\n", optarg);
+        exit(EXIT_FAILURE);
+      }
+      break;
+    case 'P': {
+      if (process_scope_active()) {
+        fprintf(stderr, "Error: Only one of --cgroup and --pid-tree can be "
+                        "given\n");
+        exit(EXIT_FAILURE);
+      }
+      char *endptr = NULL;
+      long int root_pid = strtol(optarg, &endptr, 0);
+      if (endptr == optarg || *endptr != '\0' || root_pid <= 0 ||
+          (kill((pid_t)root_pid, 0) != 0 && errno == ESRCH)) {
+        fprintf(stderr, "Error: No process with PID %s\n", optarg);
+        exit(EXIT_FAILURE);
+      }
+      process_scope_set_pid_tree((pid_t)root_pid);
+    } break;
+    case 'S':
+      // Opened right away not to lose the session to a wrong path
+      if (optarg) {
+        if (summary_output && summary_output != stdout)
+          fclose(summary_output);
+        summary_output = fopen(optarg, "w");
+        if (!summary_output) {
+          fprintf(stderr, "Error: Cannot write the session summary to %s: %s\n", optarg, strerror(errno));
+          exit(EXIT_FAILURE);
+        }
+      } else if (!summary_output) {
+        summary_output = stdout;
+      }
+      session_summary_enable();
       break;
     case ':':
     case '?':
@@ -240,113 +443,146 @@ int main(int argc, char **argv) {
     exit(EXIT_FAILURE);
   }
 
-  ssize_t gpu_mask;
+  struct gpuinfo_device_mask gpu_mask;
+  gpuinfo_device_mask_init(&gpu_mask, selectedGPU == NULL);
   if (selectedGPU != NULL) {
-    gpu_mask = 0;
-    gpu_mask = update_mask_value(selectedGPU, gpu_mask, true);
-  } else {
-    gpu_mask = UINT_MAX;
+    update_mask_value(selectedGPU, &gpu_mask, true);
   }
   if (ignoredGPU != NULL) {
-    gpu_mask = update_mask_value(ignoredGPU, gpu_mask, false);
+    update_mask_value(ignoredGPU, &gpu_mask, false);
   }
 
+  // Give the drivers a moment to answer before showing placeholders
   unsigned devices_count = 0;
   LIST_HEAD(devices);
-  if (!gpuinfo_init_info_extraction(gpu_mask, &devices_count, &devices))
-    return EXIT_FAILURE;
-  if (devices_count == 0) {
-    fprintf(stdout, "No GPU to monitor.\n");
-    return EXIT_SUCCESS;
-  }
-
-  nvtop_interface_option interface_options;
-  alloc_interface_options_internals(custom_config_file_path, devices_count,
-                                    &interface_options);
-  load_interface_options_from_config_file(devices_count, &interface_options);
-  for (unsigned i = 0; i < devices_count; ++i) {
-    // Nothing specified in the file
-    if (!plot_isset_draw_info(plot_information_count,
-                              interface_options.device_information_drawn[i])) {
-      interface_options.device_information_drawn[i] = plot_default_draw_info();
-    } else {
-      interface_options.device_information_drawn[i] =
-          plot_remove_draw_info(plot_information_count,
-                                interface_options.device_information_drawn[i]);
+  gpuinfo_init_info_extraction_start(&gpu_mask);
+  bool init_done = gpuinfo_init_info_extraction_collect(
+      startup_grace_period_ms, &devices_count, &devices);
+  char topology_key[512];
+  snprintf(topology_key, sizeof(topology_key), "select=%s ignore=%s",
+           selectedGPU ? selectedGPU : "", ignoredGPU ? ignoredGPU : "");
+  if (!init_done) {
+    unsigned cached_count;
+    char **cached_names;
+    if (device_topology_cache_load(topology_key, &cached_count,
+                                   &cached_names)) {
+      if (cached_count > devices_count)
+        gpuinfo_add_placeholder_devices(cached_count - devices_count,
+                                        cached_names + devices_count, &devices);
+      device_topology_cache_free_names(cached_count, cached_names);
+    } else if (devices_count == 0) {
+      char *waiting_name[] = {"Waiting for the GPU drivers"};
+      gpuinfo_add_placeholder_devices(1, waiting_name, &devices);
     }
+    init_done = gpuinfo_init_info_extraction_collect(0, &devices_count, &devices);
   }
-  if (!process_is_field_displayed(process_field_count,
-                                  interface_options.process_fields_displayed)) {
-    interface_options.process_fields_displayed =
-        process_default_displayed_field();
-  } else {
-    interface_options.process_fields_displayed =
-        process_remove_field_to_display(
-            process_field_count, interface_options.process_fields_displayed);
-  }
-  if (no_color_option)
-    interface_options.use_color = false;
-  if (hide_plot_option) {
-    for (unsigned i = 0; i < devices_count; ++i) {
-      interface_options.device_information_drawn[i] = 0;
+  if (init_done) {
+    gpuinfo_device_mask_free(&gpu_mask);
+    if (devices_count == 0) {
+      fprintf(stdout, "No GPU to monitor.\n");
+      gpuinfo_shutdown_info_extraction(&devices);
+      return EXIT_SUCCESS;
     }
+    device_topology_cache_save(topology_key, &devices);
   }
-  if (encode_decode_timer_option_set) {
-    interface_options.encode_decode_hiding_timer = encode_decode_hide_time;
-    if (interface_options.encode_decode_hiding_timer < 0.)
-      interface_options.encode_decode_hiding_timer = 0.;
-  }
-  if (reverse_plot_direction_option)
-    interface_options.plot_left_to_right = true;
-  if (use_fahrenheit_option)
-    interface_options.temperature_in_fahrenheit = true;
-  if (update_interval_option_set)
-    interface_options.update_interval = update_interval_option;
-
-  gpuinfo_populate_static_infos(&devices);
 
-  size_t biggest_name = 0;
-  struct gpu_info *device;
-  list_for_each_entry(device, &devices, list) {
-    size_t device_name_size;
-    if (IS_VALID(gpuinfo_device_name_valid, device->static_info.valid))
-      device_name_size = strlen(device->static_info.device_name);
-    else
-      device_name_size = 4;
-    if (device_name_size > biggest_name) {
-      biggest_name = device_name_size;
-    }
-  }
-  struct nvtop_interface *interface =
-      initialize_curses(devices_count, biggest_name, interface_options);
-  timeout(interface_update_interval(interface));
+  nvtop_interface_option interface_options;
+  load_interface_options(&cli, devices_count, &interface_options);
+  char startup_message[128] = "";
+  const char *recorder_error;
+  if (!flight_recorder_configure(interface_options.flight_recorder_triggers,
+                                 interface_options.flight_recorder_trace_file,
+                                 interface_options.flight_recorder_seconds,
+                                 &recorder_error))
+    snprintf(startup_message, sizeof(startup_message),
+             "Flight recorder disabled: %s in \"%s\"", recorder_error,
+             interface_options.flight_recorder_triggers);
+  struct nvtop_interface *interface = create_interface(
+      devices_count, &devices, interface_options, startup_message);
 
   double time_slept = interface_update_interval(interface);
+  double recorder_slept = 0.;
   while (!signal_exit) {
+    if (!init_done) {
+      unsigned previous_count = devices_count;
+      unsigned previous_placeholders = placeholder_devices_count(&devices);
+      init_done =
+          gpuinfo_init_info_extraction_collect(0, &devices_count, &devices);
+      if (init_done) {
+        gpuinfo_device_mask_free(&gpu_mask);
+        if (devices_count == 0) {
+          clean_ncurses(interface);
+          fprintf(stdout, "No GPU to monitor.\n");
+          gpuinfo_shutdown_info_extraction(&devices);
+          return EXIT_SUCCESS;
+        }
+        device_topology_cache_save(topology_key, &devices);
+      }
+      // Lay the interface out again for the new devices
+      if (devices_count != previous_count ||
+          placeholder_devices_count(&devices) != previous_placeholders) {
+        clean_ncurses_keep_options(interface, &interface_options);
+        resize_interface_options(&cli, previous_count, devices_count,
+                                 &interface_options);
+        interface = create_interface(devices_count, &devices,
+                                     interface_options, startup_message);
+        clearok(curscr, TRUE);
+        time_slept = interface_update_interval(interface);
+      }
+    }
     if (signal_resize_win) {
       signal_resize_win = 0;
       update_window_size_to_terminal_size(interface);
     }
-    if (time_slept >= interface_update_interval(interface)) {
+    int update_interval = interface_update_interval(interface);
+    if (time_slept >= update_interval) {
       gpuinfo_refresh_dynamic_info(&devices);
       if (!interface_freeze_processes(interface)) {
         gpuinfo_refresh_processes(&devices);
         gpuinfo_fix_dynamic_info_from_process_info(&devices);
       }
       save_current_data_to_ring(&devices, interface);
-      timeout(interface_update_interval(interface));
+      session_summary_record_devices(&devices);
+      flight_recorder_tick(&devices);
       time_slept = 0.;
-    } else {
-      int next_sleep = interface_update_interval(interface) - (int)time_slept;
-      timeout(next_sleep);
+      recorder_slept = 0.;
+    } else if (flight_recorder_capturing() &&
+               recorder_slept >= FLIGHT_RECORDER_BURST_INTERVAL) {
+      // Only the recorder samples at the burst rate, the charts and the
+      // process list keep their pace
+      gpuinfo_sample_dynamic_info(&devices);
+      if (!interface_freeze_processes(interface))
+        gpuinfo_fix_dynamic_info_from_process_info(&devices);
+      flight_recorder_tick(&devices);
+      recorder_slept = 0.;
     }
+    int wait_ms = update_interval - (int)time_slept;
+    if (flight_recorder_capturing() &&
+        FLIGHT_RECORDER_BURST_INTERVAL - (int)recorder_slept < wait_ms)
+      wait_ms = FLIGHT_RECORDER_BURST_INTERVAL - (int)recorder_slept;
+    // Check on the drivers more often while they are initializing
+    if (!init_done)
+      wait_ms = initialization_poll_interval_ms;
     draw_gpu_info_ncurses(devices_count, &devices, interface);
 
     nvtop_time time_before_sleep, time_after_sleep;
     nvtop_get_current_time(&time_before_sleep);
-    int input_char = getch();
+    int input_char = ERR;
+    // Wake up as soon as a GPU process exits to drop it from the list
+    if (!interface_freeze_processes(interface) && gpuinfo_process_exits_watched()) {
+      // Polling the terminal misses the keys ncurses already buffered
+      timeout(0);
+      input_char = getch();
+      if (input_char == ERR && !gpuinfo_wait_process_exits(&devices, STDIN_FILENO, wait_ms))
+        input_char = getch();
+    } else {
+      timeout(wait_ms);
+      input_char = getch();
+    }
     nvtop_get_current_time(&time_after_sleep);
-    time_slept += nvtop_difftime(time_before_sleep, time_after_sleep) * 1000;
+    double slept = nvtop_difftime(time_before_sleep, time_after_sleep) * 1000;
+    time_slept += slept;
+    recorder_slept += slept;
     switch (input_char) {
     case 27: // ESC
     {
@@ -369,7 +605,10 @@ int main(int argc, char **argv) {
       break;
     case KEY_F(2):
     case KEY_F(9):
+    case KEY_F(5):
     case KEY_F(6):
+    case KEY_F(7):
+    case KEY_F(8):
     case KEY_F(12):
     case '+':
     case '-':
@@ -390,7 +629,16 @@ int main(int argc, char **argv) {
   }
 
   clean_ncurses(interface);
+  flight_recorder_clear();
+  if (summary_output) {
+    session_summary_report(summary_output);
+    if (summary_output != stdout)
+      fclose(summary_output);
+  }
+  tuning_clear();
   gpuinfo_shutdown_info_extraction(&devices);
+  if (!init_done)
+    gpuinfo_device_mask_free(&gpu_mask);
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,126 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/process_actions.h"
+#include "nvtop/get_process_info.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_BE 2
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_BE_DEFAULT_LEVEL 4
+
+static_assert(CPU_MASK_MAX_ID <= CPU_SETSIZE, "A CPU mask must fit in a cpu_set_t");
+
+enum thread_setting {
+  thread_setting_nice,
+  thread_setting_io_priority,
+  thread_setting_affinity,
+};
+
+struct thread_setting_value {
+  int nice_increment;
+  int io_priority;
+  cpu_set_t *cpus;
+};
+
+static int apply_to_thread(pid_t tid, enum thread_setting setting, const struct thread_setting_value *value) {
+  int retval = 0;
+  switch (setting) {
+  case thread_setting_nice: {
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, (id_t)tid);
+    if (nice == -1 && errno)
+      return errno;
+    nice += value->nice_increment;
+    if (nice < -20)
+      nice = -20;
+    if (nice > 19)
+      nice = 19;
+    retval = setpriority(PRIO_PROCESS, (id_t)tid, nice);
+  } break;
+  case thread_setting_io_priority:
+    retval = (int)syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, value->io_priority);
+    break;
+  case thread_setting_affinity:
+    retval = sched_setaffinity(tid, sizeof(*value->cpus), value->cpus);
+    break;
+  }
+  return retval ? errno : 0;
+}
+
+static int apply_to_threads(pid_t pid, enum thread_setting setting, const struct thread_setting_value *value) {
+  unsigned count = 0, capacity = 0;
+  pid_t *tids = NULL;
+  if (!get_process_thread_ids(pid, &count, &capacity, &tids))
+    return ESRCH;
+  int first_error = 0;
+  for (unsigned i = 0; i < count; ++i) {
+    int error = apply_to_thread(tids[i], setting, value);
+    // Threads exiting in the meantime are not a failure
+    if (error && error != ESRCH && !first_error)
+      first_error = error;
+  }
+  free(tids);
+  return first_error;
+}
+
+int process_renice(pid_t pid, int increment) {
+  struct thread_setting_value value = {.nice_increment = increment};
+  return apply_to_threads(pid, thread_setting_nice, &value);
+}
+
+int process_set_io_class(pid_t pid, enum process_io_class io_class) {
+  struct thread_setting_value value;
+  if (io_class == process_io_idle)
+    value.io_priority = IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT;
+  else
+    value.io_priority = IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT | IOPRIO_BE_DEFAULT_LEVEL;
+  return apply_to_threads(pid, thread_setting_io_priority, &value);
+}
+
+int process_set_affinity(pid_t pid, const struct cpu_mask *cpus) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (cpus) {
+    for (unsigned id = 0; id < CPU_MASK_MAX_ID; ++id) {
+      if (cpu_mask_is_set(cpus, id))
+        CPU_SET(id, &cpu_set);
+    }
+  } else {
+    long configured = sysconf(_SC_NPROCESSORS_CONF);
+    for (long id = 0; id < configured && id < CPU_SETSIZE; ++id)
+      CPU_SET(id, &cpu_set);
+  }
+  if (!CPU_COUNT(&cpu_set))
+    return EINVAL;
+  struct thread_setting_value value = {.cpus = &cpu_set};
+  return apply_to_threads(pid, thread_setting_affinity, &value);
+}
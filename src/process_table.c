@@ -0,0 +1,198 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "nvtop/process_table.h"
+#include "nvtop/common.h"
+#include "uthash.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct gpuinfo_interned_string {
+  char *value;
+  unsigned id;
+  unsigned generation; // Last fill referencing this string
+  UT_hash_handle hh;
+};
+
+// Unreferenced strings are released once they outnumber the live ones
+static const unsigned string_pool_sweep_slack = 64;
+
+static_assert(gpuinfo_process_info_count <= 64, "The process validity bitset is stored in 64 bits");
+
+void gpuinfo_process_table_init(struct gpuinfo_process_table *table) { memset(table, 0, sizeof(*table)); }
+
+static void string_pool_release(struct gpuinfo_string_pool *pool, struct gpuinfo_interned_string *entry) {
+  HASH_DEL(pool->lookup, entry);
+  pool->entries[entry->id] = NULL;
+  pool->free_ids[pool->free_count++] = entry->id;
+  free(entry->value);
+  free(entry);
+}
+
+void gpuinfo_process_table_free(struct gpuinfo_process_table *table) {
+#define FREE_COLUMN(type, name) free(table->name);
+  GPUINFO_PROCESS_TABLE_COLUMNS(FREE_COLUMN)
+#undef FREE_COLUMN
+  struct gpuinfo_interned_string *entry, *tmp;
+  HASH_ITER(hh, table->strings.lookup, entry, tmp) { string_pool_release(&table->strings, entry); }
+  free(table->strings.entries);
+  free(table->strings.free_ids);
+  memset(table, 0, sizeof(*table));
+}
+
+static unsigned string_pool_intern(struct gpuinfo_string_pool *pool, const char *value) {
+  struct gpuinfo_interned_string *entry;
+  HASH_FIND_STR(pool->lookup, value, entry);
+  if (!entry) {
+    if (!pool->free_count && pool->entries_count == pool->entries_capacity) {
+      unsigned capacity = pool->entries_capacity ? 2 * pool->entries_capacity : COMMON_PROCESS_LINEAR_REALLOC_INC;
+      struct gpuinfo_interned_string **entries = reallocarray(pool->entries, capacity, sizeof(*entries));
+      unsigned *free_ids = reallocarray(pool->free_ids, capacity, sizeof(*free_ids));
+      if (!entries || !free_ids) {
+        perror("Could not allocate memory: ");
+        exit(EXIT_FAILURE);
+      }
+      pool->entries = entries;
+      pool->free_ids = free_ids;
+      pool->entries_capacity = capacity;
+    }
+    entry = malloc(sizeof(*entry));
+    if (!entry || !(entry->value = strdup(value))) {
+      perror("Could not allocate memory: ");
+      exit(EXIT_FAILURE);
+    }
+    entry->id = pool->free_count ? pool->free_ids[--pool->free_count] : pool->entries_count++;
+    entry->generation = pool->generation - 1;
+    pool->entries[entry->id] = entry;
+    HASH_ADD_KEYPTR(hh, pool->lookup, entry->value, strlen(entry->value), entry);
+  }
+  if (entry->generation != pool->generation) {
+    entry->generation = pool->generation;
+    pool->live_count++;
+  }
+  return entry->id;
+}
+
+static void string_pool_sweep(struct gpuinfo_string_pool *pool) {
+  unsigned allocated = pool->entries_count - pool->free_count;
+  if (allocated <= 2 * pool->live_count + string_pool_sweep_slack)
+    return;
+  struct gpuinfo_interned_string *entry, *tmp;
+  HASH_ITER(hh, pool->lookup, entry, tmp) {
+    if (entry->generation != pool->generation)
+      string_pool_release(pool, entry);
+  }
+}
+
+static void *grow_column(void *column, unsigned capacity, size_t element_size) {
+  void *grown = reallocarray(column, capacity, element_size);
+  if (!grown) {
+    perror("Could not allocate memory: ");
+    exit(EXIT_FAILURE);
+  }
+  return grown;
+}
+
+static void process_table_reserve(struct gpuinfo_process_table *table, unsigned count) {
+  if (count <= table->capacity)
+    return;
+  unsigned capacity = table->capacity ? 2 * table->capacity : COMMON_PROCESS_LINEAR_REALLOC_INC;
+  if (capacity < count)
+    capacity = count;
+#define GROW_COLUMN(type, name) table->name = grow_column(table->name, capacity, sizeof(*table->name));
+  GPUINFO_PROCESS_TABLE_COLUMNS(GROW_COLUMN)
+#undef GROW_COLUMN
+  table->capacity = capacity;
+}
+
+// The strings of the previous fill, derived columns included, are all interned
+// by now and the ones it did not reference can go
+void gpuinfo_process_table_fill(struct gpuinfo_process_table *table, struct list_head *devices) {
+  unsigned total_processes_count = 0;
+  struct gpu_info *device;
+  list_for_each_entry(device, devices, list) { total_processes_count += device->processes_count; }
+  process_table_reserve(table, total_processes_count);
+
+  string_pool_sweep(&table->strings);
+  table->strings.generation++;
+  table->strings.live_count = 0;
+  unsigned row = 0, dev_id = 0;
+  list_for_each_entry(device, devices, list) {
+    for (unsigned i = 0; i < device->processes_count; ++i, ++row) {
+      const struct gpu_process *process = &device->processes[i];
+      uint64_t valid = 0;
+      for (unsigned field = 0; field < gpuinfo_process_info_count; ++field) {
+        if (IS_VALID(field, process->valid))
+          valid |= UINT64_C(1) << field;
+      }
+      table->valid[row] = valid;
+      table->pid[row] = process->pid;
+      table->gpu_id[row] = dev_id;
+      table->type[row] = process->type;
+      table->cmdline[row] =
+          GPUINFO_PROCESS_FIELD_VALID(process, cmdline) ? string_pool_intern(&table->strings, process->cmdline) : 0;
+      table->user_name[row] = GPUINFO_PROCESS_FIELD_VALID(process, user_name)
+                                  ? string_pool_intern(&table->strings, process->user_name)
+                                  : 0;
+      table->gfx_engine_used[row] = process->gfx_engine_used;
+      table->compute_engine_used[row] = process->compute_engine_used;
+      table->gpu_usage[row] = process->gpu_usage;
+      table->encode_usage[row] = process->encode_usage;
+      table->decode_usage[row] = process->decode_usage;
+      table->gpu_memory_usage[row] = process->gpu_memory_usage;
+      table->gpu_memory_percentage[row] = process->gpu_memory_percentage;
+      table->cpu_usage[row] = process->cpu_usage;
+      table->cpu_memory_virt[row] = process->cpu_memory_virt;
+      table->cpu_memory_res[row] = process->cpu_memory_res;
+      table->memory_bandwidth_usage[row] = process->memory_bandwidth_usage;
+    }
+    dev_id++;
+  }
+  table->count = row;
+}
+
+void gpuinfo_process_table_remove_pid(struct gpuinfo_process_table *table, pid_t pid) {
+  unsigned kept = 0;
+  for (unsigned row = 0; row < table->count; ++row) {
+    if (table->pid[row] == pid)
+      continue;
+    if (kept != row) {
+      // The invalid cells are never written, hence copied bytewise
+#define MOVE_ROW(type, name) memcpy(&table->name[kept], &table->name[row], sizeof(*table->name));
+      GPUINFO_PROCESS_TABLE_COLUMNS(MOVE_ROW)
+#undef MOVE_ROW
+    }
+    kept++;
+  }
+  table->count = kept;
+}
+
+unsigned gpuinfo_process_table_intern(struct gpuinfo_process_table *table, const char *value) {
+  return string_pool_intern(&table->strings, value);
+}
+
+const char *gpuinfo_process_table_string(const struct gpuinfo_process_table *table, unsigned string_id) {
+  assert(string_id < table->strings.entries_count && table->strings.entries[string_id]);
+  return table->strings.entries[string_id]->value;
+}
@@ -0,0 +1,53 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/stranded.h"
+
+static const uint64_t stranded_grace_period = GPUINFO_STRANDED_GRACE_PERIOD * UINT64_C(1000000000);
+
+bool gpuinfo_stranded_duration(const struct gpuinfo_stranded *stranded, double *seconds) {
+  if (!stranded->idle || stranded->last_update - stranded->since < stranded_grace_period)
+    return false;
+  *seconds = (stranded->last_update - stranded->since) / 1e9;
+  return true;
+}
+
+void gpuinfo_stranded_update(struct gpuinfo_stranded *stranded, bool idle, uint64_t now, double energy) {
+  if (!idle) {
+    stranded->idle = false;
+  } else if (!stranded->idle) {
+    stranded->idle = true;
+    stranded->since = now;
+    stranded->period_energy = 0.;
+  } else {
+    stranded->period_energy += energy;
+    if (now - stranded->since >= stranded_grace_period) {
+      uint64_t counted_until = stranded->last_update - stranded->since >= stranded_grace_period
+                                   ? stranded->last_update
+                                   : stranded->since;
+      stranded->time += (now - counted_until) / 1e9;
+      stranded->energy += stranded->period_energy;
+      stranded->period_energy = 0.;
+    }
+  }
+  stranded->last_update = now;
+}
@@ -0,0 +1,44 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "nvtop/sysfs.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+bool sysfs_read_line(int dirfd, const char *name, char *line, size_t size) {
+  int fd = openat(dirfd, name, O_RDONLY);
+  if (fd < 0)
+    return false;
+  FILE *file = fdopen(fd, "r");
+  if (!file) {
+    close(fd);
+    return false;
+  }
+  bool success = fgets(line, (int)size, file) != NULL;
+  fclose(file);
+  if (success)
+    line[strcspn(line, "\n")] = '\0';
+  return success;
+}
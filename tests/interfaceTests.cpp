@@ -20,13 +20,20 @@
  */
 
 #include <algorithm>
+#include <fcntl.h>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <unistd.h>
 #include <vector>
 
 extern "C" {
+#include "nvtop/device_tuning.h"
 #include "nvtop/interface.h"
 #include "nvtop/interface_layout_selection.h"
+#include "nvtop/stranded.h"
 }
 
 static std::ostream &operator<<(std::ostream &os, const struct window_position &win) {
@@ -34,6 +41,10 @@ static std::ostream &operator<<(std::ostream &os, const struct window_position &
   return os;
 }
 
+static bool operator==(const struct window_position &w1, const struct window_position &w2) {
+  return w1.posX == w2.posX && w1.posY == w2.posY && w1.sizeX == w2.sizeX && w1.sizeY == w2.sizeY;
+}
+
 namespace {
 
 // Returns true if the two windows overlap, false otherwise.
@@ -200,6 +211,380 @@ TEST(InterfaceLayout, FixInfiniteLoop) {
 
 TEST(InterfaceLayout, LayoutSelection_test_fail_case1) { test_with_terminal_size(32, 3, 55, 16, 1760); }
 
+TEST(InterfaceLayout, MemoizedLayoutMatchesSolver) {
+  unsigned device_count = 6, header_rows = 3, header_cols = 55, rows = 60, cols = 200;
+  std::vector<plot_info_to_draw> plot_display(device_count, plot_default_draw_info());
+  process_field_displayed proc_display = process_default_displayed_field();
+
+  unsigned num_plots[2];
+  std::vector<struct window_position> dev_positions[2], plot_positions[2];
+  struct window_position process_position[2], setup_position[2];
+  std::vector<unsigned> map_dev_to_plot[2];
+  for (unsigned i = 0; i < 2; ++i) {
+    dev_positions[i].resize(device_count);
+    plot_positions[i].resize(MAX_CHARTS);
+    map_dev_to_plot[i].resize(device_count);
+    // First call solves and memoizes, second call hits the cache
+    compute_sizes_from_layout(device_count, header_rows, header_cols, rows, cols, plot_display.data(), proc_display,
+                              dev_positions[i].data(), &num_plots[i], plot_positions[i].data(),
+                              map_dev_to_plot[i].data(), &process_position[i], &setup_position[i]);
+  }
+  layout_selection_clear_cache();
+
+  ASSERT_EQ(num_plots[0], num_plots[1]);
+  EXPECT_EQ(map_dev_to_plot[0], map_dev_to_plot[1]);
+  for (unsigned i = 0; i < device_count; ++i)
+    EXPECT_EQ(dev_positions[0][i], dev_positions[1][i]) << "Device " << i;
+  for (unsigned i = 0; i < num_plots[0]; ++i)
+    EXPECT_EQ(plot_positions[0][i], plot_positions[1][i]) << "Plot " << i;
+  EXPECT_EQ(process_position[0], process_position[1]);
+  EXPECT_EQ(setup_position[0], setup_position[1]);
+}
+
+namespace {
+
+struct expected_layout {
+  std::vector<struct window_position> devices;
+  std::vector<unsigned> map_device_to_plot;
+  std::vector<struct window_position> plots;
+  struct window_position process;
+  struct window_position setup;
+};
+
+// Solve a layout (bypassing the cache) and compare it to the expected one
+void check_expected_layout(unsigned header_rows, unsigned header_cols, unsigned rows, unsigned cols,
+                           const expected_layout &expected) {
+  unsigned device_count = expected.devices.size();
+  std::vector<plot_info_to_draw> plot_display(device_count, plot_default_draw_info());
+  process_field_displayed proc_display = process_default_displayed_field();
+
+  unsigned num_plots = 0;
+  std::vector<struct window_position> dev_positions(device_count);
+  std::vector<struct window_position> plot_positions(MAX_CHARTS);
+  struct window_position process_position, setup_position;
+  std::vector<unsigned> map_dev_to_plot(device_count);
+  layout_selection_clear_cache();
+  compute_sizes_from_layout(device_count, header_rows, header_cols, rows, cols, plot_display.data(), proc_display,
+                            dev_positions.data(), &num_plots, plot_positions.data(), map_dev_to_plot.data(),
+                            &process_position, &setup_position);
+  plot_positions.resize(num_plots);
+
+  for (unsigned i = 0; i < device_count; ++i)
+    EXPECT_EQ(dev_positions[i], expected.devices[i]) << "Device " << i;
+  EXPECT_EQ(map_dev_to_plot, expected.map_device_to_plot);
+  ASSERT_EQ(num_plots, expected.plots.size());
+  for (unsigned i = 0; i < num_plots; ++i)
+    EXPECT_EQ(plot_positions[i], expected.plots[i]) << "Plot " << i;
+  EXPECT_EQ(process_position, expected.process);
+  EXPECT_EQ(setup_position, expected.setup);
+}
+
+} // namespace
+
+// The expected layouts below were produced by the greedy stack balancing that
+// the dynamic program replaced; both agree on these configurations.
+
+TEST(InterfaceLayout, ExpectedLayout_issue_147) {
+  check_expected_layout(3, 78, 26, 189,
+                        {.devices = {{1, 0, 78, 3},
+                                     {80, 0, 78, 3},
+                                     {1, 3, 78, 3},
+                                     {80, 3, 78, 3},
+                                     {1, 6, 78, 3},
+                                     {80, 6, 78, 3},
+                                     {1, 9, 78, 3},
+                                     {80, 9, 78, 3}},
+                         .map_device_to_plot = {0, 1, 2, 2, 3, 3, 4, 4},
+                         .plots = {{0, 12, 25, 7}, {25, 12, 25, 7}, {50, 12, 45, 7}, {96, 12, 45, 7}, {142, 12, 45, 7}},
+                         .process = {0, 19, 189, 7},
+                         .setup = {0, 12, 189, 14}});
+}
+
+TEST(InterfaceLayout, ExpectedLayout_test_fail_case1) {
+  expected_layout expected;
+  for (unsigned i = 0; i < 32; ++i) {
+    expected.devices.push_back({55 * i, 0, 55, 3});
+    expected.map_device_to_plot.push_back(i);
+    expected.plots.push_back({55 * i, 3, 55, 7});
+  }
+  expected.process = {0, 10, 1760, 6};
+  expected.setup = {0, 3, 1760, 13};
+  check_expected_layout(3, 55, 16, 1760, expected);
+}
+
+TEST(InterfaceLayout, ExpectedLayout_six_devices) {
+  check_expected_layout(3, 55, 60, 200,
+                        {.devices = {{1, 0, 55, 3},
+                                     {57, 0, 55, 3},
+                                     {113, 0, 55, 3},
+                                     {1, 4, 55, 3},
+                                     {57, 4, 55, 3},
+                                     {113, 4, 55, 3}},
+                         .map_device_to_plot = {0, 1, 2, 3, 4, 5},
+                         .plots = {{0, 7, 99, 12},
+                                   {100, 7, 99, 12},
+                                   {0, 19, 99, 12},
+                                   {100, 19, 99, 12},
+                                   {0, 31, 99, 12},
+                                   {100, 31, 99, 12}},
+                         .process = {0, 43, 200, 17},
+                         .setup = {0, 7, 200, 53}});
+}
+
+// Four charts on three stacks: the greedy balancing put the two narrow charts
+// on the last stack, the dynamic program puts them on the first one. The
+// widest stack holds two charts either way.
+TEST(InterfaceLayout, ExpectedLayout_four_devices_three_stacks) {
+  check_expected_layout(3, 55, 50, 230,
+                        {.devices = {{1, 0, 55, 3}, {57, 0, 55, 3}, {113, 0, 55, 3}, {169, 0, 55, 3}},
+                         .map_device_to_plot = {0, 1, 2, 3},
+                         .plots = {{0, 3, 115, 11}, {115, 3, 115, 11}, {0, 14, 229, 11}, {0, 25, 229, 11}},
+                         .process = {0, 36, 230, 14},
+                         .setup = {0, 3, 230, 47}});
+}
+
+namespace {
+
+std::string read_file(const std::string &path) {
+  std::ifstream file(path);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+int stub_power_limit = 212500;
+bool stub_get_called;
+
+void stub_get_tuning(struct gpu_info *, struct gpuinfo_tuning *tuning) {
+  struct gpuinfo_tuning_knob *knob = &tuning->knobs[gpuinfo_tuning_power_limit];
+  knob->available = true;
+  knob->value = stub_power_limit;
+  knob->minimum = 100000;
+  knob->maximum = 300000;
+  knob->step = 5000;
+  stub_get_called = true;
+}
+
+bool stub_set_tuning(struct gpu_info *, enum gpuinfo_tuning_knob_id knob, int value) {
+  if (knob != gpuinfo_tuning_power_limit || value < 100000 || value > 300000)
+    return false;
+  stub_power_limit = value;
+  return true;
+}
+
+const char *stub_last_error_string(void) { return "out of range"; }
+
+int stub_sysfs_dirfd = -1;
+
+void stub_sysfs_get_tuning(struct gpu_info *, struct gpuinfo_tuning *tuning) {
+  tuning_read_amdgpu_sysfs(stub_sysfs_dirfd, tuning);
+}
+
+bool stub_sysfs_set_tuning(struct gpu_info *, enum gpuinfo_tuning_knob_id knob, int value) {
+  return tuning_write_amdgpu_sysfs(stub_sysfs_dirfd, knob, value);
+}
+
+void write_amdgpu_power_profiles(const std::string &dir) {
+  std::ofstream(dir + "/pp_power_profile_mode") << "PROFILE_INDEX(NAME) CLOCK_TYPE(NAME) FPS MinActiveFreq\n"
+                                                  << " 0 BOOTUP_DEFAULT :\n"
+                                                  << "                    0(       GFXCLK)       0       5\n"
+                                                  << " 1 3D_FULL_SCREEN*:\n"
+                                                  << "                    0(       GFXCLK)       1       5\n"
+                                                  << " 5 COMPUTE        :\n"
+                                                  << " 6 CUSTOM         :\n";
+}
+
+} // namespace
+
+TEST(DeviceTuning, AmdgpuSysfsKnobs) {
+  char sysfs[] = "/tmp/nvtopTestSysfsXXXXXX";
+  ASSERT_NE(mkdtemp(sysfs), nullptr);
+  std::string dir(sysfs);
+  write_amdgpu_power_profiles(dir);
+  std::ofstream(dir + "/power_dpm_force_performance_level") << "auto\n";
+  int dirfd = open(sysfs, O_RDONLY | O_DIRECTORY);
+  ASSERT_GE(dirfd, 0);
+
+  struct gpuinfo_tuning tuning = {};
+  tuning_read_amdgpu_sysfs(dirfd, &tuning);
+  const struct gpuinfo_tuning_knob &profile = tuning.knobs[gpuinfo_tuning_power_profile];
+  ASSERT_TRUE(profile.available);
+  EXPECT_EQ(profile.value, 1);
+  ASSERT_EQ(profile.choices_count, 3u);
+  EXPECT_STREQ(profile.choice_names[2], "COMPUTE");
+  EXPECT_EQ(tuning_knob_step(&profile, profile.value, true), 5);
+  const struct gpuinfo_tuning_knob &level = tuning.knobs[gpuinfo_tuning_performance_level];
+  ASSERT_TRUE(level.available);
+  EXPECT_STREQ(level.choice_names[level.value], "auto");
+
+  EXPECT_TRUE(tuning_write_amdgpu_sysfs(dirfd, gpuinfo_tuning_power_profile, 5));
+  EXPECT_EQ(read_file(dir + "/pp_power_profile_mode"), "5\n");
+  EXPECT_TRUE(tuning_write_amdgpu_sysfs(dirfd, gpuinfo_tuning_performance_level, 2));
+  EXPECT_EQ(read_file(dir + "/power_dpm_force_performance_level"), "high\n");
+  EXPECT_FALSE(tuning_write_amdgpu_sysfs(dirfd, gpuinfo_tuning_power_limit, 100));
+
+  close(dirfd);
+  unlink((dir + "/pp_power_profile_mode").c_str());
+  unlink((dir + "/power_dpm_force_performance_level").c_str());
+  rmdir(sysfs);
+}
+
+TEST(DeviceTuning, JournalUndoesChanges) {
+  char state[] = "/tmp/nvtopTestStateXXXXXX";
+  ASSERT_NE(mkdtemp(state), nullptr);
+  setenv("XDG_STATE_HOME", state, 1);
+
+  struct gpu_vendor vendor = {};
+  vendor.last_error_string = stub_last_error_string;
+  vendor.get_tuning = stub_get_tuning;
+  vendor.set_tuning = stub_set_tuning;
+  struct gpu_info device = {};
+  device.vendor = &vendor;
+
+  const char *error = nullptr;
+  struct gpuinfo_tuning tuning;
+  tuning_read(&device, &tuning);
+  const struct gpuinfo_tuning_knob &limit = tuning.knobs[gpuinfo_tuning_power_limit];
+  EXPECT_EQ(tuning_knob_step(&limit, limit.value, false), 210000);
+  EXPECT_EQ(tuning_knob_step(&limit, limit.value, true), 215000);
+  EXPECT_EQ(tuning_knob_step(&limit, 210000, false), 205000);
+  EXPECT_EQ(tuning_knob_step(&limit, 298000, true), 300000);
+
+  EXPECT_TRUE(tuning_apply(&device, 0, gpuinfo_tuning_power_limit, 200000, &error));
+  EXPECT_TRUE(tuning_apply(&device, 0, gpuinfo_tuning_power_limit, 180000, &error));
+  EXPECT_FALSE(tuning_apply(&device, 0, gpuinfo_tuning_power_limit, 500000, &error));
+  EXPECT_STREQ(error, "out of range");
+  EXPECT_FALSE(tuning_apply(&device, 0, gpuinfo_tuning_locked_gpu_clock, 1500, &error));
+  EXPECT_EQ(tuning_changes_count(), 2u);
+  EXPECT_EQ(stub_power_limit, 180000);
+
+  // The limit in place before is restored to the milliwatt
+  EXPECT_TRUE(tuning_undo(&error));
+  EXPECT_EQ(stub_power_limit, 200000);
+  EXPECT_TRUE(tuning_undo(&error));
+  EXPECT_EQ(stub_power_limit, 212500);
+  EXPECT_FALSE(tuning_undo(&error));
+  tuning_clear();
+
+  std::string log_path = std::string(state) + "/nvtop/tuning.log";
+  std::string log = read_file(log_path);
+  EXPECT_EQ(std::count(log.begin(), log.end(), '\n'), 4);
+  EXPECT_NE(log.find("GPU0: Power limit 212.5 W -> 200 W"), std::string::npos) << log;
+  EXPECT_NE(log.find("GPU0: Power limit 200 W -> 212.5 W (undone)"), std::string::npos) << log;
+  unlink(log_path.c_str());
+  rmdir((std::string(state) + "/nvtop").c_str());
+  rmdir(state);
+  unsetenv("XDG_STATE_HOME");
+}
+
+// The power profile is only applied in the manual performance level, which
+// the profile change sets and its undo restores
+TEST(DeviceTuning, PowerProfileSetsManualLevel) {
+  char sysfs[] = "/tmp/nvtopTestSysfsXXXXXX";
+  ASSERT_NE(mkdtemp(sysfs), nullptr);
+  char state[] = "/tmp/nvtopTestStateXXXXXX";
+  ASSERT_NE(mkdtemp(state), nullptr);
+  setenv("XDG_STATE_HOME", state, 1);
+  std::string dir(sysfs);
+  write_amdgpu_power_profiles(dir);
+  std::ofstream(dir + "/power_dpm_force_performance_level") << "auto\n";
+  stub_sysfs_dirfd = open(sysfs, O_RDONLY | O_DIRECTORY);
+  ASSERT_GE(stub_sysfs_dirfd, 0);
+
+  struct gpu_vendor vendor = {};
+  vendor.last_error_string = stub_last_error_string;
+  vendor.get_tuning = stub_sysfs_get_tuning;
+  vendor.set_tuning = stub_sysfs_set_tuning;
+  struct gpu_info device = {};
+  device.vendor = &vendor;
+
+  const char *error = nullptr;
+  EXPECT_TRUE(tuning_apply(&device, 0, gpuinfo_tuning_power_profile, 5, &error));
+  EXPECT_EQ(read_file(dir + "/power_dpm_force_performance_level"), "manual\n");
+  EXPECT_EQ(read_file(dir + "/pp_power_profile_mode"), "5\n");
+  EXPECT_EQ(tuning_changes_count(), 1u);
+
+  EXPECT_TRUE(tuning_undo(&error));
+  EXPECT_EQ(read_file(dir + "/pp_power_profile_mode"), "1\n");
+  EXPECT_EQ(read_file(dir + "/power_dpm_force_performance_level"), "auto\n");
+  EXPECT_EQ(tuning_changes_count(), 0u);
+  tuning_clear();
+
+  std::string log_path = std::string(state) + "/nvtop/tuning.log";
+  std::string log = read_file(log_path);
+  EXPECT_EQ(std::count(log.begin(), log.end(), '\n'), 4);
+  EXPECT_NE(log.find("GPU0: Performance level auto -> manual\n"), std::string::npos) << log;
+  EXPECT_NE(log.find("GPU0: Power profile 3D_FULL_SCREEN -> COMPUTE\n"), std::string::npos) << log;
+  EXPECT_NE(log.find("GPU0: Performance level manual -> auto (undone)"), std::string::npos) << log;
+
+  close(stub_sysfs_dirfd);
+  stub_sysfs_dirfd = -1;
+  unlink(log_path.c_str());
+  rmdir((std::string(state) + "/nvtop").c_str());
+  rmdir(state);
+  unsetenv("XDG_STATE_HOME");
+  unlink((dir + "/pp_power_profile_mode").c_str());
+  unlink((dir + "/power_dpm_force_performance_level").c_str());
+  rmdir(sysfs);
+}
+
+static const uint64_t second = UINT64_C(1000000000);
+
+TEST(Stranded, GracePeriod) {
+  struct gpuinfo_stranded stranded = {};
+  double seconds;
+  for (uint64_t t = 0; t < GPUINFO_STRANDED_GRACE_PERIOD; t += 10)
+    gpuinfo_stranded_update(&stranded, true, t * second, 1.);
+  EXPECT_FALSE(gpuinfo_stranded_duration(&stranded, &seconds));
+  EXPECT_EQ(stranded.time, 0.);
+  EXPECT_EQ(stranded.energy, 0.);
+
+  // The whole period is counted once it lasted the grace period
+  gpuinfo_stranded_update(&stranded, true, GPUINFO_STRANDED_GRACE_PERIOD * second, 1.);
+  ASSERT_TRUE(gpuinfo_stranded_duration(&stranded, &seconds));
+  EXPECT_DOUBLE_EQ(seconds, GPUINFO_STRANDED_GRACE_PERIOD);
+  EXPECT_DOUBLE_EQ(stranded.time, GPUINFO_STRANDED_GRACE_PERIOD);
+}
+
+TEST(Stranded, PausesNotCounted) {
+  struct gpuinfo_stranded stranded = {};
+  double seconds;
+  uint64_t t = 0;
+  // A workload pausing for less than the grace period between busy phases
+  for (int pause = 0; pause < 5; ++pause) {
+    gpuinfo_stranded_update(&stranded, false, t * second, 1.);
+    t += 10;
+    for (uint64_t end = t + GPUINFO_STRANDED_GRACE_PERIOD - 10; t < end; t += 10)
+      gpuinfo_stranded_update(&stranded, true, t * second, 1.);
+  }
+  EXPECT_FALSE(gpuinfo_stranded_duration(&stranded, &seconds));
+  EXPECT_EQ(stranded.time, 0.);
+  EXPECT_EQ(stranded.energy, 0.);
+
+  // A busy update restarts the idle period
+  gpuinfo_stranded_update(&stranded, false, t * second, 1.);
+  EXPECT_FALSE(stranded.idle);
+  gpuinfo_stranded_update(&stranded, true, (t + 1) * second, 1.);
+  EXPECT_EQ(stranded.since, (t + 1) * second);
+}
+
+TEST(Stranded, EnergyAccumulatedOnce) {
+  struct gpuinfo_stranded stranded = {};
+  // The energy of the first update belongs to the busy period before
+  gpuinfo_stranded_update(&stranded, true, 0, 5.);
+  for (uint64_t t = 10; t <= 2 * GPUINFO_STRANDED_GRACE_PERIOD; t += 10)
+    gpuinfo_stranded_update(&stranded, true, t * second, 1.);
+  EXPECT_DOUBLE_EQ(stranded.time, 2 * GPUINFO_STRANDED_GRACE_PERIOD);
+  EXPECT_DOUBLE_EQ(stranded.energy, 2 * GPUINFO_STRANDED_GRACE_PERIOD / 10);
+
+  // A second idle period adds to the totals without counting the first again
+  gpuinfo_stranded_update(&stranded, false, 200 * second, 1.);
+  for (uint64_t t = 200; t <= 200 + GPUINFO_STRANDED_GRACE_PERIOD; t += 10)
+    gpuinfo_stranded_update(&stranded, true, t * second, 1.);
+  EXPECT_DOUBLE_EQ(stranded.time, 3 * GPUINFO_STRANDED_GRACE_PERIOD);
+  EXPECT_DOUBLE_EQ(stranded.energy, 3 * GPUINFO_STRANDED_GRACE_PERIOD / 10);
+}
+
 #ifdef THOROUGH_TESTING
 
 TEST(InterfaceLayout, CheckManyTermSize) {
@@ -0,0 +1,109 @@
+/*
+ *
+ * Copyright (C) 2022 Maxime Schmitt <maxime.schmitt91@gmail.com>
+ *
+ * This file is part of Nvtop.
+ *
+ * Nvtop is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Nvtop is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with nvtop.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// Times compute_sizes_from_layout over the THOROUGH_TESTING parameter space.
+// An optional argument multiplies the sampling steps to get a quicker run.
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "nvtop/interface.h"
+#include "nvtop/interface_layout_selection.h"
+}
+
+namespace {
+
+struct timings {
+  unsigned long long calls = 0;
+  double solve_total = 0., solve_max = 0.;
+  double cached_total = 0., cached_max = 0.;
+};
+
+void report(const std::string &label, const timings &t) {
+  std::cout << std::setw(8) << label << std::setw(14) << t.calls << std::fixed << std::setprecision(3)
+            << std::setw(14) << t.solve_total << std::setw(12) << t.solve_total * 1e6 / t.calls << std::setw(12)
+            << t.solve_max * 1e6 << std::setw(12) << t.cached_total * 1e6 / t.calls << std::setw(12)
+            << t.cached_max * 1e6 << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  unsigned stride = 1;
+  if (argc > 1)
+    stride = std::max(1, std::atoi(argv[1]));
+
+  const std::array<unsigned, 8> dev_count_to_test = {0, 1, 2, 3, 6, 16, 32, 64};
+  const std::map<unsigned, unsigned> extra_increment = {{0, 0}, {1, 0}, {2, 0}, {3, 0}, {6, 4}, {16, 6}, {32, 8}, {64, 17}};
+
+  std::cout << std::setw(8) << "devices" << std::setw(14) << "calls" << std::setw(14) << "solve (s)" << std::setw(12)
+            << "mean (us)" << std::setw(12) << "max (us)" << std::setw(12) << "hit (us)" << std::setw(12)
+            << "hit max" << std::endl;
+
+  timings all;
+  for (unsigned dev_count : dev_count_to_test) {
+    std::vector<plot_info_to_draw> plot_display(dev_count, plot_default_draw_info());
+    process_field_displayed proc_display = process_default_displayed_field();
+    std::vector<struct window_position> dev_positions(dev_count);
+    std::vector<struct window_position> plot_positions(MAX_CHARTS);
+    std::vector<unsigned> map_dev_to_plot(dev_count);
+    struct window_position process_position, setup_position;
+    unsigned num_plots;
+
+    unsigned increment = (1 + extra_increment.at(dev_count)) * stride;
+    timings t;
+    for (unsigned screen_rows = 1; screen_rows < 2048; screen_rows += increment) {
+      for (unsigned screen_cols = 1; screen_cols < 2048; screen_cols += increment) {
+        for (unsigned header_cols = 55; header_cols < 120; header_cols += increment) {
+          // The first call solves the layout, the second one is served from the cache
+          for (unsigned pass = 0; pass < 2; ++pass) {
+            auto start = std::chrono::steady_clock::now();
+            compute_sizes_from_layout(dev_count, 3, header_cols, screen_rows, screen_cols, plot_display.data(),
+                                      proc_display, dev_positions.data(), &num_plots, plot_positions.data(),
+                                      map_dev_to_plot.data(), &process_position, &setup_position);
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double &total = pass ? t.cached_total : t.solve_total;
+            double &max = pass ? t.cached_max : t.solve_max;
+            total += elapsed;
+            max = std::max(max, elapsed);
+          }
+          t.calls++;
+        }
+      }
+    }
+    report(std::to_string(dev_count), t);
+    all.calls += t.calls;
+    all.solve_total += t.solve_total;
+    all.solve_max = std::max(all.solve_max, t.solve_max);
+    all.cached_total += t.cached_total;
+    all.cached_max = std::max(all.cached_max, t.cached_max);
+  }
+  report("all", all);
+  layout_selection_clear_cache();
+  return EXIT_SUCCESS;
+}